@@ -32,7 +32,9 @@
 * limits memory fragmentation.
 *
 * This implementation is based on heap_4.c and add the function pvPortRealloc()
-* to the original implementation.
+* to the original implementation, as well as statistics (see vPortGetHeapStats()
+* and vPortGetHeapSizeClasses()) and an optional allocation trace (see
+* xPortGetHeapTrace()).
 *
 * See heap_1.c, heap_2.c and heap_3.c for alternative implementations, and the
 * memory management pages of http://www.FreeRTOS.org for more information.
@@ -60,6 +62,16 @@ task.h is included from an application file. */
 /* Assumes 8bit bytes! */
 #define heapBITS_PER_BYTE		( ( size_t ) 8 )
 
+/* Size of the blocks of the first size class, header included. */
+#define heapFIRST_SIZE_CLASS	( ( size_t ) 16 )
+
+#ifndef HEAP_TRACE_ENABLED
+ #define HEAP_TRACE_ENABLED 0
+#endif
+
+/* Number of records held by the allocation trace ring buffer. */
+#define heapTRACE_LENGTH		( 256U )
+
 /* Define the linked list structure.  This is used to link free blocks in order
 of their memory address. */
 typedef struct A_BLOCK_LINK
@@ -84,6 +96,17 @@ static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert );
 */
 static void prvHeapInit( void );
 
+/*
+* Index of the size class of a block, in xSizeClasses.
+*/
+static size_t prvSizeClass( size_t xBlockSize );
+
+/*
+* Appends a record to the allocation trace, if it is enabled. Called with the
+* scheduler suspended.
+*/
+static void prvTrace( uint8_t ucOperation, const BlockLink_t *pxBlock, size_t xBlockSize, void *pvCaller );
+
 /*-----------------------------------------------------------*/
 
 /* The size of the structure placed at the beginning of each allocated memory
@@ -106,12 +129,29 @@ static size_t xBlockAllocatedBit = 0;
 
 static size_t xHeapSize = 0;
 
+/* Start of the aligned heap, the offsets of the trace records are relative to
+it. */
+static uint8_t *pucHeapStart = NULL;
+
+/* Counters reported by vPortGetHeapStats() and vPortGetHeapSizeClasses(). */
+static size_t xNumberOfSuccessfulAllocations = 0U;
+static size_t xNumberOfSuccessfulFrees = 0U;
+static size_t xNumberOfFailedAllocations = 0U;
+static HeapSizeClass_t xSizeClasses[ portHEAP_SIZE_CLASSES ];
+
+#if( HEAP_TRACE_ENABLED == 1 )
+ static HeapTraceRecord_t xTraceRecords[ heapTRACE_LENGTH ];
+ /* Sequence number of the next record, the number of records since boot. */
+ static uint32_t ulTraceNextSequence = 0U;
+#endif
+
 /*-----------------------------------------------------------*/
 
 void *pvPortMalloc( size_t xWantedSize )
 {
  BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
  void *pvReturn = NULL;
+ void *pvCaller = __builtin_return_address( 0 );
 
  vTaskSuspendAll();
  {
@@ -222,6 +262,11 @@ void *pvPortMalloc( size_t xWantedSize )
            mtCOVERAGE_TEST_MARKER();
          }
 
+         xNumberOfSuccessfulAllocations++;
+         xSizeClasses[ prvSizeClass( pxBlock->xBlockSize ) ].ulAllocations++;
+         xSizeClasses[ prvSizeClass( pxBlock->xBlockSize ) ].ulLiveBlocks++;
+         prvTrace( portHEAP_TRACE_ALLOC, pxBlock, pxBlock->xBlockSize, pvCaller );
+
          /* The block is being returned - it is allocated and owned
          by the application and has no "next" block. */
          pxBlock->xBlockSize |= xBlockAllocatedBit;
@@ -242,6 +287,17 @@ void *pvPortMalloc( size_t xWantedSize )
      mtCOVERAGE_TEST_MARKER();
    }
 
+   if( ( pvReturn == NULL ) && ( xWantedSize > 0 ) )
+   {
+     xNumberOfFailedAllocations++;
+     xSizeClasses[ prvSizeClass( xWantedSize ) ].ulFailures++;
+     prvTrace( portHEAP_TRACE_FAILED, NULL, xWantedSize, pvCaller );
+   }
+   else
+   {
+     mtCOVERAGE_TEST_MARKER();
+   }
+
    traceMALLOC( pvReturn, xWantedSize );
  }
  ( void ) xTaskResumeAll();
@@ -269,6 +325,7 @@ void vPortFree( void *pv )
 {
  uint8_t *puc = ( uint8_t * ) pv;
  BlockLink_t *pxLink;
+ void *pvCaller = __builtin_return_address( 0 );
 
  if( pv != NULL )
  {
@@ -295,6 +352,9 @@ void vPortFree( void *pv )
        {
          /* Add this block to the list of free blocks. */
          xFreeBytesRemaining += pxLink->xBlockSize;
+         xNumberOfSuccessfulFrees++;
+         xSizeClasses[ prvSizeClass( pxLink->xBlockSize ) ].ulLiveBlocks--;
+         prvTrace( portHEAP_TRACE_FREE, pxLink, pxLink->xBlockSize, pvCaller );
          traceFREE( pv, pxLink->xBlockSize );
          prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
        }
@@ -331,6 +391,97 @@ size_t xPortGetHeapSize( void )
 }
 /*-----------------------------------------------------------*/
 
+void vPortGetHeapStats( HeapStats_t *pxHeapStats )
+{
+ BlockLink_t *pxBlock;
+ size_t xBlocks = 0, xMaxSize = 0, xMinSize = ~( ( size_t ) 0 );
+
+ vTaskSuspendAll();
+ {
+   pxBlock = xStart.pxNextFreeBlock;
+
+   /* pxBlock will be NULL if the heap has not been initialised. */
+   if( pxBlock != NULL )
+   {
+     while( pxBlock != pxEnd )
+     {
+       xBlocks++;
+
+       if( pxBlock->xBlockSize > xMaxSize )
+       {
+         xMaxSize = pxBlock->xBlockSize;
+       }
+
+       if( pxBlock->xBlockSize < xMinSize )
+       {
+         xMinSize = pxBlock->xBlockSize;
+       }
+
+       pxBlock = pxBlock->pxNextFreeBlock;
+     }
+   }
+
+   pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+   pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+   pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+   pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+   pxHeapStats->xNumberOfFailedAllocations = xNumberOfFailedAllocations;
+ }
+ ( void ) xTaskResumeAll();
+
+ pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+ pxHeapStats->xSizeOfSmallestFreeBlockInBytes = ( xBlocks > 0 ) ? xMinSize : 0;
+ pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapSizeClasses( HeapSizeClass_t pxSizeClasses[ portHEAP_SIZE_CLASSES ] )
+{
+ vTaskSuspendAll();
+ {
+   memcpy( pxSizeClasses, xSizeClasses, sizeof( xSizeClasses ) );
+ }
+ ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetHeapTrace( uint32_t ulFirstSequence,
+                          HeapTraceRecord_t *pxRecords,
+                          size_t xMaxRecords,
+                          uint32_t *pulFirstSequence,
+                          uint32_t *pulNextSequence )
+{
+ size_t xCount = 0;
+
+#if( HEAP_TRACE_ENABLED == 1 )
+ vTaskSuspendAll();
+ {
+   /* The oldest records have been overwritten. */
+   if( ( ulTraceNextSequence > heapTRACE_LENGTH ) && ( ulFirstSequence < ulTraceNextSequence - heapTRACE_LENGTH ) )
+   {
+     ulFirstSequence = ulTraceNextSequence - heapTRACE_LENGTH;
+   }
+
+   while( ( ulFirstSequence + xCount < ulTraceNextSequence ) && ( xCount < xMaxRecords ) )
+   {
+     pxRecords[ xCount ] = xTraceRecords[ ( ulFirstSequence + xCount ) % heapTRACE_LENGTH ];
+     xCount++;
+   }
+
+   *pulNextSequence = ulTraceNextSequence;
+ }
+ ( void ) xTaskResumeAll();
+#else
+ ( void ) pxRecords;
+ ( void ) xMaxRecords;
+ *pulNextSequence = 0U;
+#endif
+
+ *pulFirstSequence = ulFirstSequence;
+ return xCount;
+}
+/*-----------------------------------------------------------*/
+
 void vPortInitialiseBlocks( void )
 {
  /* This just exists to keep the linker quiet. */
@@ -360,6 +511,7 @@ static void prvHeapInit( void )
  }
 
  pucAlignedHeap = ( uint8_t * ) uxAddress;
+ pucHeapStart = pucAlignedHeap;
 
  /* xStart is used to hold a pointer to the first item in the list of free
  blocks.  The void cast is used to prevent compiler warnings. */
@@ -390,6 +542,48 @@ static void prvHeapInit( void )
 }
 /*-----------------------------------------------------------*/
 
+static size_t prvSizeClass( size_t xBlockSize )
+{
+ size_t xClass = 0;
+ size_t xClassSize = heapFIRST_SIZE_CLASS;
+
+ while( ( xBlockSize > xClassSize ) && ( xClass < ( portHEAP_SIZE_CLASSES - 1 ) ) )
+ {
+   xClassSize <<= 1;
+   xClass++;
+ }
+
+ return xClass;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTrace( uint8_t ucOperation, const BlockLink_t *pxBlock, size_t xBlockSize, void *pvCaller )
+{
+#if( HEAP_TRACE_ENABLED == 1 )
+ HeapTraceRecord_t *pxRecord = &xTraceRecords[ ulTraceNextSequence % heapTRACE_LENGTH ];
+ const char *pcTask = "";
+
+ /* pxCurrentTCB is not valid until the scheduler starts. */
+ if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED )
+ {
+   pcTask = pcTaskGetName( NULL );
+ }
+
+ pxRecord->ulCaller = ( uint32_t ) ( uintptr_t ) pvCaller;
+ pxRecord->usOffset = ( pxBlock != NULL ) ? ( uint16_t ) ( ( const uint8_t * ) pxBlock - pucHeapStart ) : 0xffffU;
+ pxRecord->usSize = ( xBlockSize < 0xffffU ) ? ( uint16_t ) xBlockSize : 0xffffU;
+ strncpy( pxRecord->pcTask, pcTask, sizeof( pxRecord->pcTask ) );
+ pxRecord->ucOperation = ucOperation;
+ ulTraceNextSequence++;
+#else
+ ( void ) ucOperation;
+ ( void ) pxBlock;
+ ( void ) xBlockSize;
+ ( void ) pvCaller;
+#endif
+}
+/*-----------------------------------------------------------*/
+
 static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert )
 {
  BlockLink_t *pxIterator;
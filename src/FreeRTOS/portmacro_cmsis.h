@@ -182,6 +182,55 @@ __STATIC_INLINE uint32_t ulPortRaiseBASEPRI( void )
 
 size_t xPortGetHeapSize(void);
 
+/* Heap statistics of heap_4_infinitime.c */
+#define portHEAP_SIZE_CLASSES 10
+
+typedef struct xHEAP_STATS
+{
+    size_t xAvailableHeapSpaceInBytes;
+    size_t xSizeOfLargestFreeBlockInBytes;
+    size_t xSizeOfSmallestFreeBlockInBytes;
+    size_t xNumberOfFreeBlocks;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+    size_t xNumberOfFailedAllocations;
+} HeapStats_t;
+
+/* Blocks of class 0 are up to 16 bytes long, header included, each class doubles the size of the previous one.
+ * The last class holds all the larger blocks. */
+typedef struct xHEAP_SIZE_CLASS
+{
+    uint32_t ulAllocations;
+    uint32_t ulFailures;
+    uint32_t ulLiveBlocks;
+} HeapSizeClass_t;
+
+void vPortGetHeapStats(HeapStats_t *pxHeapStats);
+void vPortGetHeapSizeClasses(HeapSizeClass_t pxSizeClasses[portHEAP_SIZE_CLASSES]);
+
+/* Allocation trace, only recorded when HEAP_TRACE_ENABLED is set (cmake -DENABLE_HEAP_TRACE=1) */
+#define portHEAP_TRACE_ALLOC  0
+#define portHEAP_TRACE_FREE   1
+#define portHEAP_TRACE_FAILED 2
+
+typedef struct __attribute__((packed)) xHEAP_TRACE_RECORD
+{
+    uint32_t ulCaller;  /* Return address of the call to pvPortMalloc() or vPortFree() */
+    uint16_t usOffset;  /* Offset of the block in the heap, 0xffff for failed allocations */
+    uint16_t usSize;    /* Size of the block, header included */
+    char pcTask[3];     /* Name of the calling task, empty before the scheduler starts */
+    uint8_t ucOperation;
+} HeapTraceRecord_t;
+
+/* Copies the records from sequence number ulFirstSequence (or the oldest one still held) and returns their number.
+ * Returns the sequence number of the first record copied and the number of records since boot. */
+size_t xPortGetHeapTrace(uint32_t ulFirstSequence,
+                         HeapTraceRecord_t *pxRecords,
+                         size_t xMaxRecords,
+                         uint32_t *pulFirstSequence,
+                         uint32_t *pulNextSequence);
+
 #ifdef __cplusplus
 }
 #endif
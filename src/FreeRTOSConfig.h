@@ -74,7 +74,7 @@
 #define configUSE_TIME_SLICING                  0
 #define configUSE_NEWLIB_REENTRANT              0
 #define configENABLE_BACKWARD_COMPATIBILITY     0
-#define configUSE_TASK_NOTIFICATIONS            0
+#define configUSE_TASK_NOTIFICATIONS            1
 
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK            0
@@ -83,7 +83,7 @@
 #define configUSE_MALLOC_FAILED_HOOK   1
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS        0
+#define configGENERATE_RUN_TIME_STATS        1
 #define configUSE_TRACE_FACILITY             1
 #define configUSE_STATS_FORMATTING_FUNCTIONS 0
 
@@ -185,6 +185,19 @@ standard names - or at least those used in the unmodified vector table. */
     #include <stdint.h>
 extern uint32_t SystemCoreClock;
   #endif
+
+  /* The run time stats count the CPU cycles with the DWT cycle counter. It stops while the CPU sleeps, so that the run time of
+   * a task is the time it kept the CPU awake. Read by SystemMonitor, which samples it before it wraps. */
+  #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()                                                                                   \
+    do {                                                                                                                           \
+      CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;                                                                              \
+      DWT->CYCCNT = 0;                                                                                                             \
+      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;                                                                                         \
+    } while (0)
+  #define portGET_RUN_TIME_COUNTER_VALUE() (DWT->CYCCNT)
+
+  /* Counts the context switches of every task in its application defined task number (uxTaskGetTaskNumber()) */
+  #define traceTASK_SWITCHED_IN() (pxCurrentTCB->uxTaskNumber++)
 #endif /* !assembler */
 
 /** Implementation note:  Use this with caution and set this to 1 ONLY for debugging
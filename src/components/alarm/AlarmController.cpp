@@ -48,7 +48,11 @@ void AlarmController::Init(System::SystemTask* systemTask) {
 void AlarmController::SaveAlarm() {
   // verify if it is necessary to save
   if (alarmChanged) {
-    SaveSettingsToFile();
+    // Written by the system task, so that the caller doesn't wait for the flash
+    taskENTER_CRITICAL();
+    savedAlarm = alarm;
+    taskEXIT_CRITICAL();
+    systemTask->QueueSave(System::Messages::SaveAlarm);
   }
   alarmChanged = false;
 }
@@ -164,6 +168,11 @@ void AlarmController::LoadSettingsFromFile() {
 }
 
 void AlarmController::SaveSettingsToFile() const {
+  // SaveAlarm() may be called again while the file is being written
+  taskENTER_CRITICAL();
+  AlarmSettings data = savedAlarm;
+  taskEXIT_CRITICAL();
+
   lfs_dir systemDir;
   if (fs.DirOpen("/.system", &systemDir) != LFS_ERR_OK) {
     fs.DirCreate("/.system");
@@ -175,7 +184,7 @@ void AlarmController::SaveSettingsToFile() const {
     return;
   }
 
-  fs.FileWrite(&alarmFile, reinterpret_cast<const uint8_t*>(&alarm), sizeof(alarm));
+  fs.FileWrite(&alarmFile, reinterpret_cast<const uint8_t*>(&data), sizeof(data));
   fs.FileClose(&alarmFile);
-  NRF_LOG_INFO("[AlarmController] Saved alarm settings with format version %u to file", alarm.version);
+  NRF_LOG_INFO("[AlarmController] Saved alarm settings with format version %u to file", data.version);
 }
@@ -33,7 +33,10 @@ namespace Pinetime {
       AlarmController(Controllers::DateTime& dateTimeController, Controllers::FS& fs);
 
       void Init(System::SystemTask* systemTask);
+      // The file is written by the system task, so that the caller doesn't wait for the flash
       void SaveAlarm();
+      // Called by the system task
+      void SaveSettingsToFile() const;
       void SetAlarmTime(uint8_t alarmHr, uint8_t alarmMin);
       void ScheduleAlarm();
       void DisableAlarm();
@@ -85,10 +88,11 @@ namespace Pinetime {
       System::SystemTask* systemTask = nullptr;
       TimerHandle_t alarmTimer;
       AlarmSettings alarm;
+      // Copied by SaveAlarm() and read by the system task, in critical sections
+      AlarmSettings savedAlarm;
       std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds> alarmTime;
 
       void LoadSettingsFromFile();
-      void SaveSettingsToFile() const;
     };
   }
 }
@@ -2,13 +2,14 @@
 #include <cstdint>
 #include <drivers/include/nrfx_saadc.h>
 #include <systemtask/SystemTask.h>
+#include "components/changes/ChangeNotifier.h"
 
 namespace Pinetime {
   namespace Controllers {
 
     class Battery {
     public:
-      Battery();
+      explicit Battery(ChangeNotifier& changeNotifier);
 
       void ReadPowerState();
       void MeasureVoltage();
@@ -34,6 +35,7 @@ namespace Pinetime {
 
     private:
       static Battery* instance;
+      ChangeNotifier& changeNotifier;
       nrf_saadc_value_t saadc_value;
 
       static constexpr nrf_saadc_input_t batteryVoltageAdcInput = NRF_SAADC_INPUT_AIN7;
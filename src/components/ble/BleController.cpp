@@ -8,10 +8,12 @@ bool Ble::IsConnected() const {
 
 void Ble::Connect() {
   isConnected = true;
+  changeNotifier.Publish(ChangeNotifier::Topic::Ble);
 }
 
 void Ble::Disconnect() {
   isConnected = false;
+  changeNotifier.Publish(ChangeNotifier::Topic::Ble);
 }
 
 bool Ble::IsRadioEnabled() const {
@@ -20,10 +22,12 @@ bool Ble::IsRadioEnabled() const {
 
 void Ble::EnableRadio() {
   isRadioEnabled = true;
+  changeNotifier.Publish(ChangeNotifier::Topic::Ble);
 }
 
 void Ble::DisableRadio() {
   isRadioEnabled = false;
+  changeNotifier.Publish(ChangeNotifier::Topic::Ble);
 }
 
 void Ble::StartFirmwareUpdate() {
@@ -1,4 +1,5 @@
 #include "components/ble/DfuService.h"
+#include <algorithm>
 #include <cstring>
 #include "components/ble/BleController.h"
 #include "components/ble/NotificationManager.h"
@@ -145,8 +146,6 @@ int DfuService::WritePacketHandler(uint16_t connectionHandle, os_mbuf* om) {
         vTaskDelay(pdMS_TO_TICKS(5));
       }
 
-      dfuImage.Erase();
-
       uint8_t data[] {16, 1, 1};
       notificationManager.Send(connectionHandle, controlPointCharacteristicHandle, data, 3);
       state = States::Init;
@@ -367,7 +366,8 @@ void DfuService::NotificationManager::Reset() {
 }
 
 void DfuService::DfuImage::Init(size_t chunkSize, size_t totalSize, uint16_t expectedCrc) {
-  if (chunkSize != 20)
+  // The image must not overflow into the file system
+  if (chunkSize != 20 || totalSize > maxSize)
     return;
   this->chunkSize = chunkSize;
   this->totalSize = totalSize;
@@ -375,30 +375,71 @@ void DfuService::DfuImage::Init(size_t chunkSize, size_t totalSize, uint16_t exp
   this->ready = true;
   totalWriteIndex = 0;
   bufferWriteIndex = 0;
+  erasedSize = 0;
+  crc = Pinetime::Tools::Crc16::initialValue;
+  hasFlashFailed = false;
 }
 
-void DfuService::DfuImage::Append(uint8_t* data, size_t size) {
+void DfuService::DfuImage::Append(const uint8_t* data, size_t size) {
   if (!ready)
     return;
-  ASSERT(size <= 20);
 
-  std::memcpy(tempBuffer + bufferWriteIndex, data, size);
-  bufferWriteIndex += size;
+  size = std::min(size, totalSize - totalWriteIndex - bufferWriteIndex);
+  crc = Pinetime::Tools::Crc16::Update(crc, data, size);
+
+  while (size > 0) {
+    size_t length = std::min(size, bufferSize - bufferWriteIndex);
+    std::memcpy(tempBuffer + bufferWriteIndex, data, length);
+    bufferWriteIndex += length;
+    data += length;
+    size -= length;
 
-  if (bufferWriteIndex == bufferSize) {
-    spiNorFlash.Write(writeOffset + totalWriteIndex, tempBuffer, bufferWriteIndex);
-    totalWriteIndex += bufferWriteIndex;
-    bufferWriteIndex = 0;
+    if (bufferWriteIndex == bufferSize || totalWriteIndex + bufferWriteIndex == totalSize) {
+      Flush();
+    }
   }
 
-  if (bufferWriteIndex > 0 && totalWriteIndex + bufferWriteIndex == totalSize) {
-    spiNorFlash.Write(writeOffset + totalWriteIndex, tempBuffer, bufferWriteIndex);
-    totalWriteIndex += bufferWriteIndex;
+  if (totalWriteIndex == totalSize && erasedSize < maxSize) {
+    // The rest of the slot is erased as it used to be before the transfer, the magic number is written in the last sector
+    EraseUpTo(maxSize);
     if (totalSize < maxSize)
       WriteMagicNumber();
   }
 }
 
+void DfuService::DfuImage::Flush() {
+  EraseUpTo(totalWriteIndex + bufferWriteIndex);
+  // Page aligned, a single program operation
+  spiNorFlash.Write(writeOffset + totalWriteIndex, tempBuffer, bufferWriteIndex);
+  hasFlashFailed = hasFlashFailed || spiNorFlash.ProgramFailed();
+  totalWriteIndex += bufferWriteIndex;
+  bufferWriteIndex = 0;
+}
+
+void DfuService::DfuImage::EraseUpTo(size_t offset) {
+  while (erasedSize < offset) {
+    if (!IsErased(writeOffset + erasedSize)) {
+      spiNorFlash.SectorErase(writeOffset + erasedSize);
+      hasFlashFailed = hasFlashFailed || spiNorFlash.EraseFailed();
+    }
+    erasedSize += sectorSize;
+  }
+}
+
+bool DfuService::DfuImage::IsErased(uint32_t address) {
+  // Much faster than an erase: a sector that holds data is usually detected in its first bytes
+  uint8_t buffer[64];
+  for (size_t offset = 0; offset < sectorSize; offset += sizeof(buffer)) {
+    spiNorFlash.Read(address + offset, buffer, sizeof(buffer));
+    for (uint8_t byte : buffer) {
+      if (byte != 0xff) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 void DfuService::DfuImage::WriteMagicNumber() {
   uint32_t magic[4] = {
     // TODO When this variable is a static constexpr, the values written to the memory are not correct. Why?
@@ -412,45 +453,9 @@ void DfuService::DfuImage::WriteMagicNumber() {
   spiNorFlash.Write(offset, reinterpret_cast<const uint8_t*>(magic), 4 * sizeof(uint32_t));
 }
 
-void DfuService::DfuImage::Erase() {
-  for (size_t erased = 0; erased < maxSize; erased += 0x1000) {
-    spiNorFlash.SectorErase(writeOffset + erased);
-  }
-}
-
 bool DfuService::DfuImage::Validate() {
-  uint32_t chunkSize = 200;
-  size_t currentOffset = 0;
-  uint16_t crc = 0;
-
-  bool first = true;
-  while (currentOffset < totalSize) {
-    uint32_t readSize = (totalSize - currentOffset) > chunkSize ? chunkSize : (totalSize - currentOffset);
-
-    spiNorFlash.Read(writeOffset + currentOffset, tempBuffer, readSize);
-    if (first) {
-      crc = ComputeCrc(tempBuffer, readSize, NULL);
-      first = false;
-    } else
-      crc = ComputeCrc(tempBuffer, readSize, &crc);
-    currentOffset += readSize;
-  }
-
-  return (crc == expectedCrc);
-}
-
-uint16_t DfuService::DfuImage::ComputeCrc(uint8_t const* p_data, uint32_t size, uint16_t const* p_crc) {
-  uint16_t crc = (p_crc == NULL) ? 0xFFFF : *p_crc;
-
-  for (uint32_t i = 0; i < size; i++) {
-    crc = static_cast<uint8_t>(crc >> 8) | (crc << 8);
-    crc ^= p_data[i];
-    crc ^= static_cast<uint8_t>(crc & 0xFF) >> 4;
-    crc ^= (crc << 8) << 4;
-    crc ^= ((crc & 0xFF) << 4) << 1;
-  }
-
-  return crc;
+  // The CRC was computed while the image was received, the flash reported every program and erase operation as successful
+  return IsComplete() && !hasFlashFailed && crc == expectedCrc;
 }
 
 bool DfuService::DfuImage::IsComplete() {
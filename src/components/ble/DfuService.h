@@ -9,6 +9,8 @@
 #undef max
 #undef min
 
+#include "components/crc/Crc.h"
+
 namespace Pinetime {
   namespace System {
     class SystemTask;
@@ -57,26 +59,33 @@ namespace Pinetime {
         }
 
         void Init(size_t chunkSize, size_t totalSize, uint16_t expectedCrc);
-        void Erase();
-        void Append(uint8_t* data, size_t size);
+        void Append(const uint8_t* data, size_t size);
         bool Validate();
         bool IsComplete();
 
       private:
         Pinetime::Drivers::SpiNorFlash& spiNorFlash;
-        static constexpr size_t bufferSize = 200;
+        // The data is written one page of the SPI flash at a time, the sectors are erased when the first page of them is
+        // written, and the CRC is computed as the data is received
+        static constexpr size_t bufferSize = 256;
+        static constexpr size_t sectorSize = 0x1000;
         bool ready = false;
         size_t chunkSize = 0;
         size_t totalSize = 0;
         size_t maxSize = 475136;
         size_t bufferWriteIndex = 0;
         size_t totalWriteIndex = 0;
+        size_t erasedSize = 0;
         static constexpr size_t writeOffset = 0x40000;
         uint8_t tempBuffer[bufferSize];
         uint16_t expectedCrc = 0;
+        uint16_t crc = Pinetime::Tools::Crc16::initialValue;
+        bool hasFlashFailed = false;
 
+        void Flush();
+        void EraseUpTo(size_t offset);
+        bool IsErased(uint32_t address);
         void WriteMagicNumber();
-        uint16_t ComputeCrc(uint8_t const* p_data, uint32_t size, uint16_t const* p_crc);
       };
 
       static constexpr ble_uuid128_t serviceUuid {
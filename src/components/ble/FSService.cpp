@@ -1,4 +1,5 @@
 #include <nrf_log.h>
+#include <algorithm>
 #include "FSService.h"
 #include "components/ble/BleController.h"
 #include "components/ble/NotificationManager.h"
@@ -19,6 +20,7 @@ int FSServiceCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gat
 FSService::FSService(Pinetime::System::SystemTask& systemTask, Pinetime::Controllers::FS& fs)
   : systemTask {systemTask},
     fs {fs},
+    resourceInstaller {fs},
     characteristicDefinition {{.uuid = &fsVersionUuid.u,
                                .access_cb = FSServiceCallback,
                                .arg = this,
@@ -28,7 +30,7 @@ FSService::FSService(Pinetime::System::SystemTask& systemTask, Pinetime::Control
                                 .uuid = &fsTransferUuid.u,
                                 .access_cb = FSServiceCallback,
                                 .arg = this,
-                                .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
+                                .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP | BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
                                 .val_handle = &transferCharacteristicHandle,
                               },
                               {0}},
@@ -74,8 +76,24 @@ int FSService::OnFSServiceRequested(uint16_t connectionHandle, uint16_t attribut
   return 0;
 }
 
+void FSService::Reset() {
+  if (state != FSState::IDLE) {
+    EndStream();
+  }
+}
+
 int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
   auto command = static_cast<commands>(om->om_data[0]);
+  // The packets of a stream don't wait for the system to wake up, it stays awake until the end of the stream
+  if (command == commands::READ_STREAM_ACK) {
+    OnReadStreamAck(om);
+    return 0;
+  }
+  if (command == commands::WRITE_STREAM_DATA) {
+    OnWriteStreamData(om);
+    return 0;
+  }
+
   NRF_LOG_INFO("[FS_S] -> FSCommandHandler Command %d", command);
   // Just always make sure we are awake...
   systemTask.PushMessage(Pinetime::System::Messages::StartFileTransfer);
@@ -86,6 +104,10 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
   lfs_dir_t dir = {0};
   lfs_info info = {0};
   lfs_file f = {0};
+  // Any other command stops the current stream
+  if (state != FSState::IDLE) {
+    EndStream();
+  }
   switch (command) {
     case commands::READ: {
       NRF_LOG_INFO("[FS_S] -> Read");
@@ -108,14 +130,13 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
         resp.totallen = 0;
         om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
       } else {
-        resp.chunklen = std::min(header->chunksize, info.size); // TODO add mtu somehow
+        resp.chunklen = std::min({header->chunksize, info.size, MaxChunkSize(connectionHandle)});
         resp.totallen = info.size;
         fs.FileOpen(&f, filepath, LFS_O_RDONLY);
         fs.FileSeek(&f, header->chunkoff);
-        uint8_t fileData[resp.chunklen] = {0};
-        resp.chunklen = fs.FileRead(&f, fileData, resp.chunklen);
+        resp.chunklen = fs.FileRead(&f, transferBuffer.data(), resp.chunklen);
         om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
-        os_mbuf_append(om, fileData, resp.chunklen);
+        os_mbuf_append(om, transferBuffer.data(), resp.chunklen);
         fs.FileClose(&f);
       }
 
@@ -135,17 +156,16 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
         resp.chunklen = 0;
         resp.totallen = 0;
       } else {
-        resp.chunklen = std::min(header->chunksize, info.size); // TODO add mtu somehow
+        resp.chunklen = std::min({header->chunksize, info.size, MaxChunkSize(connectionHandle)});
         resp.totallen = info.size;
         fs.FileOpen(&f, filepath, LFS_O_RDONLY);
         fs.FileSeek(&f, header->chunkoff);
       }
       os_mbuf* om;
       if (resp.chunklen > 0) {
-        uint8_t fileData[resp.chunklen] = {0};
-        resp.chunklen = fs.FileRead(&f, fileData, resp.chunklen);
+        resp.chunklen = fs.FileRead(&f, transferBuffer.data(), resp.chunklen);
         om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
-        os_mbuf_append(om, fileData, resp.chunklen);
+        os_mbuf_append(om, transferBuffer.data(), resp.chunklen);
       } else {
         resp.chunklen = 0;
         om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
@@ -154,6 +174,21 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
       break;
     }
+    case commands::READ_STREAM: {
+      NRF_LOG_INFO("[FS_S] -> ReadStream");
+      StartReadStream(connectionHandle, om);
+      break;
+    }
+    case commands::WRITE_STREAM: {
+      NRF_LOG_INFO("[FS_S] -> WriteStream");
+      StartWriteStream(connectionHandle, om);
+      break;
+    }
+    case commands::INSTALL: {
+      NRF_LOG_INFO("[FS_S] -> Install");
+      StartInstall(connectionHandle, om);
+      break;
+    }
     case commands::WRITE: {
       NRF_LOG_INFO("[FS_S] -> Write");
       auto* header = (WriteHeader*) om->om_data;
@@ -174,7 +209,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
         fs.FileClose(&f);
         resp.status = (res == 0) ? 0x01 : (int8_t) res;
       }
-      resp.freespace = std::min(fs.getSize() - (fs.GetFSSize() * fs.getBlockSize()), fileSize - header->offset);
+      resp.freespace = RemainingSpace(header->offset);
       auto* om = ble_hs_mbuf_from_flat(&resp, sizeof(WriteResponse));
       ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
       break;
@@ -196,7 +231,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       if (res < 0) {
         resp.status = (int8_t) res;
       }
-      resp.freespace = std::min(fs.getSize() - (fs.GetFSSize() * fs.getBlockSize()), fileSize - header->offset);
+      resp.freespace = RemainingSpace(header->offset);
       auto* om = ble_hs_mbuf_from_flat(&resp, sizeof(WriteResponse));
       ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, om);
       break;
@@ -342,3 +377,247 @@ void FSService::prepareReadDataResp(ReadHeader* header, ReadResponse* resp) {
     fs.FileClose(&f);
   }
 }
+
+uint32_t FSService::MaxChunkSize(uint16_t connectionHandle) const {
+  uint16_t mtu = ble_att_mtu(connectionHandle);
+  if (mtu < BLE_ATT_MTU_DFLT) {
+    mtu = BLE_ATT_MTU_DFLT;
+  }
+  // 3 bytes of ATT header
+  return std::min<uint32_t>(mtu - 3, maxPacketSize) - sizeof(ReadResponse);
+}
+
+uint32_t FSService::RemainingSpace(uint32_t offset) {
+  return std::min<uint32_t>(fs.getSize() - (fs.GetFSSize() * fs.getBlockSize()), fileSize - offset);
+}
+
+bool FSService::CopyPath(const char* path, uint16_t length) {
+  if (length >= maxpathlen) {
+    return false;
+  }
+  memcpy(filepath, path, length);
+  filepath[length] = 0;
+  return true;
+}
+
+void FSService::StartReadStream(uint16_t connectionHandle, os_mbuf* om) {
+  auto* header = (ReadStreamHeader*) om->om_data;
+  ReadResponse resp {};
+  resp.command = commands::READ_DATA;
+  resp.status = 0x01;
+  resp.chunkoff = header->chunkoff;
+
+  lfs_info info = {};
+  int res = CopyPath(header->pathstr, header->pathlen) ? fs.Stat(filepath, &info) : LFS_ERR_NAMETOOLONG;
+  if (res >= 0 && info.type == LFS_TYPE_DIR) {
+    res = LFS_ERR_ISDIR;
+  }
+  uint32_t offset = std::min(header->chunkoff, info.size);
+  // Nothing to stream from the end of the file, a single empty chunk is sent
+  if (res >= 0 && offset < info.size && (res = fs.FileOpen(&streamFile, filepath, LFS_O_RDONLY)) >= 0 &&
+      (res = fs.FileSeek(&streamFile, offset)) < 0) {
+    fs.FileClose(&streamFile);
+  }
+  if (res < 0 || offset == info.size) {
+    resp.status = (res < 0) ? (int8_t) res : 0x01;
+    resp.totallen = info.size;
+    ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse)));
+    return;
+  }
+
+  state = FSState::READ;
+  streamConnectionHandle = connectionHandle;
+  streamFileSize = info.size;
+  streamOffset = offset;
+  streamAcknowledged = offset;
+  streamEnd = (header->length == 0 || header->length > info.size - offset) ? info.size : offset + header->length;
+  streamWindow = std::max<uint8_t>(header->window, 1);
+  // Released by EndStream()
+  systemTask.PushMessage(Pinetime::System::Messages::StartFileTransfer);
+  SendReadStream();
+}
+
+// Sends READ_DATA notifications until the window is full
+void FSService::SendReadStream() {
+  uint32_t chunkSize = MaxChunkSize(streamConnectionHandle);
+  while (streamOffset < streamEnd && streamOffset - streamAcknowledged < streamWindow * chunkSize) {
+    ReadResponse resp {};
+    resp.command = commands::READ_DATA;
+    resp.status = 0x01;
+    resp.chunkoff = streamOffset;
+    resp.totallen = streamFileSize;
+    int res = fs.FileRead(&streamFile, transferBuffer.data(), std::min(chunkSize, streamEnd - streamOffset));
+    if (res <= 0) {
+      resp.status = (int8_t) ((res < 0) ? res : LFS_ERR_IO);
+      ble_gattc_notify_custom(streamConnectionHandle, transferCharacteristicHandle, ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse)));
+      EndStream();
+      return;
+    }
+    resp.chunklen = res;
+
+    os_mbuf* om = ble_hs_mbuf_from_flat(&resp, sizeof(ReadResponse));
+    if (om != nullptr && os_mbuf_append(om, transferBuffer.data(), resp.chunklen) != 0) {
+      os_mbuf_free_chain(om);
+      om = nullptr;
+    }
+    // Out of buffers: the chunk is read again when the client acknowledges the previous ones
+    if (om == nullptr || ble_gattc_notify_custom(streamConnectionHandle, transferCharacteristicHandle, om) != 0) {
+      fs.FileSeek(&streamFile, streamOffset);
+      return;
+    }
+    streamOffset += resp.chunklen;
+  }
+  if (streamOffset >= streamEnd) {
+    EndStream();
+  }
+}
+
+void FSService::OnReadStreamAck(os_mbuf* om) {
+  ReadStreamAck ack;
+  if (state != FSState::READ || os_mbuf_copydata(om, 0, sizeof(ack), &ack) < 0) {
+    return;
+  }
+  if (ack.status != 0x01) {
+    EndStream();
+    return;
+  }
+  if (ack.offset > streamAcknowledged && ack.offset <= streamOffset) {
+    streamAcknowledged = ack.offset;
+  }
+  SendReadStream();
+}
+
+void FSService::StartWriteStream(uint16_t connectionHandle, os_mbuf* om) {
+  auto* header = (WriteStreamHeader*) om->om_data;
+  fileSize = header->totalSize;
+  WriteResponse resp {};
+  resp.command = commands::WRITE_PACING;
+  resp.status = 0x01;
+
+  // Resuming an interrupted transfer keeps the data received before, up to what actually reached the file: the transfer
+  // resumes from the offset requested by the client or from the end of the file, whichever comes first
+  uint32_t offset = 0;
+  int flags = LFS_O_WRONLY | LFS_O_CREAT | ((header->offset == 0) ? LFS_O_TRUNC : 0);
+  int res = CopyPath(header->pathstr, header->pathlen) ? fs.FileOpen(&streamFile, filepath, flags) : LFS_ERR_NAMETOOLONG;
+  if (res >= 0 && header->offset > 0) {
+    res = fs.FileSize(&streamFile);
+    if (res >= 0) {
+      offset = std::min<uint32_t>(header->offset, res);
+      res = fs.FileTruncate(&streamFile, offset);
+    }
+    if (res < 0) {
+      fs.FileClose(&streamFile);
+    }
+  }
+  if (res >= 0 && (res = fs.FileSeek(&streamFile, offset)) < 0) {
+    fs.FileClose(&streamFile);
+  }
+  if (res < 0) {
+    resp.status = (int8_t) res;
+  } else if (offset < header->totalSize) {
+    state = FSState::WRITE;
+    streamConnectionHandle = connectionHandle;
+    streamOffset = offset;
+    streamEnd = header->totalSize;
+    streamWindow = std::max<uint8_t>(header->window, 1);
+    nbUnacknowledged = 0;
+    isStreamOutOfSync = false;
+    // Released by EndStream()
+    systemTask.PushMessage(Pinetime::System::Messages::StartFileTransfer);
+  } else {
+    fs.FileClose(&streamFile);
+  }
+  resp.offset = offset;
+  resp.freespace = RemainingSpace(offset);
+  ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, ble_hs_mbuf_from_flat(&resp, sizeof(WriteResponse)));
+}
+
+void FSService::StartInstall(uint16_t connectionHandle, os_mbuf* om) {
+  auto* header = (InstallHeader*) om->om_data;
+  fileSize = header->archiveSize;
+  WriteResponse resp {};
+  resp.command = commands::INSTALL_STATUS;
+
+  // Returns the offset from which the client sends the archive
+  int res = resourceInstaller.Begin(header->archiveSize, header->archiveId);
+  uint32_t offset = (res < 0) ? 0 : res;
+  if (res >= 0 && offset >= header->archiveSize) {
+    // Everything was received before the interruption
+    res = resourceInstaller.Finish();
+  } else if (res >= 0) {
+    state = FSState::INSTALL;
+    streamConnectionHandle = connectionHandle;
+    streamOffset = offset;
+    streamEnd = header->archiveSize;
+    streamWindow = std::max<uint8_t>(header->window, 1);
+    nbUnacknowledged = 0;
+    isStreamOutOfSync = false;
+    // Released by EndStream()
+    systemTask.PushMessage(Pinetime::System::Messages::StartFileTransfer);
+  }
+  resp.status = (res < 0) ? (int8_t) res : 0x01;
+  resp.offset = offset;
+  resp.freespace = RemainingSpace(offset);
+  ble_gattc_notify_custom(connectionHandle, transferCharacteristicHandle, ble_hs_mbuf_from_flat(&resp, sizeof(WriteResponse)));
+}
+
+// Writes the data to the file, or to the resource installer, and acknowledges once every window, at the end of the file and
+// on errors
+void FSService::OnWriteStreamData(os_mbuf* om) {
+  uint16_t length = OS_MBUF_PKTLEN(om);
+  if ((state != FSState::WRITE && state != FSState::INSTALL) || length < sizeof(WriteStreamData) || length > transferBuffer.size() ||
+      os_mbuf_copydata(om, 0, length, transferBuffer.data()) < 0) {
+    return;
+  }
+  const auto* packet = reinterpret_cast<const WriteStreamData*>(transferBuffer.data());
+  uint32_t dataSize = std::min<uint32_t>(length - sizeof(WriteStreamData), streamEnd - streamOffset);
+
+  int res = 0;
+  bool mustAcknowledge = false;
+  if (packet->offset != streamOffset) {
+    // Only the first packet after the missing one is answered, the next ones are dropped until the client resumes
+    mustAcknowledge = !isStreamOutOfSync;
+    isStreamOutOfSync = true;
+  } else {
+    isStreamOutOfSync = false;
+    res = (state == FSState::INSTALL) ? resourceInstaller.Write(packet->data, dataSize) : fs.FileWrite(&streamFile, packet->data, dataSize);
+    if (res >= 0) {
+      streamOffset += dataSize;
+      nbUnacknowledged++;
+    }
+  }
+
+  auto ackCommand = (state == FSState::INSTALL) ? commands::INSTALL_STATUS : commands::WRITE_PACING;
+  bool isComplete = streamOffset >= streamEnd;
+  if (res < 0 || isComplete) {
+    // The data is only committed by lfs_file_close(), the resources are swapped by ResourceInstaller::Finish()
+    int closeRes = EndStream();
+    res = (res < 0) ? res : closeRes;
+  }
+  if (!mustAcknowledge && res >= 0 && !isComplete && nbUnacknowledged < streamWindow) {
+    return;
+  }
+
+  WriteResponse resp {};
+  resp.command = ackCommand;
+  resp.status = (res < 0) ? (int8_t) res : 0x01;
+  resp.offset = streamOffset;
+  resp.freespace = RemainingSpace(streamOffset);
+  nbUnacknowledged = 0;
+  ble_gattc_notify_custom(streamConnectionHandle, transferCharacteristicHandle, ble_hs_mbuf_from_flat(&resp, sizeof(WriteResponse)));
+}
+
+int FSService::EndStream() {
+  int res = LFS_ERR_OK;
+  if (state != FSState::INSTALL) {
+    res = fs.FileClose(&streamFile);
+  } else if (streamOffset >= streamEnd) {
+    res = resourceInstaller.Finish();
+  } else {
+    // Saves the progress, the client resumes the install with the same archive
+    resourceInstaller.Suspend();
+  }
+  state = FSState::IDLE;
+  systemTask.PushMessage(Pinetime::System::Messages::StopFileTransfer);
+  return res;
+}
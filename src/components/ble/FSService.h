@@ -5,7 +5,9 @@
 #undef max
 #undef min
 
+#include <array>
 #include "components/fs/FS.h"
+#include "components/fs/ResourceInstaller.h"
 
 namespace Pinetime {
   namespace System {
@@ -24,10 +26,13 @@ namespace Pinetime {
 
       int OnFSServiceRequested(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context);
       void NotifyFSRaw(uint16_t connectionHandle);
+      // Closes the file of a stream interrupted by a disconnection
+      void Reset();
 
     private:
       Pinetime::System::SystemTask& systemTask;
       Pinetime::Controllers::FS& fs;
+      Pinetime::Controllers::ResourceInstaller resourceInstaller;
 
       static constexpr const char denyAlert[] = "InfiniTime\0File access attempted, but disabled in settings.";
       static constexpr const uint8_t denyAlertLength = sizeof(denyAlert); // for this to work denyAlert MUST be array
@@ -59,9 +64,13 @@ namespace Pinetime {
         READ = 0x10,
         READ_DATA = 0x11,
         READ_PACING = 0x12,
+        READ_STREAM = 0x13,
+        READ_STREAM_ACK = 0x14,
         WRITE = 0x20,
         WRITE_PACING = 0x21,
         WRITE_DATA = 0x22,
+        WRITE_STREAM = 0x23,
+        WRITE_STREAM_DATA = 0x24,
         DELETE = 0x30,
         DELETE_STATUS = 0x31,
         MKDIR = 0x40,
@@ -69,17 +78,36 @@ namespace Pinetime {
         LISTDIR = 0x50,
         LISTDIR_ENTRY = 0x51,
         MOVE = 0x60,
-        MOVE_STATUS = 0x61
+        MOVE_STATUS = 0x61,
+        INSTALL = 0x70,
+        INSTALL_STATUS = 0x71
       };
       enum class FSState : uint8_t {
         IDLE = 0x00,
         READ = 0x01,
         WRITE = 0x02,
+        INSTALL = 0x03,
       };
-      FSState state;
+      FSState state = FSState::IDLE;
       char filepath[maxpathlen]; // TODO ..ugh fixed filepath len
       int fileSize;
 
+      // Largest value written or notified on the transfer characteristic, with the largest MTU the watch accepts
+      static constexpr size_t maxPacketSize = MYNEWT_VAL(BLE_ATT_PREFERRED_MTU) - 3;
+      std::array<uint8_t, maxPacketSize> transferBuffer;
+
+      // File kept open during a READ_STREAM or WRITE_STREAM transfer (state READ or WRITE), INSTALL streams the archive
+      // to resourceInstaller instead
+      lfs_file_t streamFile;
+      uint16_t streamConnectionHandle;
+      uint32_t streamOffset;       // Next byte to send or to receive
+      uint32_t streamEnd;          // End of the transfer, offset in the file
+      uint32_t streamAcknowledged; // READ: bytes the client acknowledged
+      uint32_t streamFileSize;     // READ: size of the file
+      uint8_t streamWindow;        // Packets sent without acknowledgement
+      uint8_t nbUnacknowledged;    // WRITE: packets received since the last WRITE_PACING
+      bool isStreamOutOfSync;      // WRITE: a packet was missed, the client resumes from the last WRITE_PACING
+
       using ReadHeader = struct __attribute__((packed)) {
         commands command;
         uint8_t padding;
@@ -135,6 +163,48 @@ namespace Pinetime {
         uint8_t data[];
       };
 
+      using ReadStreamHeader = struct __attribute__((packed)) {
+        commands command;
+        uint8_t window;
+        uint16_t pathlen;
+        uint32_t chunkoff;
+        uint32_t length; // 0 reads until the end of the file
+        char pathstr[];
+      };
+
+      using ReadStreamAck = struct __attribute__((packed)) {
+        commands command;
+        uint8_t status; // 0x01 to continue, anything else stops the stream
+        uint16_t padding;
+        uint32_t offset; // Bytes received, from the beginning of the file
+      };
+
+      using WriteStreamHeader = struct __attribute__((packed)) {
+        commands command;
+        uint8_t window;
+        uint16_t pathlen;
+        uint32_t offset;
+        uint64_t modTime;
+        uint32_t totalSize;
+        char pathstr[];
+      };
+
+      using WriteStreamData = struct __attribute__((packed)) {
+        commands command;
+        uint8_t padding;
+        uint16_t padding2;
+        uint32_t offset;
+        uint8_t data[]; // Up to the end of the packet
+      };
+
+      using InstallHeader = struct __attribute__((packed)) {
+        commands command;
+        uint8_t window;
+        uint16_t padding;
+        uint32_t archiveSize;
+        uint32_t archiveId; // CRC32 of the archive, an install resumes only if it matches
+      };
+
       using ListDirHeader = struct __attribute__((packed)) {
         commands command;
         uint8_t padding;
@@ -198,6 +268,17 @@ namespace Pinetime {
 
       int FSCommandHandler(uint16_t connectionHandle, os_mbuf* om);
       void prepareReadDataResp(ReadHeader* header, ReadResponse* resp);
+
+      uint32_t MaxChunkSize(uint16_t connectionHandle) const;
+      uint32_t RemainingSpace(uint32_t offset);
+      bool CopyPath(const char* path, uint16_t length);
+      void StartReadStream(uint16_t connectionHandle, os_mbuf* om);
+      void SendReadStream();
+      void OnReadStreamAck(os_mbuf* om);
+      void StartWriteStream(uint16_t connectionHandle, os_mbuf* om);
+      void OnWriteStreamData(os_mbuf* om);
+      void StartInstall(uint16_t connectionHandle, os_mbuf* om);
+      int EndStream();
     };
   }
 }
@@ -1,6 +1,8 @@
 #include "components/ble/MotionService.h"
 #include "components/motion/MotionController.h"
 #include "components/ble/NimbleController.h"
+#include "systemtask/SystemTask.h"
+#include <algorithm>
 #include <nrf_log.h>
 
 using namespace Pinetime::Controllers;
@@ -20,6 +22,10 @@ namespace {
   constexpr ble_uuid128_t motionServiceUuid {BaseUuid()};
   constexpr ble_uuid128_t stepCountCharUuid {CharUuid(0x01, 0x00)};
   constexpr ble_uuid128_t motionValuesCharUuid {CharUuid(0x02, 0x00)};
+  constexpr ble_uuid128_t streamConfigCharUuid {CharUuid(0x03, 0x00)};
+  constexpr ble_uuid128_t motionStreamCharUuid {CharUuid(0x04, 0x00)};
+
+  static_assert(sizeof(Pinetime::Drivers::Bma421::Sample) == 3 * sizeof(int16_t), "Samples are notified as they are stored");
 
   int MotionServiceCallback(uint16_t /*conn_handle*/, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
     auto* motionService = static_cast<MotionService*>(arg);
@@ -28,8 +34,11 @@ namespace {
 }
 
 // TODO Refactoring - remove dependency to SystemTask
-MotionService::MotionService(NimbleController& nimble, Controllers::MotionController& motionController)
-  : nimble {nimble},
+MotionService::MotionService(Pinetime::System::SystemTask& systemTask,
+                             NimbleController& nimble,
+                             Controllers::MotionController& motionController)
+  : systemTask {systemTask},
+    nimble {nimble},
     motionController {motionController},
     characteristicDefinition {{.uuid = &stepCountCharUuid.u,
                                .access_cb = MotionServiceCallback,
@@ -41,6 +50,16 @@ MotionService::MotionService(NimbleController& nimble, Controllers::MotionContro
                                .arg = this,
                                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
                                .val_handle = &motionValuesHandle},
+                              {.uuid = &streamConfigCharUuid.u,
+                               .access_cb = MotionServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &streamConfigHandle},
+                              {.uuid = &motionStreamCharUuid.u,
+                               .access_cb = MotionServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_NOTIFY,
+                               .val_handle = &motionStreamHandle},
                               {0}},
     serviceDefinition {
       {.type = BLE_GATT_SVC_TYPE_PRIMARY, .uuid = &motionServiceUuid.u, .characteristics = characteristicDefinition},
@@ -73,9 +92,32 @@ int MotionService::OnStepCountRequested(uint16_t attributeHandle, ble_gatt_acces
     int res = os_mbuf_append(context->om, buffer, 3 * sizeof(int16_t));
     return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
   }
+  if (attributeHandle == streamConfigHandle) {
+    return OnStreamConfigRequested(context);
+  }
   return 0;
 }
 
+int MotionService::OnStreamConfigRequested(ble_gatt_access_ctxt* context) {
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    StreamConfig config;
+    if (OS_MBUF_PKTLEN(context->om) != sizeof(config)) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    os_mbuf_copydata(context->om, 0, sizeof(config), &config);
+    streamSampleRate = config.sampleRate;
+    streamBatchSize = config.batchSize;
+    if (motionStreamNotificationEnabled) {
+      systemTask.PushMessage(Pinetime::System::Messages::MotionStreamChanged);
+    }
+    return 0;
+  }
+
+  StreamConfig config {streamSampleRate, StreamBatchSize()};
+  int res = os_mbuf_append(context->om, &config, sizeof(config));
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
 void MotionService::OnNewStepCountValue(uint32_t stepCount) {
   if (!stepCountNotificationEnabled) {
     return;
@@ -110,11 +152,101 @@ void MotionService::OnNewMotionValues(int16_t x, int16_t y, int16_t z) {
   ble_gattc_notify_custom(connectionHandle, motionValuesHandle, om);
 }
 
+void MotionService::OnNewMotionSamples(const Drivers::Bma421::Sample* samples,
+                                       size_t nbSamples,
+                                       uint32_t samplePeriodMs,
+                                       TickType_t lastSampleTime) {
+  if (!motionStreamNotificationEnabled) {
+    streamBufferCount = 0;
+    return;
+  }
+
+  // The timestamps of the queued samples are derived from the sample period
+  if (samplePeriodMs != streamSamplePeriodMs) {
+    streamBufferCount = 0;
+    streamSamplePeriodMs = samplePeriodMs;
+  }
+  for (size_t i = 0; i < nbSamples; i++) {
+    // Drop the oldest sample if the link can't keep up, the client sees the gap in the sample numbers
+    if (streamBufferCount == streamBuffer.size()) {
+      streamBufferStart = (streamBufferStart + 1) % streamBuffer.size();
+      streamBufferCount--;
+    }
+    streamBuffer[(streamBufferStart + streamBufferCount) % streamBuffer.size()] = samples[i];
+    streamBufferCount++;
+    nextSampleNumber++;
+  }
+  lastSampleTimeMs = static_cast<uint32_t>(static_cast<uint64_t>(lastSampleTime) * 1000 / configTICK_RATE_HZ);
+
+  uint16_t connectionHandle = nimble.connHandle();
+  if (connectionHandle == 0 || connectionHandle == BLE_HS_CONN_HANDLE_NONE) {
+    return;
+  }
+
+  size_t batchSize = StreamBatchSize();
+  while (streamBufferCount >= batchSize && NotifyStream(connectionHandle, batchSize)) {
+  }
+}
+
+bool MotionService::NotifyStream(uint16_t connectionHandle, size_t nbSamples) {
+  auto* om = ble_hs_mbuf_att_pkt();
+  if (om == nullptr) {
+    return false;
+  }
+
+  StreamHeader header {.timestamp = lastSampleTimeMs - static_cast<uint32_t>(streamBufferCount - 1) * streamSamplePeriodMs,
+                       .sampleNumber = static_cast<uint16_t>(nextSampleNumber - streamBufferCount),
+                       .samplePeriodMs = static_cast<uint8_t>(streamSamplePeriodMs),
+                       .nbSamples = static_cast<uint8_t>(nbSamples)};
+  // The samples are appended straight from the ring buffer, in two parts if they wrap around
+  size_t firstPart = std::min(nbSamples, streamBuffer.size() - streamBufferStart);
+  int res = os_mbuf_append(om, &header, sizeof(header));
+  if (res == 0) {
+    res = os_mbuf_append(om, &streamBuffer[streamBufferStart], firstPart * sizeof(Drivers::Bma421::Sample));
+  }
+  if (res == 0 && firstPart < nbSamples) {
+    res = os_mbuf_append(om, streamBuffer.data(), (nbSamples - firstPart) * sizeof(Drivers::Bma421::Sample));
+  }
+  if (res != 0) {
+    os_mbuf_free_chain(om);
+    return false;
+  }
+
+  // The mbuf is freed by the stack even if the notification fails, the samples are then sent with the next batch
+  if (ble_gattc_notify_custom(connectionHandle, motionStreamHandle, om) != 0) {
+    return false;
+  }
+  streamBufferStart = (streamBufferStart + nbSamples) % streamBuffer.size();
+  streamBufferCount -= nbSamples;
+  return true;
+}
+
+size_t MotionService::MaxSamplesPerNotification(uint16_t connectionHandle) const {
+  uint16_t mtu = ble_att_mtu(connectionHandle);
+  if (mtu < BLE_ATT_MTU_DFLT) {
+    mtu = BLE_ATT_MTU_DFLT;
+  }
+  // 3 bytes of ATT header
+  return (mtu - 3 - sizeof(StreamHeader)) / sizeof(Drivers::Bma421::Sample);
+}
+
+uint8_t MotionService::StreamBatchSize() const {
+  size_t maxSamples = std::min(MaxSamplesPerNotification(nimble.connHandle()), Drivers::Bma421::MaxFifoSamples);
+  uint8_t requested = streamBatchSize;
+  if (requested == 0 || requested > maxSamples) {
+    return static_cast<uint8_t>(maxSamples);
+  }
+  return requested;
+}
+
 void MotionService::SubscribeNotification(uint16_t attributeHandle) {
   if (attributeHandle == stepCountHandle) {
     stepCountNotificationEnabled = true;
   } else if (attributeHandle == motionValuesHandle) {
     motionValuesNotificationEnabled = true;
+  } else if (attributeHandle == motionStreamHandle) {
+    motionStreamNotificationEnabled = true;
+    systemTask.PushMessage(Pinetime::System::Messages::MotionStreamChanged);
   }
 }
 
@@ -123,5 +255,8 @@ void MotionService::UnsubscribeNotification(uint16_t attributeHandle) {
     stepCountNotificationEnabled = false;
   } else if (attributeHandle == motionValuesHandle) {
     motionValuesNotificationEnabled = false;
+  } else if (attributeHandle == motionStreamHandle) {
+    motionStreamNotificationEnabled = false;
+    systemTask.PushMessage(Pinetime::System::Messages::MotionStreamChanged);
   }
 }
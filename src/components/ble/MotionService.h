@@ -6,33 +6,89 @@
 #undef max
 #undef min
 
+#include <array>
+#include <FreeRTOS.h>
+#include "drivers/Bma421.h"
+
 namespace Pinetime {
+  namespace System {
+    class SystemTask;
+  }
+
   namespace Controllers {
     class NimbleController;
     class MotionController;
 
     class MotionService {
     public:
-      MotionService(NimbleController& nimble, Controllers::MotionController& motionController);
+      MotionService(Pinetime::System::SystemTask& systemTask, NimbleController& nimble, Controllers::MotionController& motionController);
       void Init();
       int OnStepCountRequested(uint16_t attributeHandle, ble_gatt_access_ctxt* context);
       void OnNewStepCountValue(uint32_t stepCount);
       void OnNewMotionValues(int16_t x, int16_t y, int16_t z);
+      // Queues samples taken samplePeriodMs apart, the last one at lastSampleTime, and notifies them in batches
+      void OnNewMotionSamples(const Drivers::Bma421::Sample* samples, size_t nbSamples, uint32_t samplePeriodMs, TickType_t lastSampleTime);
 
       void SubscribeNotification(uint16_t attributeHandle);
       void UnsubscribeNotification(uint16_t attributeHandle);
 
+      bool IsStreaming() const {
+        return motionStreamNotificationEnabled;
+      }
+
+      // Sample rate (Hz) and samples per notification requested by the client
+      uint8_t StreamSampleRate() const {
+        return streamSampleRate;
+      }
+
+      uint8_t StreamBatchSize() const;
+
     private:
+      // Prepended to each notification of the stream characteristic, followed by nbSamples x, y, z int16_t values.
+      // The samples are sampleNumber, sampleNumber + 1... and were taken samplePeriodMs apart, the first one at timestamp (ms).
+      struct StreamHeader {
+        uint32_t timestamp;
+        uint16_t sampleNumber;
+        uint8_t samplePeriodMs;
+        uint8_t nbSamples;
+      };
+
+      struct StreamConfig {
+        uint8_t sampleRate;
+        uint8_t batchSize;
+      };
+
+      static constexpr size_t streamBufferSize = 2 * Drivers::Bma421::MaxFifoSamples;
+
+      int OnStreamConfigRequested(ble_gatt_access_ctxt* context);
+      size_t MaxSamplesPerNotification(uint16_t connectionHandle) const;
+      bool NotifyStream(uint16_t connectionHandle, size_t nbSamples);
+
+      Pinetime::System::SystemTask& systemTask;
       NimbleController& nimble;
       Controllers::MotionController& motionController;
 
-      struct ble_gatt_chr_def characteristicDefinition[3];
+      struct ble_gatt_chr_def characteristicDefinition[5];
       struct ble_gatt_svc_def serviceDefinition[2];
 
       uint16_t stepCountHandle;
       uint16_t motionValuesHandle;
+      uint16_t streamConfigHandle;
+      uint16_t motionStreamHandle;
       std::atomic_bool stepCountNotificationEnabled {false};
       std::atomic_bool motionValuesNotificationEnabled {false};
+      std::atomic_bool motionStreamNotificationEnabled {false};
+      std::atomic<uint8_t> streamSampleRate {Drivers::Bma421::DefaultFifoSampleRate};
+      // 0: as many samples as the MTU allows
+      std::atomic<uint8_t> streamBatchSize {0};
+
+      // Samples waiting to be notified, only accessed by the system task
+      std::array<Drivers::Bma421::Sample, streamBufferSize> streamBuffer;
+      size_t streamBufferStart = 0;
+      size_t streamBufferCount = 0;
+      uint16_t nextSampleNumber = 0;
+      uint32_t streamSamplePeriodMs = 0;
+      uint32_t lastSampleTimeMs = 0;
     };
   }
 }
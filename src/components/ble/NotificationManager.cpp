@@ -20,6 +20,7 @@ void NotificationManager::Push(NotificationManager::Notification&& notif) {
   if (size < notifications.size()) {
     size++;
   }
+  changeNotifier.Publish(ChangeNotifier::Topic::Notifications);
 }
 
 NotificationManager::Notification::Id NotificationManager::GetNextId() {
@@ -125,7 +126,11 @@ bool NotificationManager::AreNewNotificationsAvailable() const {
 }
 
 bool NotificationManager::ClearNewNotificationFlag() {
-  return newNotification.exchange(false);
+  bool wasNewNotification = newNotification.exchange(false);
+  if (wasNewNotification) {
+    changeNotifier.Publish(ChangeNotifier::Topic::Notifications);
+  }
+  return wasNewNotification;
 }
 
 size_t NotificationManager::NbNotifications() const {
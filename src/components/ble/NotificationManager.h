@@ -4,6 +4,7 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include "components/changes/ChangeNotifier.h"
 
 namespace Pinetime {
   namespace Controllers {
@@ -38,6 +39,9 @@ namespace Pinetime {
         const char* Title() const;
       };
 
+      explicit NotificationManager(ChangeNotifier& changeNotifier) : changeNotifier {changeNotifier} {
+      }
+
       void Push(Notification&& notif);
       Notification GetLastNotification() const;
       Notification Get(Notification::Id id) const;
@@ -60,6 +64,7 @@ namespace Pinetime {
       size_t NbNotifications() const;
 
     private:
+      ChangeNotifier& changeNotifier;
       Notification::Id nextId {0};
       Notification::Id GetNextId();
       const Notification& At(Notification::Idx idx) const;
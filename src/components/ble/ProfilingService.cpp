@@ -0,0 +1,177 @@
+#include "components/ble/ProfilingService.h"
+#include <array>
+#include <FreeRTOS.h>
+#include "components/profiling/FrameProfiler.h"
+#include "drivers/SpiMaster.h"
+#include "systemtask/SystemMonitor.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  // 0006yyxx-78fc-48fe-8e23-433b3a1942d0
+  constexpr ble_uuid128_t CharUuid(uint8_t x, uint8_t y) {
+    return ble_uuid128_t {.u = {.type = BLE_UUID_TYPE_128},
+                          .value = {0xd0, 0x42, 0x19, 0x3a, 0x3b, 0x43, 0x23, 0x8e, 0xfe, 0x48, 0xfc, 0x78, x, y, 0x06, 0x00}};
+  }
+
+  // 00060000-78fc-48fe-8e23-433b3a1942d0
+  constexpr ble_uuid128_t BaseUuid() {
+    return CharUuid(0x00, 0x00);
+  }
+
+  constexpr ble_uuid128_t profilingServiceUuid {BaseUuid()};
+  constexpr ble_uuid128_t frameTimingsCharUuid {CharUuid(0x01, 0x00)};
+  constexpr ble_uuid128_t tasksCharUuid {CharUuid(0x02, 0x00)};
+  constexpr ble_uuid128_t heapCharUuid {CharUuid(0x03, 0x00)};
+  constexpr ble_uuid128_t heapTraceCharUuid {CharUuid(0x04, 0x00)};
+  constexpr ble_uuid128_t spiBusCharUuid {CharUuid(0x05, 0x00)};
+
+  // Keeps a read of the heap trace under the 512 bytes limit of an attribute value
+  constexpr size_t maxHeapTraceRecords = 40;
+
+  struct __attribute__((packed)) HeapSummary {
+    uint32_t heapSize;
+    uint32_t freeBytes;
+    uint32_t largestFreeBlock;
+    uint32_t smallestFreeBlock;
+    uint32_t nbFreeBlocks;
+    uint32_t minimumEverFreeBytes;
+    uint32_t nbAllocations;
+    uint32_t nbFrees;
+    uint32_t nbFailedAllocations;
+    uint8_t nbSizeClasses;
+  };
+
+  struct __attribute__((packed)) HeapTraceHeader {
+    uint32_t heapSize;
+    uint32_t nextSequence;
+    uint32_t firstSequence;
+  };
+
+  int ProfilingServiceCallback(uint16_t /*conn_handle*/, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    auto* profilingService = static_cast<ProfilingService*>(arg);
+    return profilingService->OnProfilingRequested(attr_handle, ctxt);
+  }
+}
+
+ProfilingService::ProfilingService(const Controllers::FrameProfiler& frameProfiler,
+                                   const System::SystemMonitor& systemMonitor,
+                                   const Drivers::SpiMaster& spiMaster)
+  : frameProfiler {frameProfiler},
+    systemMonitor {systemMonitor},
+    spiMaster {spiMaster},
+    characteristicDefinition {{.uuid = &frameTimingsCharUuid.u,
+                               .access_cb = ProfilingServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &frameTimingsHandle},
+                              {.uuid = &tasksCharUuid.u,
+                               .access_cb = ProfilingServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &tasksHandle},
+                              {.uuid = &heapCharUuid.u,
+                               .access_cb = ProfilingServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &heapHandle},
+                              {.uuid = &heapTraceCharUuid.u,
+                               .access_cb = ProfilingServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &heapTraceHandle},
+                              {.uuid = &spiBusCharUuid.u,
+                               .access_cb = ProfilingServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &spiBusHandle},
+                              {0}},
+    serviceDefinition {
+      {.type = BLE_GATT_SVC_TYPE_PRIMARY, .uuid = &profilingServiceUuid.u, .characteristics = characteristicDefinition},
+      {0},
+    } {
+}
+
+void ProfilingService::Init() {
+  int res = 0;
+  res = ble_gatts_count_cfg(serviceDefinition);
+  ASSERT(res == 0);
+
+  res = ble_gatts_add_svcs(serviceDefinition);
+  ASSERT(res == 0);
+}
+
+int ProfilingService::OnProfilingRequested(uint16_t attributeHandle, ble_gatt_access_ctxt* context) {
+  if (attributeHandle == frameTimingsHandle) {
+    // Total number of frames since boot, number of records, then the records from the oldest to the newest
+    // Written by the display task meanwhile
+    auto snapshot = frameProfiler.GetSnapshot();
+    int res = os_mbuf_append(context->om, &snapshot.totalFrames, sizeof(snapshot.totalFrames));
+    res |= os_mbuf_append(context->om, &snapshot.nbFrames, sizeof(snapshot.nbFrames));
+    for (uint8_t i = 0; i < snapshot.nbFrames; i++) {
+      res |= os_mbuf_append(context->om, &snapshot.frames[i], sizeof(FrameProfiler::Frame));
+    }
+    return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+  }
+  if (attributeHandle == tasksHandle) {
+    // Statistics of the last window, then one record per task
+    auto snapshot = systemMonitor.GetSnapshot();
+    int res = os_mbuf_append(context->om, &snapshot.stats, sizeof(snapshot.stats));
+    for (uint8_t i = 0; i < snapshot.stats.nbTasks; i++) {
+      res |= os_mbuf_append(context->om, &snapshot.tasks[i], sizeof(System::SystemMonitor::TaskStats));
+    }
+    return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+  }
+  if (attributeHandle == heapHandle) {
+    // Statistics of the FreeRTOS heap, then one record per size class
+    HeapStats_t stats;
+    vPortGetHeapStats(&stats);
+    std::array<HeapSizeClass_t, portHEAP_SIZE_CLASSES> sizeClasses;
+    vPortGetHeapSizeClasses(sizeClasses.data());
+    HeapSummary summary {.heapSize = xPortGetHeapSize(),
+                         .freeBytes = stats.xAvailableHeapSpaceInBytes,
+                         .largestFreeBlock = stats.xSizeOfLargestFreeBlockInBytes,
+                         .smallestFreeBlock = stats.xSizeOfSmallestFreeBlockInBytes,
+                         .nbFreeBlocks = stats.xNumberOfFreeBlocks,
+                         .minimumEverFreeBytes = stats.xMinimumEverFreeBytesRemaining,
+                         .nbAllocations = stats.xNumberOfSuccessfulAllocations,
+                         .nbFrees = stats.xNumberOfSuccessfulFrees,
+                         .nbFailedAllocations = stats.xNumberOfFailedAllocations,
+                         .nbSizeClasses = portHEAP_SIZE_CLASSES};
+    int res = os_mbuf_append(context->om, &summary, sizeof(summary));
+    res |= os_mbuf_append(context->om, sizeClasses.data(), sizeof(sizeClasses));
+    return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+  }
+  if (attributeHandle == heapTraceHandle) {
+    return OnHeapTraceRequested(context);
+  }
+  if (attributeHandle == spiBusHandle) {
+    // One record per client of the SPI bus, in decreasing order of priority
+    uint8_t nbClients = Drivers::SpiMaster::NbClients;
+    int res = os_mbuf_append(context->om, &nbClients, sizeof(nbClients));
+    for (uint8_t i = 0; i < nbClients; i++) {
+      auto stats = spiMaster.GetStats(static_cast<Drivers::SpiMaster::Client>(i));
+      res |= os_mbuf_append(context->om, &stats, sizeof(stats));
+    }
+    return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+  }
+  return 0;
+}
+
+int ProfilingService::OnHeapTraceRequested(ble_gatt_access_ctxt* context) {
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    // Selects the first record returned by the next reads
+    if (os_mbuf_copydata(context->om, 0, sizeof(heapTraceSequence), &heapTraceSequence) < 0) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    return 0;
+  }
+
+  // The value doesn't depend on the time of the read, so that it stays consistent across the requests of a long read
+  std::array<HeapTraceRecord_t, maxHeapTraceRecords> records;
+  HeapTraceHeader header {.heapSize = xPortGetHeapSize()};
+  size_t nbRecords = xPortGetHeapTrace(heapTraceSequence, records.data(), records.size(), &header.firstSequence, &header.nextSequence);
+  int res = os_mbuf_append(context->om, &header, sizeof(header));
+  res |= os_mbuf_append(context->om, records.data(), nbRecords * sizeof(HeapTraceRecord_t));
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
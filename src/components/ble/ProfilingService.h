@@ -0,0 +1,51 @@
+#pragma once
+#define min // workaround: nimble's min/max macros conflict with libstdc++
+#define max
+#include <host/ble_gap.h>
+#undef max
+#undef min
+#include <cstdint>
+
+namespace Pinetime {
+  namespace System {
+    class SystemMonitor;
+  }
+
+  namespace Drivers {
+    class SpiMaster;
+  }
+
+  namespace Controllers {
+    class FrameProfiler;
+
+    // Exposes the data collected by the profiling controllers. The frame timings are only recorded in profiling builds.
+    class ProfilingService {
+    public:
+      ProfilingService(const Controllers::FrameProfiler& frameProfiler,
+                       const System::SystemMonitor& systemMonitor,
+                       const Drivers::SpiMaster& spiMaster);
+      void Init();
+
+      int OnProfilingRequested(uint16_t attributeHandle, ble_gatt_access_ctxt* context);
+
+    private:
+      const Controllers::FrameProfiler& frameProfiler;
+      const System::SystemMonitor& systemMonitor;
+      const Drivers::SpiMaster& spiMaster;
+
+      struct ble_gatt_chr_def characteristicDefinition[6];
+      struct ble_gatt_svc_def serviceDefinition[2];
+
+      uint16_t frameTimingsHandle;
+      uint16_t tasksHandle;
+      uint16_t heapHandle;
+      uint16_t heapTraceHandle;
+      uint16_t spiBusHandle;
+
+      // Sequence number of the first heap trace record returned by the next read
+      uint32_t heapTraceSequence = 0;
+
+      int OnHeapTraceRequested(ble_gatt_access_ctxt* context);
+    };
+  }
+}
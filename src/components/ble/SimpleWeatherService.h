@@ -32,6 +32,7 @@
 #undef min
 
 #include "components/datetime/DateTimeController.h"
+#include "components/changes/ChangeNotifier.h"
 #include <lvgl/lvgl.h>
 #include "displayapp/InfiniTimeTheme.h"
 
@@ -42,7 +43,7 @@ namespace Pinetime {
 
     class SimpleWeatherService {
     public:
-      explicit SimpleWeatherService(DateTime& dateTimeController);
+      SimpleWeatherService(DateTime& dateTimeController, ChangeNotifier& changeNotifier);
 
       void Init();
 
@@ -180,6 +181,7 @@ namespace Pinetime {
       uint16_t eventHandle {};
 
       Pinetime::Controllers::DateTime& dateTimeController;
+      ChangeNotifier& changeNotifier;
 
       std::optional<CurrentWeather> currentWeather;
       std::optional<Forecast> forecast;
@@ -0,0 +1,44 @@
+#include "components/changes/ChangeNotifier.h"
+
+#ifdef PINETIME_IS_RECOVERY
+  #include "displayapp/DisplayAppRecovery.h"
+#else
+  #include "displayapp/DisplayApp.h"
+#endif
+
+using namespace Pinetime::Controllers;
+
+void ChangeNotifier::Register(Applications::DisplayApp* displayApp) {
+  this->displayApp = displayApp;
+}
+
+void ChangeNotifier::Publish(Topic topic) {
+  auto mask = Mask(topic);
+  changes.fetch_or(mask);
+  // Several changes published before DisplayApp runs again only wake it once
+  if ((subscriptions & mask) != 0 && !isSuspended && displayApp != nullptr && !isWakeUpPending.exchange(true)) {
+    displayApp->PushMessage(Applications::Display::Messages::ValuesChanged);
+  }
+}
+
+void ChangeNotifier::Subscribe(Topics topics) {
+  subscriptions = topics;
+}
+
+void ChangeNotifier::Unsubscribe() {
+  subscriptions = 0;
+}
+
+void ChangeNotifier::Suspend() {
+  isSuspended = true;
+}
+
+void ChangeNotifier::Resume() {
+  isSuspended = false;
+}
+
+ChangeNotifier::Topics ChangeNotifier::TakeChanges() {
+  // Cleared first, so that a topic published from now on wakes DisplayApp again
+  isWakeUpPending = false;
+  return changes.exchange(0) & subscriptions;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Applications {
+    class DisplayApp;
+  }
+
+  namespace Controllers {
+    // Tells the screen displayed by DisplayApp that values it shows have changed, so that it doesn't have to poll the
+    // controllers. Controllers publish a topic when one of its values changes, from any task or interrupt handler.
+    // The screen subscribes to the topics it depends on and DisplayApp calls its Refresh() when one of them is published.
+    class ChangeNotifier {
+    public:
+      enum class Topic : uint8_t {
+        Minutes,       // Time and date, also published by DisplayApp at the start of every minute
+        Seconds,       // Published by DisplayApp at the start of every second
+        Battery,       // Level, charging and power present
+        Ble,           // Connection and radio state
+        HeartRate,     // Heart rate and measurement state
+        Motion,        // Step count
+        Notifications, // New notification flag
+        Weather,       // Current weather and forecast
+        Frame,         // Refreshes the screen every frame, for animations
+      };
+
+      using Topics = uint16_t;
+
+      template <typename... T>
+      static constexpr Topics Mask(T... topics) {
+        return ((1U << static_cast<uint8_t>(topics)) | ... | 0U);
+      }
+
+      ChangeNotifier() = default;
+      ChangeNotifier(const ChangeNotifier&) = delete;
+      ChangeNotifier& operator=(const ChangeNotifier&) = delete;
+      ChangeNotifier(ChangeNotifier&&) = delete;
+      ChangeNotifier& operator=(ChangeNotifier&&) = delete;
+
+      void Register(Applications::DisplayApp* displayApp);
+
+      void Publish(Topic topic);
+
+      // Replaces the topics of the current screen, they are cleared when DisplayApp loads another screen
+      void Subscribe(Topics topics);
+      void Unsubscribe();
+
+      Topics Subscriptions() const {
+        return subscriptions;
+      }
+
+      // Changes are still recorded but don't wake DisplayApp, while the display is off or in always on mode
+      void Suspend();
+      void Resume();
+
+      // Subscribed topics published since the previous call, to be called by DisplayApp only
+      Topics TakeChanges();
+
+    private:
+      Applications::DisplayApp* displayApp = nullptr;
+      std::atomic<Topics> subscriptions {0};
+      std::atomic<Topics> changes {0};
+      // A message is waiting in the queue of DisplayApp, don't send another one
+      std::atomic<bool> isWakeUpPending {false};
+      std::atomic<bool> isSuspended {false};
+    };
+  }
+}
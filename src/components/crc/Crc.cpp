@@ -0,0 +1,60 @@
+#include "components/crc/Crc.h"
+#include <array>
+
+using namespace Pinetime::Tools;
+
+static_assert(CRC_SLICES == 1 || CRC_SLICES == 4, "CRC_SLICES must be 1 or 4");
+
+namespace {
+  // tables[0] is the usual byte table, tables[n] gives the CRC of a byte followed by n zero bytes
+  template <typename T, size_t NbSlices>
+  using Tables = std::array<std::array<T, 256>, NbSlices>;
+
+  constexpr Tables<uint32_t, CRC_SLICES> MakeCrc32Tables() {
+    Tables<uint32_t, CRC_SLICES> tables {};
+    for (uint32_t byte = 0; byte < 256; byte++) {
+      uint32_t crc = byte;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+      }
+      tables[0][byte] = crc;
+    }
+    for (size_t slice = 1; slice < CRC_SLICES; slice++) {
+      for (size_t byte = 0; byte < 256; byte++) {
+        uint32_t previous = tables[slice - 1][byte];
+        tables[slice][byte] = (previous >> 8) ^ tables[0][previous & 0xFF];
+      }
+    }
+    return tables;
+  }
+
+  // In flash
+  constexpr auto crc32Tables = MakeCrc32Tables();
+}
+
+uint16_t Crc16::Update(uint16_t crc, const uint8_t* data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    crc = static_cast<uint8_t>(crc >> 8) | (crc << 8);
+    crc ^= data[i];
+    crc ^= static_cast<uint8_t>(crc & 0xFF) >> 4;
+    crc ^= (crc << 8) << 4;
+    crc ^= ((crc & 0xFF) << 4) << 1;
+  }
+  return crc;
+}
+
+uint32_t Crc32::Update(uint32_t crc, const void* data, size_t size) {
+  const auto& t = crc32Tables;
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  if constexpr (CRC_SLICES == 4) {
+    // Byte by byte loads: the data may be unaligned
+    for (; size >= 4; size -= 4, bytes += 4) {
+      crc ^= bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+      crc = t[3][crc & 0xFF] ^ t[2][(crc >> 8) & 0xFF] ^ t[1][(crc >> 16) & 0xFF] ^ t[0][crc >> 24];
+    }
+  }
+  for (; size > 0; size--, bytes++) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *bytes) & 0xFF];
+  }
+  return crc;
+}
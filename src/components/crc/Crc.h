@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Number of bytes processed per step of the table driven CRC32: 4 (slice-by-4, tables of 4 KB) or 1 (table of 1 KB)
+#ifndef CRC_SLICES
+  #define CRC_SLICES 4
+#endif
+
+namespace Pinetime {
+  namespace Tools {
+    // The nRF52832 has no CRC peripheral usable on memory (the RADIO only checks its own packets). See tools/crc-benchmark
+    // to compare the implementations.
+
+    // CRC16-CCITT (polynomial 0x1021, MSB first, no final XOR), as checked by the Nordic DFU. Computed with a few shifts and
+    // XORs per byte: about as fast as a byte table, without the table in flash.
+    class Crc16 {
+    public:
+      static constexpr uint16_t initialValue = 0xFFFF;
+
+      static uint16_t Update(uint16_t crc, const uint8_t* data, size_t size);
+
+      static uint16_t Compute(const uint8_t* data, size_t size) {
+        return Update(initialValue, data, size);
+      }
+    };
+
+    // CRC32 of zlib (polynomial 0x04C11DB7, reflected), computed from lookup tables generated at compile time. Like
+    // lfs_crc(), Update() doesn't invert the value before and after the update, Compute() does.
+    class Crc32 {
+    public:
+      static constexpr uint32_t initialValue = 0xFFFFFFFF;
+
+      static uint32_t Update(uint32_t crc, const void* data, size_t size);
+
+      static uint32_t Compute(const void* data, size_t size) {
+        return Update(initialValue, data, size) ^ 0xFFFFFFFF;
+      }
+    };
+  }
+}
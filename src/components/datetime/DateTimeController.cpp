@@ -25,7 +25,8 @@ namespace {
   }
 }
 
-DateTime::DateTime(Controllers::Settings& settingsController) : settingsController {settingsController} {
+DateTime::DateTime(Controllers::Settings& settingsController, ChangeNotifier& changeNotifier)
+  : settingsController {settingsController}, changeNotifier {changeNotifier} {
   mutex = xSemaphoreCreateMutex();
   ASSERT(mutex != nullptr);
   xSemaphoreGive(mutex);
@@ -39,6 +40,7 @@ void DateTime::SetCurrentTime(std::chrono::time_point<std::chrono::system_clock,
   this->currentDateTime = t;
   UpdateTime(previousSystickCounter, true); // Update internal state without updating the time
   xSemaphoreGive(mutex);
+  changeNotifier.Publish(ChangeNotifier::Topic::Minutes);
 }
 
 void DateTime::SetTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
@@ -60,6 +62,7 @@ void DateTime::SetTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour,
   currentDateTime = std::chrono::system_clock::from_time_t(std::mktime(&tm));
   UpdateTime(previousSystickCounter, true);
   xSemaphoreGive(mutex);
+  changeNotifier.Publish(ChangeNotifier::Topic::Minutes);
 
   if (systemTask != nullptr) {
     systemTask->PushMessage(System::Messages::OnNewTime);
@@ -69,6 +72,7 @@ void DateTime::SetTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour,
 void DateTime::SetTimeZone(int8_t timezone, int8_t dst) {
   tzOffset = timezone;
   dstOffset = dst;
+  changeNotifier.Publish(ChangeNotifier::Topic::Minutes);
 }
 
 std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds> DateTime::CurrentDateTime() {
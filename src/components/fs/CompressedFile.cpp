@@ -0,0 +1,129 @@
+#include "components/fs/CompressedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <FreeRTOS.h>
+#include "components/fs/FS.h"
+#include "components/lz4/Lz4Decoder.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  constexpr uint8_t magic[] = {'I', 'T', 'Z', '4'};
+
+  uint32_t ReadUint32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+  }
+
+  uint16_t ReadUint16(const uint8_t* data) {
+    return data[0] | (data[1] << 8);
+  }
+}
+
+int CompressedFile::Open(FS& fs, const char* path) {
+  this->fs = &fs;
+  int res = fs.FileOpen(&file, path, LFS_O_RDONLY);
+  if (res < 0) {
+    return res;
+  }
+  if (file.type == 0) {
+    fs.FileClose(&file);
+    return LFS_ERR_ISDIR;
+  }
+
+  uint8_t header[headerSize];
+  if (fs.FileRead(&file, header, sizeof(header)) != sizeof(header) || std::memcmp(header, magic, sizeof(magic)) != 0) {
+    // Not compressed, read as is
+    return fs.FileSeek(&file, 0);
+  }
+
+  size = ReadUint32(header + 4);
+  blockSize = ReadUint16(header + 8);
+  if (blockSize == 0 || blockSize > maxBlockSize) {
+    fs.FileClose(&file);
+    return LFS_ERR_CORRUPT;
+  }
+  nbBlocks = (size + blockSize - 1) / blockSize;
+  // A compressed block is shorter than its data, it is read at the end of the buffer and decoded in place
+  blockBufferSize = blockSize + Pinetime::Tools::Lz4Decoder::InPlaceMargin(blockSize);
+  block = static_cast<uint8_t*>(pvPortMalloc(blockBufferSize));
+  if (block == nullptr) {
+    fs.FileClose(&file);
+    return LFS_ERR_NOMEM;
+  }
+  return LFS_ERR_OK;
+}
+
+int CompressedFile::Close() {
+  if (block != nullptr) {
+    vPortFree(block);
+    block = nullptr;
+  }
+  return fs->FileClose(&file);
+}
+
+int CompressedFile::Read(uint8_t* buffer, uint32_t nbBytes) {
+  if (block == nullptr) {
+    return fs->FileRead(&file, buffer, nbBytes);
+  }
+
+  uint32_t nbRead = 0;
+  while (nbRead < nbBytes && position < size) {
+    uint32_t index = position / blockSize;
+    if (index != blockIndex) {
+      int res = LoadBlock(index);
+      if (res < 0) {
+        return res;
+      }
+    }
+    uint32_t offset = position % blockSize;
+    uint32_t length = std::min<uint32_t>(nbBytes - nbRead, blockLength - offset);
+    std::memcpy(buffer + nbRead, block + offset, length);
+    nbRead += length;
+    position += length;
+  }
+  return static_cast<int>(nbRead);
+}
+
+int CompressedFile::Seek(uint32_t newPosition) {
+  if (block == nullptr) {
+    return fs->FileSeek(&file, newPosition);
+  }
+  position = std::min(newPosition, size);
+  return LFS_ERR_OK;
+}
+
+int CompressedFile::LoadBlock(uint32_t index) {
+  blockIndex = noBlock;
+
+  uint8_t offsets[8];
+  int res = fs->FileSeek(&file, headerSize + index * 4);
+  if (res < 0) {
+    return res;
+  }
+  if (fs->FileRead(&file, offsets, sizeof(offsets)) != sizeof(offsets)) {
+    return LFS_ERR_CORRUPT;
+  }
+  uint32_t start = ReadUint32(offsets);
+  uint32_t end = ReadUint32(offsets + 4);
+  auto length = static_cast<uint16_t>(std::min<uint32_t>(blockSize, size - index * blockSize));
+  if (end < start || end - start > length) {
+    return LFS_ERR_CORRUPT;
+  }
+  uint32_t encodedSize = end - start;
+
+  res = fs->FileSeek(&file, headerSize + (nbBlocks + 1) * 4 + start);
+  if (res < 0) {
+    return res;
+  }
+  uint8_t* encoded = (encodedSize == length) ? block : block + blockBufferSize - encodedSize;
+  if (fs->FileRead(&file, encoded, encodedSize) != static_cast<int>(encodedSize)) {
+    return LFS_ERR_CORRUPT;
+  }
+  if (encodedSize != length && Pinetime::Tools::Lz4Decoder::Decode(encoded, encodedSize, block, length) != length) {
+    return LFS_ERR_CORRUPT;
+  }
+
+  blockIndex = index;
+  blockLength = length;
+  return LFS_ERR_OK;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <littlefs/lfs.h>
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+
+    // Read only access to a resource file, decompressed on the fly if generate-package.py compressed it.
+    //
+    // Compressed files are split in blocks that are compressed independently (LZ4 block format), so that a seek only
+    // costs the decoding of the block it lands in. The block being read is kept in a buffer allocated while the file is
+    // open. Layout, little endian:
+    //   magic "ITZ4" | uncompressed size (u32) | block size (u16) | reserved (u16)
+    //   offsets of the blocks relative to the end of the offsets, plus the end of the last block (u32 each)
+    //   blocks, a block as long as its uncompressed data is stored as is
+    class CompressedFile {
+    public:
+      static constexpr uint16_t maxBlockSize = 4096;
+
+      CompressedFile() = default;
+      CompressedFile(const CompressedFile&) = delete;
+      CompressedFile& operator=(const CompressedFile&) = delete;
+      CompressedFile(CompressedFile&&) = delete;
+      CompressedFile& operator=(CompressedFile&&) = delete;
+
+      // Returns a littlefs error code, LFS_ERR_ISDIR if path is not a file
+      int Open(FS& fs, const char* path);
+      int Close();
+      // Returns the number of bytes read, or a littlefs error code
+      int Read(uint8_t* buffer, uint32_t nbBytes);
+      int Seek(uint32_t newPosition);
+
+      bool IsCompressed() const {
+        return block != nullptr;
+      }
+
+    private:
+      static constexpr size_t headerSize = 12;
+      static constexpr uint32_t noBlock = UINT32_MAX;
+
+      FS* fs = nullptr;
+      lfs_file_t file;
+      // Uncompressed size and read position of a compressed file
+      uint32_t size = 0;
+      uint32_t position = 0;
+      uint16_t blockSize = 0;
+      uint32_t nbBlocks = 0;
+      uint8_t* block = nullptr;
+      size_t blockBufferSize = 0;
+      uint32_t blockIndex = noBlock;
+      uint16_t blockLength = 0;
+
+      int LoadBlock(uint32_t index);
+    };
+  }
+}
@@ -1,10 +1,32 @@
 #include "components/fs/FS.h"
+#include <algorithm>
 #include <cstring>
 #include <littlefs/lfs.h>
-#include <lvgl/lvgl.h>
+#include <task.h>
+#include "components/crc/Crc.h"
+#include "components/fs/ResourceInstaller.h"
 
 using namespace Pinetime::Controllers;
 
+namespace {
+  class Lock {
+  public:
+    explicit Lock(SemaphoreHandle_t mutex) : mutex {mutex} {
+      xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+
+    ~Lock() {
+      xSemaphoreGive(mutex);
+    }
+
+    Lock(const Lock&) = delete;
+    Lock& operator=(const Lock&) = delete;
+
+  private:
+    SemaphoreHandle_t mutex;
+  };
+}
+
 FS::FS(Pinetime::Drivers::SpiNorFlash& driver)
   : flashDriver {driver},
     lfsConfig {
@@ -29,17 +51,24 @@ FS::FS(Pinetime::Drivers::SpiNorFlash& driver)
 }
 
 void FS::Init() {
+  if (mutex == nullptr) {
+    mutex = xSemaphoreCreateMutex();
+    ASSERT(mutex != nullptr);
+  }
 
-  // try mount
-  int err = lfs_mount(&lfs, &lfsConfig);
+  {
+    Lock lock {mutex};
+    // try mount
+    int err = lfs_mount(&lfs, &lfsConfig);
 
-  // reformat if we can't mount the filesystem
-  // this should only happen on the first boot
-  if (err != LFS_ERR_OK) {
-    lfs_format(&lfs, &lfsConfig);
-    err = lfs_mount(&lfs, &lfsConfig);
+    // reformat if we can't mount the filesystem
+    // this should only happen on the first boot
     if (err != LFS_ERR_OK) {
-      return;
+      lfs_format(&lfs, &lfsConfig);
+      err = lfs_mount(&lfs, &lfsConfig);
+      if (err != LFS_ERR_OK) {
+        return;
+      }
     }
   }
 
@@ -49,66 +78,180 @@ void FS::Init() {
 }
 
 void FS::VerifyResource() {
-  // validate the resource metadata
-  resourcesValid = true;
+  // Finish the install of a resource archive interrupted by a reset
+  resourcesValid = ResourceInstaller::Recover(*this) >= 0;
 }
 
 int FS::FileOpen(lfs_file_t* file_p, const char* fileName, const int flags) {
+  Lock lock {mutex};
   return lfs_file_open(&lfs, file_p, fileName, flags);
 }
 
 int FS::FileClose(lfs_file_t* file_p) {
+  Lock lock {mutex};
   return lfs_file_close(&lfs, file_p);
 }
 
 int FS::FileRead(lfs_file_t* file_p, uint8_t* buff, uint32_t size) {
+  Lock lock {mutex};
   return lfs_file_read(&lfs, file_p, buff, size);
 }
 
 int FS::FileWrite(lfs_file_t* file_p, const uint8_t* buff, uint32_t size) {
+  Lock lock {mutex};
   return lfs_file_write(&lfs, file_p, buff, size);
 }
 
 int FS::FileSeek(lfs_file_t* file_p, uint32_t pos) {
+  Lock lock {mutex};
   return lfs_file_seek(&lfs, file_p, pos, LFS_SEEK_SET);
 }
 
+int FS::FileSync(lfs_file_t* file_p) {
+  Lock lock {mutex};
+  return lfs_file_sync(&lfs, file_p);
+}
+
+int FS::FileTruncate(lfs_file_t* file_p, uint32_t size) {
+  Lock lock {mutex};
+  return lfs_file_truncate(&lfs, file_p, size);
+}
+
+int FS::FileSize(lfs_file_t* file_p) {
+  Lock lock {mutex};
+  return lfs_file_size(&lfs, file_p);
+}
+
 int FS::FileDelete(const char* fileName) {
+  Lock lock {mutex};
   return lfs_remove(&lfs, fileName);
 }
 
 int FS::DirOpen(const char* path, lfs_dir_t* lfs_dir) {
+  Lock lock {mutex};
   return lfs_dir_open(&lfs, lfs_dir, path);
 }
 
 int FS::DirClose(lfs_dir_t* lfs_dir) {
+  Lock lock {mutex};
   return lfs_dir_close(&lfs, lfs_dir);
 }
 
 int FS::DirRead(lfs_dir_t* dir, lfs_info* info) {
+  Lock lock {mutex};
   return lfs_dir_read(&lfs, dir, info);
 }
 
 int FS::DirRewind(lfs_dir_t* dir) {
+  Lock lock {mutex};
   return lfs_dir_rewind(&lfs, dir);
 }
 
 int FS::DirCreate(const char* path) {
+  Lock lock {mutex};
   return lfs_mkdir(&lfs, path);
 }
 
 int FS::Rename(const char* oldPath, const char* newPath) {
+  Lock lock {mutex};
   return lfs_rename(&lfs, oldPath, newPath);
 }
 
 int FS::Stat(const char* path, lfs_info* info) {
+  Lock lock {mutex};
   return lfs_stat(&lfs, path, info);
 }
 
 lfs_ssize_t FS::GetFSSize() {
+  Lock lock {mutex};
   return lfs_fs_size(&lfs);
 }
 
+bool FS::EraseAhead() {
+  lfs_block_t block = noBlock;
+  {
+    Lock lock {mutex};
+    std::array<lfs_block_t, maxErasedAhead> nextBlocks;
+    const size_t nbNextBlocks = NextFreeBlocks(nextBlocks);
+    const auto nextEnd = nextBlocks.cbegin() + nbNextBlocks;
+
+    taskENTER_CRITICAL();
+    // Forgets the blocks that are no longer among the next ones (the allocation went on in another window): they stay
+    // erased but littlefs will erase them again
+    auto erasedEnd = std::remove_if(erasedAhead.begin(), erasedAhead.begin() + nbErasedAhead, [&](lfs_block_t erased) {
+      return std::find(nextBlocks.cbegin(), nextEnd, erased) == nextEnd;
+    });
+    nbErasedAhead = erasedEnd - erasedAhead.begin();
+    for (auto next = nextBlocks.cbegin(); next != nextEnd; next++) {
+      if (std::find(erasedAhead.begin(), erasedEnd, *next) == erasedEnd) {
+        block = *next;
+        break;
+      }
+    }
+    erasingAhead = block;
+    taskEXIT_CRITICAL();
+
+    if (block == noBlock) {
+      return false;
+    }
+    InvalidateCache(startAddress + (block * blockSize), blockSize);
+  }
+
+  // littlefs may allocate the block meanwhile: SectorErase() then waits for this erase, see TakeErasedAhead()
+  flashDriver.SectorErase(startAddress + (block * blockSize));
+  const bool isErased = !flashDriver.EraseFailed();
+
+  taskENTER_CRITICAL();
+  if (isErased && nbErasedAhead < maxErasedAhead) {
+    erasedAhead[nbErasedAhead++] = block;
+  }
+  erasingAhead = noBlock;
+  taskEXIT_CRITICAL();
+  return isErased;
+}
+
+// Called with the mutex held. littlefs allocates the free blocks of its lookahead window in order, from free.i (see
+// lfs_alloc()): the blocks returned are the next ones it will allocate, unless it fills a new window first.
+size_t FS::NextFreeBlocks(std::array<lfs_block_t, maxErasedAhead>& blocks) const {
+  size_t nbBlocks = 0;
+  for (lfs_block_t offset = lfs.free.i; offset < lfs.free.size && nbBlocks < blocks.size(); offset++) {
+    if ((lfs.free.buffer[offset / 32] & (1U << (offset % 32))) == 0) {
+      blocks[nbBlocks++] = (lfs.free.off + offset) % lfsConfig.block_count;
+    }
+  }
+  return nbBlocks;
+}
+
+// Called with the mutex held when littlefs erases the block. Returns true if it is already erased by EraseAhead().
+bool FS::TakeErasedAhead(lfs_block_t block) {
+  while (true) {
+    taskENTER_CRITICAL();
+    const bool isErasing = erasingAhead == block;
+    taskEXIT_CRITICAL();
+    if (!isErasing) {
+      break;
+    }
+    vTaskDelay(1);
+  }
+
+  taskENTER_CRITICAL();
+  auto erasedEnd = erasedAhead.begin() + nbErasedAhead;
+  auto erased = std::find(erasedAhead.begin(), erasedEnd, block);
+  const bool isErased = erased != erasedEnd;
+  if (isErased) {
+    std::copy(erased + 1, erasedEnd, erased);
+    nbErasedAhead--;
+  }
+  taskEXIT_CRITICAL();
+  return isErased;
+}
+
+// Replaces the implementation of lfs_util.c, disabled by lfs_config.h: littlefs computes the CRC of every metadata commit
+// and of the metadata it reads
+extern "C" uint32_t lfs_crc(uint32_t crc, const void* buffer, size_t size) {
+  return Pinetime::Tools::Crc32::Update(crc, buffer, size);
+}
+
 /*
 
     ----------- Interface between littlefs and SpiNorFlash -----------
@@ -121,6 +264,10 @@ int FS::SectorSync(const struct lfs_config* /*c*/) {
 int FS::SectorErase(const struct lfs_config* c, lfs_block_t block) {
   Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
   const size_t address = startAddress + (block * blockSize);
+  lfs.InvalidateCache(address, blockSize);
+  if (lfs.TakeErasedAhead(block)) {
+    return 0;
+  }
   lfs.flashDriver.SectorErase(address);
   return lfs.flashDriver.EraseFailed() ? -1 : 0;
 }
@@ -128,6 +275,7 @@ int FS::SectorErase(const struct lfs_config* c, lfs_block_t block) {
 int FS::SectorProg(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size) {
   Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
   const size_t address = startAddress + (block * blockSize) + off;
+  lfs.InvalidateCache(address, size);
   lfs.flashDriver.Write(address, (uint8_t*) buffer, size);
   return lfs.flashDriver.ProgramFailed() ? -1 : 0;
 }
@@ -135,6 +283,81 @@ int FS::SectorProg(const struct lfs_config* c, lfs_block_t block, lfs_off_t off,
 int FS::SectorRead(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size) {
   Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
   const size_t address = startAddress + (block * blockSize) + off;
-  lfs.flashDriver.Read(address, static_cast<uint8_t*>(buffer), size);
+  lfs.CachedRead(address, static_cast<uint8_t*>(buffer), size);
   return 0;
 }
+
+/*
+
+    ----------- Read cache -----------
+
+*/
+void FS::CachedRead(uint32_t address, uint8_t* buffer, size_t size) {
+  if constexpr (nbCacheLines == 0) {
+    flashDriver.Read(address, buffer, size);
+    return;
+  }
+
+  while (size > 0) {
+    const uint32_t lineAddress = address - (address % cacheLineSize);
+    const size_t offset = address - lineAddress;
+    const size_t chunkSize = std::min(size, cacheLineSize - offset);
+
+    CacheLine* line = FindCacheLine(lineAddress);
+    if (line != nullptr) {
+      readCacheStats.hits++;
+    } else if (chunkSize == cacheLineSize) {
+      // The whole line is requested, caching it would only cost a copy and evict another line
+      readCacheStats.bypasses++;
+      flashDriver.Read(address, buffer, chunkSize);
+    } else {
+      readCacheStats.misses++;
+      line = &FillCacheLine(lineAddress);
+    }
+
+    if (line != nullptr) {
+      std::memcpy(buffer, line->data + offset, chunkSize);
+      line->lastUsed = ++readCacheClock;
+
+      // Sequential access (file data, fonts, images): fetch the next line before it is needed
+      const uint32_t nextLineAddress = lineAddress + cacheLineSize;
+      if (nbCacheLines > 1 && lineAddress == lastReadLine + cacheLineSize && nextLineAddress < startAddress + FS::size &&
+          FindCacheLine(nextLineAddress) == nullptr) {
+        readCacheStats.prefetches++;
+        FillCacheLine(nextLineAddress);
+      }
+    }
+
+    lastReadLine = lineAddress;
+    address += chunkSize;
+    buffer += chunkSize;
+    size -= chunkSize;
+  }
+}
+
+FS::CacheLine* FS::FindCacheLine(uint32_t lineAddress) {
+  for (auto& line : readCache) {
+    if (line.lastUsed != 0 && line.address == lineAddress) {
+      return &line;
+    }
+  }
+  return nullptr;
+}
+
+FS::CacheLine& FS::FillCacheLine(uint32_t lineAddress) {
+  auto& victim = *std::min_element(readCache.begin(), readCache.end(), [](const CacheLine& a, const CacheLine& b) {
+    return a.lastUsed < b.lastUsed;
+  });
+  flashDriver.Read(lineAddress, victim.data, cacheLineSize);
+  victim.address = lineAddress;
+  victim.lastUsed = ++readCacheClock;
+  return victim;
+}
+
+void FS::InvalidateCache(uint32_t address, size_t size) {
+  for (auto& line : readCache) {
+    if (line.address < address + size && address < line.address + cacheLineSize) {
+      line.lastUsed = 0;
+    }
+  }
+}
@@ -1,13 +1,32 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <FreeRTOS.h>
+#include <semphr.h>
 #include "drivers/SpiNorFlash.h"
 #include <littlefs/lfs.h>
 
+#ifndef FS_READ_CACHE_LINES
+  #define FS_READ_CACHE_LINES 4
+#endif
+
 namespace Pinetime {
   namespace Controllers {
+    // littlefs is not thread-safe: every call to it is serialized by a mutex, so that the tasks (DisplayApp reading the
+    // fonts and images, SystemTask saving the settings and the history, NimBLE transferring files) can share the file
+    // system. A file or directory handle must still be used by one task at a time.
+    // The mutex is held while littlefs erases a block (up to 300 ms), which would stall the reads of the other tasks. Free
+    // blocks are erased ahead of their allocation by EraseAhead(), without the mutex: littlefs then skips those erases.
     class FS {
     public:
+      struct ReadCacheStats {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t prefetches;
+        uint32_t bypasses;
+      };
+
       FS(Pinetime::Drivers::SpiNorFlash&);
 
       void Init();
@@ -17,6 +36,9 @@ namespace Pinetime {
       int FileRead(lfs_file_t* file_p, uint8_t* buff, uint32_t size);
       int FileWrite(lfs_file_t* file_p, const uint8_t* buff, uint32_t size);
       int FileSeek(lfs_file_t* file_p, uint32_t pos);
+      int FileSync(lfs_file_t* file_p);
+      int FileTruncate(lfs_file_t* file_p, uint32_t size);
+      int FileSize(lfs_file_t* file_p);
 
       int FileDelete(const char* fileName);
 
@@ -31,6 +53,11 @@ namespace Pinetime {
       int Stat(const char* path, lfs_info* info);
       void VerifyResource();
 
+      // Erases one of the next free blocks littlefs will allocate, without locking the file system (the reads of the other
+      // tasks suspend the erase). Returns false if there is nothing to erase: maxErasedAhead blocks are erased ahead, or
+      // littlefs hasn't looked for free blocks since the mount (it does at the first allocation).
+      bool EraseAhead();
+
       static size_t getSize() {
         return size;
       }
@@ -39,6 +66,10 @@ namespace Pinetime {
         return blockSize;
       }
 
+      const ReadCacheStats& GetReadCacheStats() const {
+        return readCacheStats;
+      }
+
     private:
       Pinetime::Drivers::SpiNorFlash& flashDriver;
 
@@ -72,6 +103,40 @@ namespace Pinetime {
       const struct lfs_config lfsConfig;
 
       lfs_t lfs;
+      SemaphoreHandle_t mutex = nullptr;
+
+      // Blocks erased by EraseAhead() and not allocated yet. Accessed in critical sections: EraseAhead() updates them once
+      // the erase is done, without the mutex.
+      static constexpr size_t maxErasedAhead = 4;
+      static constexpr lfs_block_t noBlock = static_cast<lfs_block_t>(-1);
+      std::array<lfs_block_t, maxErasedAhead> erasedAhead {};
+      size_t nbErasedAhead = 0;
+      lfs_block_t erasingAhead = noBlock;
+
+      size_t NextFreeBlocks(std::array<lfs_block_t, maxErasedAhead>& blocks) const;
+      bool TakeErasedAhead(lfs_block_t block);
+
+      // littlefs reads metadata and file data in small chunks (read_size), each of them costing a full SPI transaction.
+      // Those reads are served from a small LRU cache of flash pages, filled on demand and ahead of sequential reads.
+      static constexpr size_t nbCacheLines = FS_READ_CACHE_LINES;
+      static constexpr size_t cacheLineSize = 256;
+      static_assert(blockSize % cacheLineSize == 0);
+
+      struct CacheLine {
+        uint32_t address;  // Flash address of data[0]
+        uint32_t lastUsed; // 0 if the line is empty
+        uint8_t data[cacheLineSize];
+      };
+
+      std::array<CacheLine, nbCacheLines> readCache {};
+      uint32_t readCacheClock = 0;
+      uint32_t lastReadLine = 0;
+      ReadCacheStats readCacheStats {};
+
+      void CachedRead(uint32_t address, uint8_t* buffer, size_t size);
+      CacheLine* FindCacheLine(uint32_t lineAddress);
+      CacheLine& FillCacheLine(uint32_t lineAddress);
+      void InvalidateCache(uint32_t address, size_t size);
 
       static int SectorSync(const struct lfs_config* c);
       static int SectorErase(const struct lfs_config* c, lfs_block_t block);
@@ -0,0 +1,372 @@
+#include "components/fs/ResourceInstaller.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "components/crc/Crc.h"
+#include "components/fs/FS.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  constexpr uint8_t archiveMagic[] = {'I', 'T', 'R', 'A'};
+  constexpr uint16_t archiveVersion = 1;
+  constexpr uint32_t progressMagic = 0x31504952; // "RIP1"
+  constexpr char stagingPath[] = "/.staging";
+  constexpr char progressPath[] = "/.staging/progress";
+  constexpr const char* trees[] = {"fonts", "images"};
+  constexpr size_t maxStagedPathLength = sizeof(stagingPath) + ResourceInstaller::maxPathLength;
+  // Files of the trees being removed, which may have been created by something else than the installer
+  constexpr size_t maxRemovedPathLength = 128;
+
+  uint32_t ReadUint32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+  }
+
+  uint16_t ReadUint16(const uint8_t* data) {
+    return data[0] | (data[1] << 8);
+  }
+
+  // Absolute path of a file of /fonts or /images, without any hidden or relative component
+  bool IsValidPath(const char* path) {
+    bool isInTree = false;
+    for (const char* tree : trees) {
+      size_t length = std::strlen(tree);
+      isInTree = isInTree || (path[0] == '/' && std::strncmp(path + 1, tree, length) == 0 && path[length + 1] == '/');
+    }
+    return isInTree && std::strstr(path, "/.") == nullptr && std::strstr(path, "//") == nullptr &&
+           path[std::strlen(path) - 1] != '/';
+  }
+}
+
+ResourceInstaller::ResourceInstaller(FS& fs) : fs {fs} {
+}
+
+int ResourceInstaller::Recover(FS& fs) {
+  lfs_file_t progressFile;
+  if (fs.FileOpen(&progressFile, progressPath, LFS_O_RDONLY) < 0) {
+    return LFS_ERR_OK;
+  }
+  Progress saved;
+  bool isSwapping = fs.FileRead(&progressFile, reinterpret_cast<uint8_t*>(&saved), sizeof(saved)) == sizeof(saved) &&
+                    saved.magic == progressMagic && saved.state == State::Swapping;
+  fs.FileClose(&progressFile);
+  return isSwapping ? Swap(fs) : LFS_ERR_OK;
+}
+
+int ResourceInstaller::Begin(uint32_t archiveSize, uint32_t archiveId) {
+  Suspend();
+
+  Progress saved;
+  bool canResume = false;
+  lfs_file_t progressFile;
+  if (fs.FileOpen(&progressFile, progressPath, LFS_O_RDONLY) >= 0) {
+    canResume = fs.FileRead(&progressFile, reinterpret_cast<uint8_t*>(&saved), sizeof(saved)) == sizeof(saved) &&
+                saved.magic == progressMagic;
+    fs.FileClose(&progressFile);
+  }
+  if (canResume && saved.state == State::Swapping) {
+    // The staged trees must not be deleted before the swap is finished
+    int res = Swap(fs);
+    if (res < 0) {
+      return res;
+    }
+    canResume = false;
+  }
+  canResume = canResume && saved.archiveId == archiveId && saved.archiveSize == archiveSize;
+
+  if (!canResume) {
+    int res = RemoveTree(fs, stagingPath);
+    if (res < 0 && res != LFS_ERR_NOENT) {
+      return res;
+    }
+    if ((res = fs.DirCreate(stagingPath)) < 0) {
+      return res;
+    }
+    saved = {};
+    saved.magic = progressMagic;
+    saved.archiveId = archiveId;
+    saved.archiveSize = archiveSize;
+    saved.state = State::ArchiveHeader;
+  }
+
+  progress = saved;
+  savedOffset = progress.offset;
+  headerLength = 0;
+  int res = (progress.state == State::FileData) ? OpenFile(true) : LFS_ERR_OK;
+  if (res >= 0 && !canResume) {
+    res = Save();
+  }
+  if (res < 0) {
+    return res;
+  }
+  isActive = true;
+  return static_cast<int>(progress.offset);
+}
+
+int ResourceInstaller::Write(const uint8_t* data, uint32_t size) {
+  if (!isActive) {
+    return LFS_ERR_INVAL;
+  }
+
+  while (size > 0) {
+    uint32_t length;
+    int res = LFS_ERR_OK;
+    switch (progress.state) {
+      case State::ArchiveHeader:
+      case State::FileHeader: {
+        size_t expected = archiveHeaderSize;
+        if (progress.state == State::FileHeader) {
+          // The path follows the fixed part of the header, its length is known once the fixed part is received
+          expected = (headerLength < fileHeaderSize) ? fileHeaderSize : fileHeaderSize + header[fileHeaderSize - 1];
+        }
+        length = std::min<uint32_t>(size, expected - headerLength);
+        std::memcpy(header + headerLength, data, length);
+        headerLength += length;
+        progress.offset += length;
+        if (progress.state == State::FileHeader && headerLength == fileHeaderSize &&
+            (header[fileHeaderSize - 1] == 0 || header[fileHeaderSize - 1] > maxPathLength)) {
+          res = (header[fileHeaderSize - 1] == 0) ? LFS_ERR_INVAL : LFS_ERR_NAMETOOLONG;
+        } else if (headerLength == expected && (progress.state == State::ArchiveHeader || expected > fileHeaderSize)) {
+          headerLength = 0;
+          res = (progress.state == State::ArchiveHeader) ? OnArchiveHeader() : OnFileHeader();
+        }
+        break;
+      }
+      case State::FileData:
+        length = std::min(size, progress.fileSize - progress.fileOffset);
+        if ((res = fs.FileWrite(&file, data, length)) < 0) {
+          break;
+        }
+        progress.crc = Pinetime::Tools::Crc32::Update(progress.crc, data, length);
+        progress.fileOffset += length;
+        progress.offset += length;
+        if (progress.fileOffset == progress.fileSize) {
+          res = CloseFile();
+        } else if (progress.offset - savedOffset >= saveInterval) {
+          res = Save();
+        }
+        break;
+      default:
+        // Data after the end of the archive
+        length = size;
+        res = LFS_ERR_INVAL;
+        break;
+    }
+    if (res < 0) {
+      // The transfer resumes from the last save
+      Abort();
+      return res;
+    }
+    data += length;
+    size -= length;
+  }
+  return LFS_ERR_OK;
+}
+
+int ResourceInstaller::Finish() {
+  if (!isActive || progress.state != State::Complete || progress.offset != progress.archiveSize) {
+    return LFS_ERR_INVAL;
+  }
+  isActive = false;
+  progress.state = State::Swapping;
+  int res = Save();
+  return (res < 0) ? res : Swap(fs);
+}
+
+void ResourceInstaller::Suspend() {
+  if (!isActive) {
+    return;
+  }
+  isActive = false;
+  // A header is received again from its beginning
+  progress.offset -= headerLength;
+  headerLength = 0;
+  Save();
+  Abort();
+}
+
+void ResourceInstaller::Abort() {
+  isActive = false;
+  if (isFileOpen) {
+    fs.FileClose(&file);
+    isFileOpen = false;
+  }
+}
+
+int ResourceInstaller::OnArchiveHeader() {
+  if (std::memcmp(header, archiveMagic, sizeof(archiveMagic)) != 0 || ReadUint16(header + 4) != archiveVersion) {
+    return LFS_ERR_INVAL;
+  }
+  progress.nbFiles = ReadUint16(header + 6);
+  progress.fileStart = progress.offset;
+  progress.state = (progress.nbFiles > 0) ? State::FileHeader : State::Complete;
+  return Save();
+}
+
+int ResourceInstaller::OnFileHeader() {
+  progress.fileSize = ReadUint32(header);
+  progress.fileCrc = ReadUint32(header + 4);
+  progress.pathLength = header[8];
+  std::memcpy(progress.path, header + fileHeaderSize, progress.pathLength);
+  progress.path[progress.pathLength] = '\0';
+  if (!IsValidPath(progress.path)) {
+    return LFS_ERR_INVAL;
+  }
+  progress.fileOffset = 0;
+  progress.crc = Pinetime::Tools::Crc32::initialValue;
+  progress.state = State::FileData;
+  int res = OpenFile(false);
+  if (res >= 0 && progress.fileSize == 0) {
+    res = CloseFile();
+  }
+  return res;
+}
+
+int ResourceInstaller::OpenFile(bool isResuming) {
+  char path[maxStagedPathLength];
+  std::snprintf(path, sizeof(path), "%s%s", stagingPath, progress.path);
+  int res = isResuming ? LFS_ERR_OK : CreateParents(fs, path);
+  if (res < 0) {
+    return res;
+  }
+  res = fs.FileOpen(&file, path, LFS_O_WRONLY | LFS_O_CREAT | (isResuming ? 0 : LFS_O_TRUNC));
+  if (res < 0) {
+    return res;
+  }
+  // Drops the data written after the last save
+  if (isResuming && ((res = fs.FileTruncate(&file, progress.fileOffset)) < 0 || (res = fs.FileSeek(&file, progress.fileOffset)) < 0)) {
+    fs.FileClose(&file);
+    return res;
+  }
+  isFileOpen = true;
+  return LFS_ERR_OK;
+}
+
+int ResourceInstaller::CloseFile() {
+  isFileOpen = false;
+  int res = fs.FileClose(&file);
+  if (res < 0) {
+    return res;
+  }
+  if ((progress.crc ^ 0xffffffff) != progress.fileCrc) {
+    // The file is sent again
+    progress.offset = progress.fileStart;
+    progress.state = State::FileHeader;
+    Save();
+    return LFS_ERR_CORRUPT;
+  }
+  progress.fileIndex++;
+  progress.fileStart = progress.offset;
+  progress.state = (progress.fileIndex == progress.nbFiles) ? State::Complete : State::FileHeader;
+  return Save();
+}
+
+int ResourceInstaller::Save() {
+  // The data written must be committed before the progress that accounts for it
+  int res = isFileOpen ? fs.FileSync(&file) : LFS_ERR_OK;
+  if (res < 0) {
+    return res;
+  }
+  lfs_file_t progressFile;
+  if ((res = fs.FileOpen(&progressFile, progressPath, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC)) < 0) {
+    return res;
+  }
+  res = fs.FileWrite(&progressFile, reinterpret_cast<const uint8_t*>(&progress), sizeof(progress));
+  int closeRes = fs.FileClose(&progressFile);
+  if (res < 0 || closeRes < 0) {
+    return (res < 0) ? res : closeRes;
+  }
+  savedOffset = progress.offset;
+  return LFS_ERR_OK;
+}
+
+// Each step can be run again if the watch resets in the middle of the swap
+int ResourceInstaller::Swap(FS& fs) {
+  for (const char* tree : trees) {
+    char staged[24];
+    char current[16];
+    char old[24];
+    std::snprintf(staged, sizeof(staged), "%s/%s", stagingPath, tree);
+    std::snprintf(current, sizeof(current), "/%s", tree);
+    std::snprintf(old, sizeof(old), "%s/old-%s", stagingPath, tree);
+
+    lfs_info info;
+    if (fs.Stat(staged, &info) < 0) {
+      continue;
+    }
+    int res = LFS_ERR_OK;
+    if (fs.Stat(current, &info) >= 0 && (res = fs.Rename(current, old)) < 0) {
+      return res;
+    }
+    if ((res = fs.Rename(staged, current)) < 0) {
+      return res;
+    }
+  }
+  // The previous trees and the progress file
+  return RemoveTree(fs, stagingPath);
+}
+
+int ResourceInstaller::RemoveTree(FS& fs, const char* root) {
+  char path[maxRemovedPathLength];
+  const size_t rootLength = std::strlen(root);
+  if (rootLength >= sizeof(path)) {
+    return LFS_ERR_NAMETOOLONG;
+  }
+  std::strcpy(path, root);
+
+  lfs_info info;
+  int res = fs.Stat(path, &info);
+  if (res < 0 || info.type != LFS_TYPE_DIR) {
+    return (res < 0) ? res : fs.FileDelete(path);
+  }
+
+  // Depth first, without recursion
+  while (true) {
+    lfs_dir_t dir;
+    if ((res = fs.DirOpen(path, &dir)) < 0) {
+      return res;
+    }
+    // The entries are removed one at a time, removing them while the directory is read could skip some
+    bool isEmpty = true;
+    while (isEmpty && (res = fs.DirRead(&dir, &info)) > 0) {
+      isEmpty = std::strcmp(info.name, ".") == 0 || std::strcmp(info.name, "..") == 0;
+    }
+    fs.DirClose(&dir);
+    if (res < 0) {
+      return res;
+    }
+
+    size_t length = std::strlen(path);
+    if (isEmpty) {
+      if ((res = fs.FileDelete(path)) < 0 || length == rootLength) {
+        return res;
+      }
+      *std::strrchr(path, '/') = '\0';
+      continue;
+    }
+    if (length + 1 + std::strlen(info.name) >= sizeof(path)) {
+      return LFS_ERR_NAMETOOLONG;
+    }
+    path[length] = '/';
+    std::strcpy(path + length + 1, info.name);
+    if (info.type == LFS_TYPE_DIR) {
+      continue;
+    }
+    if ((res = fs.FileDelete(path)) < 0) {
+      return res;
+    }
+    path[length] = '\0';
+  }
+}
+
+int ResourceInstaller::CreateParents(FS& fs, char* path) {
+  for (char* separator = std::strchr(path + 1, '/'); separator != nullptr; separator = std::strchr(separator + 1, '/')) {
+    *separator = '\0';
+    int res = fs.DirCreate(path);
+    *separator = '/';
+    if (res < 0 && res != LFS_ERR_EXIST) {
+      return res;
+    }
+  }
+  return LFS_ERR_OK;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <littlefs/lfs.h>
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+
+    // Installs a resource archive built by generate-package.py (--archive) received as a stream of bytes.
+    //
+    // The files are written into /.staging, where each of them is checked against its CRC32. The progress is saved in
+    // /.staging/progress at the end of each file and every 4 KB, so that an interrupted transfer resumes from the last
+    // saved block. When the whole archive is received, the /fonts and /images trees of the archive replace the current
+    // ones. The swap is recorded in the progress file first, and finished by Recover() if the watch resets meanwhile.
+    // Layout of the archive, little endian:
+    //   magic "ITRA" | version (u16) | number of files (u16)
+    //   for each file: size (u32) | CRC32 (u32) | path length (u8) | absolute path in /fonts or /images | data
+    class ResourceInstaller {
+    public:
+      static constexpr size_t maxPathLength = 63;
+
+      explicit ResourceInstaller(FS& fs);
+      ResourceInstaller(const ResourceInstaller&) = delete;
+      ResourceInstaller& operator=(const ResourceInstaller&) = delete;
+      ResourceInstaller(ResourceInstaller&&) = delete;
+      ResourceInstaller& operator=(ResourceInstaller&&) = delete;
+
+      // Called at boot: finishes a swap interrupted by a reset. Returns a littlefs error code if it failed.
+      static int Recover(FS& fs);
+
+      // Returns the offset in the archive from which it must be sent (> 0 resumes an interrupted install of the same
+      // archive), or a littlefs error code
+      int Begin(uint32_t archiveSize, uint32_t archiveId);
+      // Returns a littlefs error code, LFS_ERR_CORRUPT if a file doesn't match its CRC32
+      int Write(const uint8_t* data, uint32_t size);
+      // Called once the whole archive is written, swaps the trees
+      int Finish();
+      // Saves the progress of an interrupted transfer
+      void Suspend();
+
+    private:
+      static constexpr size_t archiveHeaderSize = 8;
+      static constexpr size_t fileHeaderSize = 9;
+      static constexpr uint32_t saveInterval = 4096;
+
+      enum class State : uint8_t { ArchiveHeader, FileHeader, FileData, Complete, Swapping };
+
+      // Saved as is in the progress file
+      struct Progress {
+        uint32_t magic;
+        uint32_t archiveId;
+        uint32_t archiveSize;
+        uint32_t offset;    // In the archive
+        uint32_t fileStart; // Offset of the header of the current file, where the transfer resumes if its CRC32 is wrong
+        uint16_t nbFiles;
+        uint16_t fileIndex;
+        State state;
+        uint8_t pathLength;
+        uint16_t padding;
+        uint32_t fileSize;
+        uint32_t fileCrc;
+        uint32_t fileOffset; // Bytes of the current file written
+        uint32_t crc;        // Of the bytes written, see Crc32::Update()
+        char path[maxPathLength + 1];
+      };
+
+      FS& fs;
+      Progress progress {};
+      bool isActive = false;
+      bool isFileOpen = false;
+      lfs_file_t file;
+      uint32_t savedOffset = 0;
+      // Header being received, the progress is never saved in the middle of a header
+      uint8_t header[fileHeaderSize + maxPathLength];
+      size_t headerLength = 0;
+
+      int OnArchiveHeader();
+      int OnFileHeader();
+      int OpenFile(bool isResuming);
+      int CloseFile();
+      int Save();
+      void Abort();
+
+      static int Swap(FS& fs);
+      static int RemoveTree(FS& fs, const char* path);
+      static int CreateParents(FS& fs, char* path);
+    };
+  }
+}
@@ -5,10 +5,15 @@
 using namespace Pinetime::Controllers;
 
 void HeartRateController::Update(HeartRateController::States newState, uint8_t heartRate) {
+  bool isChanged = this->state != newState;
   this->state = newState;
   if (this->heartRate != heartRate) {
     this->heartRate = heartRate;
     service->OnNewHeartRateValue(heartRate);
+    isChanged = true;
+  }
+  if (isChanged) {
+    changeNotifier.Publish(ChangeNotifier::Topic::HeartRate);
   }
 }
 
@@ -16,6 +21,7 @@ void HeartRateController::Enable() {
   if (task != nullptr) {
     state = States::NotEnoughData;
     task->PushMessage(Pinetime::Applications::HeartRateTask::Messages::Enable);
+    changeNotifier.Publish(ChangeNotifier::Topic::HeartRate);
   }
 }
 
@@ -23,6 +29,7 @@ void HeartRateController::Disable() {
   if (task != nullptr) {
     state = States::Stopped;
     task->PushMessage(Pinetime::Applications::HeartRateTask::Messages::Disable);
+    changeNotifier.Publish(ChangeNotifier::Topic::HeartRate);
   }
 }
 
@@ -1,145 +1,226 @@
 #include "components/heartrate/Ppg.h"
-#include <nrf_log.h>
-#include <vector>
+#include <algorithm>
 
 using namespace Pinetime::Controllers;
 
 namespace {
-  float LinearInterpolation(const float* xValues, const float* yValues, int length, float pointX) {
-    if (pointX > xValues[length - 1]) {
-      return yValues[length - 1];
-    } else if (pointX <= xValues[0]) {
-      return yValues[0];
-    }
-    int index = 0;
-    while (pointX > xValues[index] && index < length - 1) {
-      index++;
-    }
-    float pointX0 = xValues[index - 1];
-    float pointX1 = xValues[index];
-    float pointY0 = yValues[index - 1];
-    float pointY1 = yValues[index];
-    float mu = (pointX - pointX0) / (pointX1 - pointX0);
+  // Q15 and Q31 helpers. The 32x32->64 bits products map to a single SMULL on the Cortex-M4.
+  constexpr int q15Bits = 15;
+  constexpr int q31Bits = 31;
 
-    return (pointY0 * (1 - mu) + pointY1 * mu);
+  int32_t MulQ15(int32_t a, int32_t b) {
+    return static_cast<int32_t>((static_cast<int64_t>(a) * b + (1 << (q15Bits - 1))) >> q15Bits);
   }
 
-  float PeakSearch(float* xVals, float* yVals, float threshold, float& width, float start, float end, int length) {
-    int peaks = 0;
-    bool enabled = false;
-    float minBin = 0.0f;
-    float maxBin = 0.0f;
-    float peakCenter = 0.0f;
-    float prevValue = LinearInterpolation(xVals, yVals, length, start - 0.01f);
-    float currValue = LinearInterpolation(xVals, yVals, length, start);
-    float idx = start;
-    while (idx < end) {
-      float nextValue = LinearInterpolation(xVals, yVals, length, idx + 0.01f);
-      if (currValue < threshold) {
-        enabled = true;
-      }
-      if (currValue >= threshold and enabled) {
-        if (prevValue < threshold) {
-          minBin = idx;
-        } else if (nextValue <= threshold) {
-          maxBin = idx;
-          peaks++;
-          width = maxBin - minBin;
-          peakCenter = width / 2.0f + minBin;
-        }
-      }
-      prevValue = currValue;
-      currValue = nextValue;
-      idx += 0.01f;
+  int32_t MulQ31(int32_t a, int32_t b) {
+    return static_cast<int32_t>((static_cast<int64_t>(a) * b) >> q31Bits);
+  }
+
+  uint32_t SquareRoot(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit = static_cast<uint64_t>(1) << 62;
+    while (bit > value) {
+      bit >>= 2;
     }
-    if (peaks != 1) {
-      width = 0.0f;
-      peakCenter = 0.0f;
+    while (bit != 0) {
+      if (value >= result + bit) {
+        value -= result + bit;
+        result = (result >> 1) + bit;
+      } else {
+        result >>= 1;
+      }
+      bit >>= 2;
     }
-    return peakCenter;
+    return static_cast<uint32_t>(result);
   }
 
-  float SpectrumMean(const std::array<float, Ppg::spectrumLength>& signal, int start, int end) {
-    int total = 0;
-    float mean = 0.0f;
-    for (int idx = start; idx < end; idx++) {
-      mean += signal.at(idx);
-      total++;
+  // Number of bits needed to hold the magnitude of every value of the signal
+  int SignalBits(const std::array<int32_t, Ppg::dataLength>& signal) {
+    uint32_t max = 0;
+    for (int32_t value : signal) {
+      max = std::max(max, static_cast<uint32_t>(value < 0 ? -value : value));
     }
-    if (total > 0) {
-      mean /= static_cast<float>(total);
+    int bits = 0;
+    while (max != 0) {
+      max >>= 1;
+      bits++;
     }
-    return mean;
+    return bits;
   }
 
-  float SignalToNoise(const std::array<float, Ppg::spectrumLength>& signal, int start, int end, float max) {
-    float mean = SpectrumMean(signal, start, end);
-    return max / mean;
+  // Removes the line going through the first and last samples and takes the first difference.
+  // The result has 16 - shift fractional bits, shift being chosen so that it fits in 23 bits.
+  int Detrend(const std::array<uint16_t, Ppg::dataLength>& data, std::array<int32_t, Ppg::dataLength>& signal) {
+    constexpr int size = Ppg::dataLength;
+    int64_t slope = (static_cast<int64_t>(data.back() - data.front()) << 16) / (size - 1);
+    auto difference = [&data, slope](int idx) {
+      return (static_cast<int64_t>(data[idx + 1] - data[idx]) << 16) - slope;
+    };
+    uint64_t max = 0;
+    for (int idx = 0; idx < size - 1; idx++) {
+      int64_t value = difference(idx);
+      max = std::max<uint64_t>(max, value < 0 ? -value : value);
+    }
+    int shift = 0;
+    while ((max >> shift) >= (1 << 23)) {
+      shift++;
+    }
+    for (int idx = 0; idx < size - 1; idx++) {
+      signal[idx] = static_cast<int32_t>(difference(idx) >> shift);
+    }
+    signal[size - 1] = 0;
+    return shift;
   }
 
   // Simple bandpass filter using exponential moving average
-  void Filter30to240(std::array<float, Ppg::dataLength>& signal) {
+  void Filter30to240(std::array<int32_t, Ppg::dataLength>& signal) {
     // From:
     // https://www.norwegiancreations.com/2016/03/arduino-tutorial-simple-high-pass-band-pass-and-band-stop-filtering/
 
-    int length = signal.size();
-    // 0.268 is ~0.5Hz and 0.816 is ~4Hz cutoff at 10Hz sampling
-    float expAlpha = 0.816f;
-    float expAvg = 0.0f;
+    // 0.268 is ~0.5Hz and 0.816 is ~4Hz cutoff at 10Hz sampling (Q15)
+    // Each high pass at most doubles the amplitude: 4 passes need 4 bits of headroom.
+    constexpr int32_t lowPassAlpha = 26739;
+    constexpr int32_t highPassAlpha = 8782;
     for (int loop = 0; loop < 4; loop++) {
-      expAvg = signal.front();
-      for (int idx = 0; idx < length; idx++) {
-        expAvg = (expAlpha * signal.at(idx)) + ((1 - expAlpha) * expAvg);
-        signal[idx] = expAvg;
+      int32_t expAvg = signal.front();
+      for (auto& value : signal) {
+        expAvg += MulQ15(lowPassAlpha, value - expAvg);
+        value = expAvg;
       }
     }
-    expAlpha = 0.268f;
     for (int loop = 0; loop < 4; loop++) {
-      expAvg = signal.front();
-      for (int idx = 0; idx < length; idx++) {
-        expAvg = (expAlpha * signal.at(idx)) + ((1 - expAlpha) * expAvg);
-        signal[idx] -= expAvg;
+      int32_t expAvg = signal.front();
+      for (auto& value : signal) {
+        expAvg += MulQ15(highPassAlpha, value - expAvg);
+        value -= expAvg;
       }
     }
   }
 
-  float SpectrumMax(const std::array<float, Ppg::spectrumLength>& data, int start, int end) {
-    float max = 0.0f;
-    for (int idx = start; idx < end; idx++) {
-      if (data.at(idx) > max) {
-        max = data.at(idx);
+  // Hanning Coefficients from numpy: python -c 'import numpy;print(numpy.round(numpy.hanning(64) * 32768))'
+  // Note: Harcoded and must be updated if constexpr dataLength is changed.
+  // This data is symetrical so just using the first half.
+  constexpr int16_t hanning[Ppg::dataLength >> 1] {
+    0,     81,    325,   728,   1287,  1995,  2847,  3833,  4944,  6169,  7495,  8909,  10398, 11947, 13539, 15160,
+    16792, 18421, 20030, 21602, 23123, 24576, 25948, 27225, 28394, 29444, 30364, 31145, 31780, 32261, 32585, 32748};
+
+  // cos(2 * pi * k / 64) and sin(2 * pi * k / 64) for k in [0, 32[, Q31
+  constexpr int32_t twiddleCos[Ppg::dataLength >> 1] {
+    2147483647,  2137142927,  2106220352,  2055013723,  1984016189,  1893911494,  1785567396,  1660027308,
+    1518500250,  1362349204,  1193077991,  1012316784,  821806413,   623381598,   418953276,   210490206,
+    0,           -210490206,  -418953276,  -623381598,  -821806413,  -1012316784, -1193077991, -1362349204,
+    -1518500250, -1660027308, -1785567396, -1893911494, -1984016189, -2055013723, -2106220352, -2137142927};
+  constexpr int32_t twiddleSin[Ppg::dataLength >> 1] {
+    0,          210490206,  418953276,  623381598,  821806413,  1012316784, 1193077991, 1362349204,
+    1518500250, 1660027308, 1785567396, 1893911494, 1984016189, 2055013723, 2106220352, 2137142927,
+    2147483647, 2137142927, 2106220352, 2055013723, 1984016189, 1893911494, 1785567396, 1660027308,
+    1518500250, 1362349204, 1193077991, 1012316784, 821806413,  623381598,  418953276,  210490206};
+
+  // In place radix-2 forward FFT. Each stage is scaled by 1/2 so the output is the DFT divided by dataLength.
+  // The input magnitude must be lower than 2^29.
+  void Fft(std::array<int32_t, Ppg::dataLength>& real, std::array<int32_t, Ppg::dataLength>& imag) {
+    constexpr int size = Ppg::dataLength;
+    for (int idx = 1, reversed = 0; idx < size; idx++) {
+      int bit = size >> 1;
+      for (; reversed & bit; bit >>= 1) {
+        reversed ^= bit;
+      }
+      reversed ^= bit;
+      if (idx < reversed) {
+        std::swap(real[idx], real[reversed]);
+        std::swap(imag[idx], imag[reversed]);
+      }
+    }
+    for (int length = 2; length <= size; length <<= 1) {
+      int step = size / length;
+      for (int start = 0; start < size; start += length) {
+        for (int k = 0; k < length / 2; k++) {
+          int top = start + k;
+          int bottom = top + length / 2;
+          int32_t cos = twiddleCos[k * step];
+          int32_t sin = twiddleSin[k * step];
+          int32_t tReal = MulQ31(real[bottom], cos) + MulQ31(imag[bottom], sin);
+          int32_t tImag = MulQ31(imag[bottom], cos) - MulQ31(real[bottom], sin);
+          real[bottom] = (real[top] - tReal) >> 1;
+          imag[bottom] = (imag[top] - tImag) >> 1;
+          real[top] = (real[top] + tReal) >> 1;
+          imag[top] = (imag[top] + tImag) >> 1;
+        }
       }
     }
-    return max;
   }
 
-  void Detrend(std::array<float, Ppg::dataLength>& signal) {
-    int size = signal.size();
-    float offset = signal.front();
-    float slope = (signal.at(size - 1) - offset) / static_cast<float>(size - 1);
+  uint32_t SpectrumMax(const std::array<uint32_t, Ppg::spectrumLength>& data, int start, int end) {
+    return *std::max_element(data.begin() + start, data.begin() + end);
+  }
 
-    for (int idx = 0; idx < size; idx++) {
-      signal[idx] -= (slope * static_cast<float>(idx) + offset);
-    }
-    for (int idx = 0; idx < size - 1; idx++) {
-      signal[idx] = signal[idx + 1] - signal[idx];
+  uint64_t SpectrumSum(const std::array<uint32_t, Ppg::spectrumLength>& data, int start, int end) {
+    uint64_t sum = 0;
+    for (int idx = start; idx < end; idx++) {
+      sum += data[idx];
     }
+    return sum;
+  }
+
+  // Position (bins, Q16) where the linearly interpolated spectrum crosses the threshold between bin and bin + 1
+  int32_t Crossing(const std::array<uint32_t, Ppg::spectrumLength>& data, int bin, uint32_t threshold) {
+    int64_t rise = static_cast<int64_t>(threshold) - data[bin];
+    int64_t delta = static_cast<int64_t>(data[bin + 1]) - data[bin];
+    return static_cast<int32_t>((static_cast<int64_t>(bin) << 16) + (rise << 16) / delta);
   }
 
-  // Hanning Coefficients from numpy: python -c 'import numpy;print(numpy.hanning(64))'
-  // Note: Harcoded and must be updated if constexpr dataLength is changed. Prevents the need to
-  // use cosf() which results in an extra ~5KB in storage.
-  // This data is symetrical so just using the first half (saves 128B when dataLength is 64).
-  static constexpr float hanning[Ppg::dataLength >> 1] {
-    0.0f,        0.00248461f, 0.00991376f, 0.0222136f,  0.03926189f, 0.06088921f, 0.08688061f, 0.11697778f,
-    0.15088159f, 0.1882551f,  0.22872687f, 0.27189467f, 0.31732949f, 0.36457977f, 0.41317591f, 0.46263495f,
-    0.51246535f, 0.56217185f, 0.61126047f, 0.65924333f, 0.70564355f, 0.75f,       0.79187184f, 0.83084292f,
-    0.86652594f, 0.89856625f, 0.92664544f, 0.95048443f, 0.96984631f, 0.98453864f, 0.99441541f, 0.99937846f};
+  // Searches the peaks of the linearly interpolated spectrum above threshold in [start, end] (bins).
+  // Peaks already above threshold at start or still above it at end are ignored.
+  // Returns the location (bins, Q16) of the highest bin of the peak refined by parabolic interpolation
+  // if exactly one peak was found, 0 otherwise.
+  int32_t PeakSearch(const std::array<uint32_t, Ppg::spectrumLength>& data, uint32_t threshold, int32_t& width, int start, int end) {
+    int peaks = 0;
+    bool rising = false;
+    int32_t minBin = 0;
+    int32_t peakMin = 0;
+    int32_t peakMax = 0;
+    for (int bin = start; bin < end; bin++) {
+      if (data[bin] < threshold && data[bin + 1] >= threshold) {
+        minBin = Crossing(data, bin, threshold);
+        rising = true;
+      } else if (data[bin] >= threshold && data[bin + 1] < threshold && rising) {
+        peakMin = minBin;
+        peakMax = Crossing(data, bin, threshold);
+        rising = false;
+        peaks++;
+      }
+    }
+    if (peaks != 1) {
+      width = 0;
+      return 0;
+    }
+    width = peakMax - peakMin;
+
+    int first = (peakMin + 0xffff) >> 16;
+    int last = peakMax >> 16;
+    int top = first;
+    for (int bin = first; bin <= last; bin++) {
+      if (data[bin] > data[top]) {
+        top = bin;
+      }
+    }
+    // Vertex of the parabola going through the highest bin and its neighbours: 0.5 * (y0 - y2) / (y0 - 2 * y1 + y2)
+    int64_t y0 = data[top - 1];
+    int64_t y1 = data[top];
+    int64_t y2 = data[top + 1];
+    int64_t curvature = y0 - 2 * y1 + y2;
+    int32_t offset = 0;
+    if (curvature < 0) {
+      offset = static_cast<int32_t>(std::clamp<int64_t>(((y0 - y2) << 15) / curvature, -(1 << 15), 1 << 15));
+    }
+    return (top << 16) + offset;
+  }
 }
 
 Ppg::Ppg() {
-  dataAverage.fill(0.0f);
-  spectrum.fill(0.0f);
+  static_assert(dataLength == 64, "The FFT and window tables are computed for 64 samples");
+  dataAverage.fill(0);
+  spectrum.fill(0);
 }
 
 int8_t Ppg::Preprocess(uint16_t hrs, uint16_t als) {
@@ -178,120 +259,121 @@ void Ppg::Reset(bool resetDaqBuffer) {
     enoughData = false;
   }
   avgIndex = 0;
-  dataAverage.fill(0.0f);
-  lastPeakLocation = 0.0f;
+  dataAverage.fill(0);
+  lastPeakLocation = 0;
   alsThreshold = UINT16_MAX;
   alsValue = 0;
   resetSpectralAvg = true;
-  spectrum.fill(0.0f);
+  spectrum.fill(0);
 }
 
-// Pass init == true to reset spectral averaging.
-// Returns -1 (Reset Acquisition), 0 (Unable to obtain HR) or HR (BPM).
-int Ppg::ProcessHeartRate(bool init) {
-  std::copy(dataHRS.begin(), dataHRS.end(), vReal.begin());
-  Detrend(vReal);
+// Detrends, filters and windows dataHRS and computes its FFT in vReal and vImag.
+// The signal is rescaled between each step to use the full range of the fixed point values.
+// Returns the number of fractional bits of the FFT output, times dataLength.
+int Ppg::FilterAndTransform() {
+  // Keep 4 bits of headroom for the filter on top of the 23 bits of the detrended signal
+  int fracBits = 16 - Detrend(dataHRS, vReal);
+
   Filter30to240(vReal);
-  vImag.fill(0.0f);
   // Apply Hanning Window
-  int hannIdx = 0;
   for (int idx = 0; idx < dataLength; idx++) {
-    if (idx >= dataLength >> 1) {
-      hannIdx--;
-    }
-    vReal[idx] *= hanning[hannIdx];
-    if (idx < dataLength >> 1) {
-      hannIdx++;
-    }
+    vReal[idx] = MulQ15(vReal[idx], hanning[idx < (dataLength >> 1) ? idx : dataLength - 1 - idx]);
   }
-  // Compute in place power spectrum
-  ArduinoFFT<float> FFT = ArduinoFFT<float>(vReal.data(), vImag.data(), dataLength, sampleFreq);
-  FFT.compute(FFTDirection::Forward);
-  FFT.complexToMagnitude();
-  FFT.~ArduinoFFT();
-  SpectrumAverage(vReal.data(), spectrum.data(), spectrum.size(), init);
-  peakLocation = 0.0f;
-  float threshold = peakDetectionThreshold;
-  float peakWidth = 0.0f;
-  int specLen = spectrum.size();
-  float max = SpectrumMax(spectrum, hrROIbegin, hrROIend);
-  float signalToNoiseRatio = SignalToNoise(spectrum, hrROIbegin, hrROIend, max);
-  if (signalToNoiseRatio > signalToNoiseThreshold && spectrum.at(0) < dcThreshold) {
-    threshold *= max;
-    // Reuse VImag for interpolation x values passed to PeakSearch
-    for (int idx = 0; idx < dataLength; idx++) {
-      vImag[idx] = idx;
-    }
-    peakLocation = PeakSearch(vImag.data(),
-                              spectrum.data(),
-                              threshold,
-                              peakWidth,
-                              static_cast<float>(hrROIbegin),
-                              static_cast<float>(hrROIend),
-                              specLen);
-    peakLocation *= freqResolution;
+
+  int bits = SignalBits(vReal);
+  if (bits == 0) {
+    vImag.fill(0);
+    return 0;
+  }
+  int shift = 29 - bits;
+  for (auto& value : vReal) {
+    value = shift >= 0 ? value << shift : value >> -shift;
+  }
+  fracBits += shift;
+  vImag.fill(0);
+  Fft(vReal, vImag);
+  return fracBits;
+}
+
+// Pass init == true to reset spectral averaging.
+// Returns -1 (Reset Acquisition), 0 (Unable to obtain HR) or HR (BPM).
+int Ppg::ProcessHeartRate(bool init) {
+  int fracBits = FilterAndTransform();
+  SpectrumAverage(fracBits, init);
+
+  uint32_t peakLocation = 0;
+  int32_t peakWidth = 0;
+  uint32_t max = SpectrumMax(spectrum, hrROIbegin, hrROIend);
+  uint64_t sum = SpectrumSum(spectrum, hrROIbegin, hrROIend);
+  if (static_cast<uint64_t>(max) * (hrROIend - hrROIbegin) > sum * signalToNoiseThreshold && spectrum[0] < dcThreshold) {
+    uint32_t threshold = static_cast<uint32_t>(static_cast<uint64_t>(max) * peakDetectionThresholdPercent / 100);
+    int32_t peakBin = PeakSearch(spectrum, threshold, peakWidth, hrROIbegin, hrROIend);
+    // Bins to Hz
+    peakLocation = static_cast<uint32_t>(static_cast<int64_t>(peakBin) * 1000 / (deltaTms * dataLength));
   }
   // Peak too wide? (broad spectrum noise or large, rapid HR change)
   if (peakWidth > maxPeakWidth) {
-    peakLocation = 0.0f;
+    peakLocation = 0;
   }
   // Check HR limits
-  if (peakLocation < minHR || peakLocation > maxHR) {
-    peakLocation = 0.0f;
+  if (peakLocation * 60 < (minHR << hzFracBits) || peakLocation * 60 > (maxHR << hzFracBits)) {
+    peakLocation = 0;
   }
   // Reset spectral averaging if bad reading
-  if (peakLocation == 0.0f) {
+  if (peakLocation == 0) {
     resetSpectralAvg = true;
   }
   // Set the ambient light threshold and return HR in BPM
-  alsThreshold = static_cast<uint16_t>(alsValue * alsFactor);
+  alsThreshold = static_cast<uint16_t>(std::min<uint32_t>(alsValue * alsFactor, UINT16_MAX));
   // Get current average HR. If HR reduced to zero, return -1 (reset) else HR
   peakLocation = HeartRateAverage(peakLocation);
   int rtn = -1;
-  if (peakLocation == 0.0f && lastPeakLocation > 0.0f) {
-    lastPeakLocation = 0.0f;
+  if (peakLocation == 0 && lastPeakLocation > 0) {
+    lastPeakLocation = 0;
   } else {
     lastPeakLocation = peakLocation;
-    rtn = static_cast<int>((peakLocation * 60.0f) + 0.5f);
+    rtn = static_cast<int>((peakLocation * 60 + (1 << (hzFracBits - 1))) >> hzFracBits);
   }
   return rtn;
 }
 
-void Ppg::SpectrumAverage(const float* data, float* spectrum, int length, bool reset) {
+// Averages the magnitude of the FFT in vReal and vImag (fracBits fractional bits, divided by dataLength)
+// into the spectrum.
+void Ppg::SpectrumAverage(int fracBits, bool reset) {
   if (reset) {
     spectralAvgCount = 0;
   }
-  float count = static_cast<float>(spectralAvgCount);
-  for (int idx = 0; idx < length; idx++) {
-    spectrum[idx] = (spectrum[idx] * count + data[idx]) / (count + 1);
+  // 6 bits to undo the FFT scaling
+  int shift = spectrumFracBits + 6 - fracBits;
+  uint64_t count = spectralAvgCount;
+  for (int idx = 0; idx < spectrumLength; idx++) {
+    uint64_t magnitude = SquareRoot(static_cast<int64_t>(vReal[idx]) * vReal[idx] + static_cast<int64_t>(vImag[idx]) * vImag[idx]);
+    if (shift >= 0) {
+      magnitude = std::min<uint64_t>(magnitude << shift, UINT32_MAX);
+    } else {
+      magnitude = (magnitude + (static_cast<uint64_t>(1) << (-shift - 1))) >> -shift;
+    }
+    spectrum[idx] = static_cast<uint32_t>((spectrum[idx] * count + magnitude + count / 2) / (count + 1));
   }
   if (spectralAvgCount < spectralAvgMax) {
     spectralAvgCount++;
   }
 }
 
-float Ppg::HeartRateAverage(float hr) {
+uint32_t Ppg::HeartRateAverage(uint32_t hr) {
   avgIndex++;
   avgIndex %= dataAverage.size();
   dataAverage[avgIndex] = hr;
-  float avg = 0.0f;
-  float total = 0.0f;
-  float min = 300.0f;
-  float max = 0.0f;
-  for (const float& value : dataAverage) {
-    if (value > 0.0f) {
+  uint32_t avg = 0;
+  uint32_t total = 0;
+  for (uint32_t value : dataAverage) {
+    if (value > 0) {
       avg += value;
-      if (value < min)
-        min = value;
-      if (value > max)
-        max = value;
       total++;
     }
   }
   if (total > 0) {
-    avg /= total;
-  } else {
-    avg = 0.0f;
+    avg = (avg + total / 2) / total;
   }
   return avg;
 }
@@ -3,14 +3,12 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
-// Note: Change internal define 'sqrt_internal sqrt' to
-// 'sqrt_internal sqrtf' to save ~3KB of flash.
-#define sqrt_internal sqrtf
-#define FFT_SPEED_OVER_PRECISION
-#include "libs/arduinoFFT/src/arduinoFFT.h"
 
 namespace Pinetime {
   namespace Controllers {
+    // Heart rate estimation from the HRS3300 samples.
+    // The whole pipeline runs in fixed point: the spectrum is in ADC units with spectrumFracBits fractional bits
+    // and frequencies are in bins or Hz with 16 fractional bits.
     class Ppg {
     public:
       Ppg();
@@ -18,15 +16,13 @@ namespace Pinetime {
       int HeartRate();
       void Reset(bool resetDaqBuffer);
       static constexpr int deltaTms = 100;
-      // Daq dataLength: Must be power of 2
+      // Daq dataLength: Must be 64, the FFT twiddle factors and the Hanning window are tabulated for this length
       static constexpr uint16_t dataLength = 64;
       static constexpr uint16_t spectrumLength = dataLength >> 1;
 
     private:
-      // The sampling frequency (Hz) based on sampling time in milliseconds (DeltaTms)
-      static constexpr float sampleFreq = 1000.0f / static_cast<float>(deltaTms);
-      // The frequency resolution (Hz)
-      static constexpr float freqResolution = sampleFreq / dataLength;
+      static constexpr int spectrumFracBits = 8;
+      static constexpr int hzFracBits = 16;
       // Number of samples before each analysis
       // 0.5 second update rate at 10Hz
       static constexpr uint16_t overlapWindow = 5;
@@ -34,48 +30,48 @@ namespace Pinetime {
       // Note: actual number of spectra averaged = spectralAvgMax + 1
       static constexpr uint16_t spectralAvgMax = 2;
       // Multiple Peaks above this threshold (% of max) are rejected
-      static constexpr float peakDetectionThreshold = 0.6f;
-      // Maximum peak width (bins) at threshold for valid peak.
-      static constexpr float maxPeakWidth = 2.5f;
+      static constexpr uint32_t peakDetectionThresholdPercent = 60;
+      // Maximum peak width (bins, Q16) at threshold for valid peak.
+      static constexpr int32_t maxPeakWidth = 5 << (hzFracBits - 1);
       // Metric for spectrum noise level.
-      static constexpr float signalToNoiseThreshold = 3.0f;
-      // Heart rate Region Of Interest begin (bins)
-      static constexpr uint16_t hrROIbegin = static_cast<uint16_t>((30.0f / 60.0f) / freqResolution + 0.5f);
-      // Heart rate Region Of Interest end (bins)
-      static constexpr uint16_t hrROIend = static_cast<uint16_t>((240.0f / 60.0f) / freqResolution + 0.5f);
-      // Minimum HR (Hz)
-      static constexpr float minHR = 40.0f / 60.0f;
-      // Maximum HR (Hz)
-      static constexpr float maxHR = 230.0f / 60.0f;
-      // Threshold for high DC level after filtering
-      static constexpr float dcThreshold = 0.5f;
+      static constexpr uint32_t signalToNoiseThreshold = 3;
+      // Heart rate Region Of Interest begin (bins): 30 BPM
+      static constexpr uint16_t hrROIbegin = (30 * deltaTms * dataLength + 30000) / 60000;
+      // Heart rate Region Of Interest end (bins): 240 BPM
+      static constexpr uint16_t hrROIend = (240 * deltaTms * dataLength + 30000) / 60000;
+      // Minimum HR (BPM)
+      static constexpr uint32_t minHR = 40;
+      // Maximum HR (BPM)
+      static constexpr uint32_t maxHR = 230;
+      // Threshold for high DC level after filtering (0.5)
+      static constexpr uint32_t dcThreshold = 1 << (spectrumFracBits - 1);
       // ALS detection factor
-      static constexpr float alsFactor = 2.0f;
+      static constexpr uint32_t alsFactor = 2;
 
       // Raw ADC data
       std::array<uint16_t, dataLength> dataHRS;
-      // Stores Real numbers from FFT
-      std::array<float, dataLength> vReal;
-      // Stores Imaginary numbers from FFT
-      std::array<float, dataLength> vImag;
-      // Stores power spectrum calculated from FFT real and imag values
-      std::array<float, (spectrumLength)> spectrum;
-      // Stores each new HR value (Hz). Non zero values are averaged for HR output
-      std::array<float, 20> dataAverage;
+      // Filtered signal, then real part of the FFT
+      std::array<int32_t, dataLength> vReal;
+      // Imaginary part of the FFT
+      std::array<int32_t, dataLength> vImag;
+      // Averaged magnitude spectrum
+      std::array<uint32_t, spectrumLength> spectrum;
+      // Stores each new HR value (Hz, Q16). Non zero values are averaged for HR output
+      std::array<uint32_t, 20> dataAverage;
 
       uint16_t avgIndex = 0;
       uint16_t spectralAvgCount = 0;
-      float lastPeakLocation = 0.0f;
+      uint32_t lastPeakLocation = 0;
       uint16_t alsThreshold = UINT16_MAX;
       uint16_t alsValue = 0;
       uint16_t dataIndex = 0;
-      float peakLocation;
       bool resetSpectralAvg = true;
       bool enoughData = false;
 
       int ProcessHeartRate(bool init);
-      float HeartRateAverage(float hr);
-      void SpectrumAverage(const float* data, float* spectrum, int length, bool reset);
+      int FilterAndTransform();
+      void SpectrumAverage(int fracBits, bool reset);
+      uint32_t HeartRateAverage(uint32_t hr);
     };
   }
 }
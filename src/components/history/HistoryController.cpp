@@ -0,0 +1,464 @@
+#include "components/history/HistoryController.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <libraries/log/nrf_log.h>
+#include <task.h>
+#include "components/battery/BatteryController.h"
+#include "components/datetime/DateTimeController.h"
+#include "components/fs/FS.h"
+#include "components/heartrate/HeartRateController.h"
+#include "components/motion/MotionController.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  constexpr const char* historyDirectory = "/.system/history";
+  constexpr const char* checkpointPath = "/.system/history/current";
+  // Directory, then the sequence number, first and last times of the segment in hexadecimal
+  constexpr size_t maxPathLength = 16 + 1 + 3 * 9;
+
+  // Records start with a varint holding the time elapsed since the previous record in the upper bits and the type of the
+  // record in the 2 lower bits. Sync records are followed by the absolute time, and reset the time and the values the
+  // deltas refer to. The other records are followed by the zigzag encoded difference with the previous value of their
+  // series. Every batch starts with a sync record.
+  constexpr uint32_t syncRecord = 0;
+  constexpr uint32_t maxTimeDelta = (1U << 30) - 1;
+  // A sync record and a record with their 5 bytes varints, the values take 3 bytes at most
+  constexpr size_t maxRecordsLength = 2 * 5 + 5 + 3;
+
+  void SegmentPath(char* path, uint32_t sequence, uint32_t first, uint32_t last) {
+    std::snprintf(path,
+                  maxPathLength,
+                  "%s/%08lx_%08lx_%08lx",
+                  historyDirectory,
+                  static_cast<unsigned long>(sequence),
+                  static_cast<unsigned long>(first),
+                  static_cast<unsigned long>(last));
+  }
+
+  bool ParseHex(const char*& text, uint32_t& value) {
+    value = 0;
+    for (int i = 0; i < 8; i++, text++) {
+      char c = *text;
+      if (c >= '0' && c <= '9') {
+        value = (value << 4) | static_cast<uint32_t>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        value = (value << 4) | static_cast<uint32_t>(c - 'a' + 10);
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool ParseSegmentName(const char* name, uint32_t& sequence, uint32_t& first, uint32_t& last) {
+    return std::strlen(name) == 3 * 9 - 1 && ParseHex(name, sequence) && *name++ == '_' && ParseHex(name, first) && *name++ == '_' &&
+           ParseHex(name, last);
+  }
+
+  // Decodes the records of a batch in RAM or of a segment file
+  class RecordReader {
+  public:
+    using Series = HistoryController::Series;
+
+    RecordReader(const uint8_t* data, size_t size) : data {data}, size {size} {
+    }
+
+    RecordReader(FS& fs, lfs_file_t& file) : fs {&fs}, file {&file} {
+      data = chunk.data();
+    }
+
+    bool Next(Series& series, uint32_t& time, uint16_t& value) {
+      uint32_t head;
+      while (NextVarint(head)) {
+        uint32_t type = head & 0x03;
+        uint32_t payload;
+        if (!NextVarint(payload)) {
+          return false;
+        }
+        if (type == syncRecord) {
+          currentTime = payload;
+          values = {};
+          continue;
+        }
+        currentTime += head >> 2;
+        values[type] += static_cast<uint16_t>(static_cast<int32_t>(payload >> 1) ^ -static_cast<int32_t>(payload & 1));
+        series = static_cast<Series>(type);
+        time = currentTime;
+        value = values[type];
+        return true;
+      }
+      return false;
+    }
+
+  private:
+    FS* fs = nullptr;
+    lfs_file_t* file = nullptr;
+    std::array<uint8_t, 64> chunk;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t position = 0;
+    uint32_t currentTime = 0;
+    std::array<uint16_t, 4> values {};
+
+    bool NextByte(uint8_t& byte) {
+      if (position == size) {
+        if (file == nullptr) {
+          return false;
+        }
+        int read = fs->FileRead(file, chunk.data(), chunk.size());
+        if (read <= 0) {
+          return false;
+        }
+        size = static_cast<size_t>(read);
+        position = 0;
+      }
+      byte = data[position++];
+      return true;
+    }
+
+    bool NextVarint(uint32_t& value) {
+      value = 0;
+      for (uint32_t shift = 0; shift < 35; shift += 7) {
+        uint8_t byte;
+        if (!NextByte(byte)) {
+          return false;
+        }
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+          return true;
+        }
+      }
+      return false;
+    }
+  };
+}
+
+HistoryController::HistoryController(FS& fs,
+                                     DateTime& dateTimeController,
+                                     MotionController& motionController,
+                                     HeartRateController& heartRateController,
+                                     Battery& batteryController)
+  : fs {fs},
+    dateTimeController {dateTimeController},
+    motionController {motionController},
+    heartRateController {heartRateController},
+    batteryController {batteryController} {
+  mutex = xSemaphoreCreateMutex();
+  ASSERT(mutex != nullptr);
+  xSemaphoreGive(mutex);
+}
+
+void HistoryController::Init() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  lfs_dir_t dir;
+  if (fs.DirOpen("/.system", &dir) != LFS_ERR_OK) {
+    fs.DirCreate("/.system");
+  } else {
+    fs.DirClose(&dir);
+  }
+  if (fs.DirOpen(historyDirectory, &dir) != LFS_ERR_OK) {
+    fs.DirCreate(historyDirectory);
+  } else {
+    fs.DirClose(&dir);
+  }
+
+  ScanSegments();
+  LoadCheckpoint();
+  lastCheckpointTime = Now();
+  isInitialized = true;
+  NRF_LOG_INFO("[History] %d segments, %d bytes in the checkpoint", nbSegments, batchLength);
+  xSemaphoreGive(mutex);
+}
+
+void HistoryController::ScanSegments() {
+  bool hasStaleSegments = false;
+  lfs_dir_t dir;
+  if (fs.DirOpen(historyDirectory, &dir) != LFS_ERR_OK) {
+    return;
+  }
+  lfs_info info;
+  while (fs.DirRead(&dir, &info) > 0) {
+    Segment segment;
+    if (info.type != LFS_TYPE_REG) {
+      continue;
+    }
+    if (!ParseSegmentName(info.name, segment.sequence, segment.first, segment.last)) {
+      continue;
+    }
+
+    // Keep the newest segments, sorted by sequence number
+    if (nbSegments == maxSegments) {
+      hasStaleSegments = true;
+      if (segment.sequence < segments[0].sequence) {
+        continue;
+      }
+      std::move(segments.begin() + 1, segments.end(), segments.begin());
+      nbSegments--;
+    }
+    auto position = std::upper_bound(segments.begin(), segments.begin() + nbSegments, segment, [](const Segment& a, const Segment& b) {
+      return a.sequence < b.sequence;
+    });
+    std::move_backward(position, segments.begin() + nbSegments, segments.begin() + nbSegments + 1);
+    *position = segment;
+    nbSegments++;
+  }
+  fs.DirClose(&dir);
+
+  if (nbSegments > 0) {
+    nextSequence = segments[nbSegments - 1].sequence + 1;
+  }
+  if (hasStaleSegments) {
+    DeleteStaleSegments();
+  }
+}
+
+void HistoryController::DeleteStaleSegments() {
+  // Files are not deleted while the directory is being read
+  char path[maxPathLength];
+  do {
+    path[0] = '\0';
+    lfs_dir_t dir;
+    if (fs.DirOpen(historyDirectory, &dir) != LFS_ERR_OK) {
+      return;
+    }
+    lfs_info info;
+    while (fs.DirRead(&dir, &info) > 0) {
+      Segment segment;
+      if (info.type == LFS_TYPE_REG && ParseSegmentName(info.name, segment.sequence, segment.first, segment.last) &&
+          segment.sequence < segments[0].sequence) {
+        SegmentPath(path, segment.sequence, segment.first, segment.last);
+        break;
+      }
+    }
+    fs.DirClose(&dir);
+  } while (path[0] != '\0' && fs.FileDelete(path) == LFS_ERR_OK);
+}
+
+void HistoryController::LoadCheckpoint() {
+  lfs_file_t file;
+  if (fs.FileOpen(&file, checkpointPath, LFS_O_RDONLY) != LFS_ERR_OK) {
+    return;
+  }
+  int read = fs.FileRead(&file, batch.data(), batch.size());
+  fs.FileClose(&file);
+  if (read <= 0) {
+    return;
+  }
+
+  batchLength = static_cast<size_t>(read);
+  checkpointLength = batchLength;
+  RecordReader reader {batch.data(), batchLength};
+  Series series;
+  uint32_t time;
+  uint16_t value;
+  while (reader.Next(series, time, value)) {
+    batchFirst = std::min(batchFirst, time);
+    batchLast = std::max(batchLast, time);
+  }
+  // The deltas of the next records can't refer to the values of the reloaded records
+  isSyncNeeded = true;
+}
+
+uint32_t HistoryController::Now() const {
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(dateTimeController.CurrentDateTime().time_since_epoch()).count());
+}
+
+void HistoryController::Process() {
+  TickType_t now = xTaskGetTickCount();
+  if (!isInitialized || (isSampled && now - lastSamplingTime < samplingPeriod)) {
+    return;
+  }
+  isSampled = true;
+  lastSamplingTime = now;
+
+  uint32_t time = Now();
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  if (heartRateController.State() == HeartRateController::States::Running && heartRateController.HeartRate() > 0) {
+    Append(Series::HeartRate, time, heartRateController.HeartRate());
+  }
+  uint8_t batteryPercent = batteryController.PercentRemaining();
+  if (batteryPercent != lastBatteryPercent) {
+    lastBatteryPercent = batteryPercent;
+    Append(Series::Battery, time, batteryPercent);
+  }
+  xSemaphoreGive(mutex);
+}
+
+void HistoryController::OnNewHour() {
+  if (!isInitialized) {
+    return;
+  }
+  // Dated from the last second of the hour that ended, so that the last record of a day holds its step count
+  uint32_t time = StartOfHour(Now()) - 1;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  Append(Series::Steps, time, static_cast<uint16_t>(std::min<uint32_t>(motionController.NbSteps(), UINT16_MAX)));
+  if (Now() - lastCheckpointTime >= checkpointPeriod) {
+    WriteCheckpoint();
+  }
+  xSemaphoreGive(mutex);
+}
+
+void HistoryController::Flush() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  WriteCheckpoint();
+  xSemaphoreGive(mutex);
+}
+
+void HistoryController::WriteVarint(uint32_t value) {
+  while (value >= 0x80) {
+    batch[batchLength++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  batch[batchLength++] = static_cast<uint8_t>(value);
+}
+
+void HistoryController::Append(Series series, uint32_t time, uint16_t value) {
+  if (batchLength + maxRecordsLength > batch.size()) {
+    WriteSegment();
+  }
+  if (batchLength == 0 || isSyncNeeded || time < lastRecordTime || time - lastRecordTime > maxTimeDelta) {
+    WriteVarint(syncRecord);
+    WriteVarint(time);
+    lastRecordTime = time;
+    lastValues = {};
+    isSyncNeeded = false;
+  }
+
+  auto type = static_cast<uint8_t>(series);
+  int32_t delta = static_cast<int32_t>(value) - static_cast<int32_t>(lastValues[type]);
+  WriteVarint(((time - lastRecordTime) << 2) | type);
+  WriteVarint((static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31));
+  lastRecordTime = time;
+  lastValues[type] = value;
+  batchFirst = std::min(batchFirst, time);
+  batchLast = std::max(batchLast, time);
+}
+
+void HistoryController::WriteSegment() {
+  if (batchLength == 0) {
+    return;
+  }
+  char path[maxPathLength];
+  if (nbSegments == maxSegments) {
+    SegmentPath(path, segments[0].sequence, segments[0].first, segments[0].last);
+    fs.FileDelete(path);
+    std::move(segments.begin() + 1, segments.end(), segments.begin());
+    nbSegments--;
+  }
+
+  // Written at once: the data of the file fills a single block
+  Segment segment {nextSequence, batchFirst, batchLast};
+  SegmentPath(path, segment.sequence, segment.first, segment.last);
+  lfs_file_t file;
+  int written = -1;
+  if (fs.FileOpen(&file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) == LFS_ERR_OK) {
+    written = fs.FileWrite(&file, batch.data(), batchLength);
+    if (fs.FileClose(&file) != LFS_ERR_OK) {
+      written = -1;
+    }
+  }
+  if (written == static_cast<int>(batchLength)) {
+    segments[nbSegments++] = segment;
+    nextSequence++;
+  } else {
+    NRF_LOG_WARNING("[History] Failed to write segment %d", segment.sequence);
+    fs.FileDelete(path);
+  }
+  // The records are now in the segment (or lost)
+  fs.FileDelete(checkpointPath);
+
+  batchLength = 0;
+  batchFirst = UINT32_MAX;
+  batchLast = 0;
+  checkpointLength = 0;
+}
+
+void HistoryController::WriteCheckpoint() {
+  lastCheckpointTime = Now();
+  if (batchLength == checkpointLength) {
+    return;
+  }
+  lfs_file_t file;
+  if (fs.FileOpen(&file, checkpointPath, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) != LFS_ERR_OK) {
+    NRF_LOG_WARNING("[History] Failed to open the checkpoint");
+    return;
+  }
+  int written = fs.FileWrite(&file, batch.data(), batchLength);
+  if (fs.FileClose(&file) == LFS_ERR_OK && written == static_cast<int>(batchLength)) {
+    checkpointLength = batchLength;
+  } else {
+    NRF_LOG_WARNING("[History] Failed to write the checkpoint");
+  }
+}
+
+template <typename F>
+void HistoryController::ForEachRecord(uint32_t from, uint32_t to, F&& function) {
+  Series series;
+  uint32_t time;
+  uint16_t value;
+  auto readFile = [&](const char* path) {
+    lfs_file_t file;
+    if (fs.FileOpen(&file, path, LFS_O_RDONLY) != LFS_ERR_OK) {
+      return true;
+    }
+    RecordReader reader {fs, file};
+    bool more = true;
+    while (more && reader.Next(series, time, value)) {
+      if (time >= from && time < to) {
+        more = function(series, time, value);
+      }
+    }
+    fs.FileClose(&file);
+    return more;
+  };
+
+  char path[maxPathLength];
+  for (size_t i = 0; i < nbSegments; i++) {
+    if (segments[i].last >= from && segments[i].first < to) {
+      SegmentPath(path, segments[i].sequence, segments[i].first, segments[i].last);
+      if (!readFile(path)) {
+        return;
+      }
+    }
+  }
+  if (batchLength > 0 && batchLast >= from && batchFirst < to) {
+    RecordReader reader {batch.data(), batchLength};
+    while (reader.Next(series, time, value)) {
+      if (time >= from && time < to && !function(series, time, value)) {
+        return;
+      }
+    }
+  }
+}
+
+size_t HistoryController::Query(Series series, uint32_t from, uint32_t to, Sample* samples, size_t maxSamples) {
+  size_t nbSamples = 0;
+  if (maxSamples == 0) {
+    return 0;
+  }
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  ForEachRecord(from, to, [&](Series recordSeries, uint32_t time, uint16_t value) {
+    if (recordSeries == series) {
+      samples[nbSamples++] = {time, value};
+    }
+    return nbSamples < maxSamples;
+  });
+  xSemaphoreGive(mutex);
+  return nbSamples;
+}
+
+bool HistoryController::Last(Series series, uint32_t from, uint32_t to, Sample& sample) {
+  bool found = false;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  ForEachRecord(from, to, [&](Series recordSeries, uint32_t time, uint16_t value) {
+    if (recordSeries == series && (!found || time >= sample.time)) {
+      sample = {time, value};
+      found = true;
+    }
+    return true;
+  });
+  xSemaphoreGive(mutex);
+  return found;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <FreeRTOS.h>
+#include <semphr.h>
+
+namespace Pinetime {
+  namespace Controllers {
+    class Battery;
+    class DateTime;
+    class FS;
+    class HeartRateController;
+    class MotionController;
+
+    // Append-only history of the step count, the heart rate and the battery level.
+    //
+    // Records are delta/varint encoded and batched in RAM. A full batch (one flash sector) is written at once as a new
+    // segment file, named after its sequence number and the time range it covers, so the index of the segments is rebuilt
+    // from the directory alone. littlefs copies the last block of a file to a new block whenever data is appended to it,
+    // so smaller batches appended to a file would each cost a sector erase.
+    // The batch in progress is saved to a checkpoint file once a day and by Flush(), and reloaded by Init().
+    // Times are local times, in seconds since the epoch.
+    class HistoryController {
+    public:
+      enum class Series : uint8_t {
+        Steps = 1, // Steps counted since midnight, recorded at the end of every hour
+        HeartRate, // BPM, recorded every minute while a measurement is running
+        Battery,   // Percent, recorded when it changes
+      };
+
+      struct Sample {
+        uint32_t time;
+        uint16_t value;
+      };
+
+      static constexpr uint32_t secondsPerHour = 60 * 60;
+      static constexpr uint32_t secondsPerDay = 24 * secondsPerHour;
+
+      HistoryController(FS& fs,
+                        DateTime& dateTimeController,
+                        MotionController& motionController,
+                        HeartRateController& heartRateController,
+                        Battery& batteryController);
+      HistoryController(const HistoryController&) = delete;
+      HistoryController& operator=(const HistoryController&) = delete;
+      HistoryController(HistoryController&&) = delete;
+      HistoryController& operator=(HistoryController&&) = delete;
+
+      void Init();
+      // Samples the heart rate and the battery level, to be called periodically
+      void Process();
+      // Records the steps of the hour that just ended, before the step counter is reset for the new day
+      void OnNewHour();
+      // Saves the batch in progress to the checkpoint file
+      void Flush();
+
+      // Samples of series recorded in [from, to), oldest first. Returns the number of samples written to samples.
+      size_t Query(Series series, uint32_t from, uint32_t to, Sample* samples, size_t maxSamples);
+      // Last sample of series recorded in [from, to), e.g. the step count of a day
+      bool Last(Series series, uint32_t from, uint32_t to, Sample& sample);
+
+      uint32_t Now() const;
+
+      static uint32_t StartOfDay(uint32_t time) {
+        return time - time % secondsPerDay;
+      }
+
+      static uint32_t StartOfHour(uint32_t time) {
+        return time - time % secondsPerHour;
+      }
+
+    private:
+      struct Segment {
+        uint32_t sequence;
+        uint32_t first;
+        uint32_t last;
+      };
+
+      static constexpr size_t segmentSize = 4096;
+      // 128KB of flash, several months of history
+      static constexpr size_t maxSegments = 32;
+      static constexpr TickType_t samplingPeriod = pdMS_TO_TICKS(60 * 1000);
+      static constexpr uint32_t checkpointPeriod = secondsPerDay;
+
+      FS& fs;
+      DateTime& dateTimeController;
+      MotionController& motionController;
+      HeartRateController& heartRateController;
+      Battery& batteryController;
+      SemaphoreHandle_t mutex = nullptr;
+
+      // Sealed segments, oldest first
+      std::array<Segment, maxSegments> segments;
+      size_t nbSegments = 0;
+      uint32_t nextSequence = 0;
+
+      // Next segment
+      std::array<uint8_t, segmentSize> batch;
+      size_t batchLength = 0;
+      uint32_t batchFirst = UINT32_MAX;
+      uint32_t batchLast = 0;
+      uint32_t lastRecordTime = 0;
+      std::array<uint16_t, 4> lastValues {};
+      // The next record starts with a sync record, after a batch reloaded from the checkpoint
+      bool isSyncNeeded = false;
+      size_t checkpointLength = 0;
+      uint32_t lastCheckpointTime = 0;
+
+      bool isInitialized = false;
+      bool isSampled = false;
+      TickType_t lastSamplingTime = 0;
+      uint8_t lastBatteryPercent = 0;
+
+      void Append(Series series, uint32_t time, uint16_t value);
+      void WriteVarint(uint32_t value);
+      void WriteSegment();
+      void WriteCheckpoint();
+      void ScanSegments();
+      void LoadCheckpoint();
+      void DeleteStaleSegments();
+      // Calls function(series, time, value) for the records in [from, to) until it returns false
+      template <typename F>
+      void ForEachRecord(uint32_t from, uint32_t to, F&& function);
+    };
+  }
+}
@@ -0,0 +1,68 @@
+#include "components/lz4/Lz4Decoder.h"
+#include <cstring>
+
+using namespace Pinetime::Tools;
+
+namespace {
+  constexpr size_t minMatchLength = 4;
+
+  bool ReadLength(const uint8_t* input, size_t inputSize, size_t& index, size_t& length) {
+    uint8_t value;
+    do {
+      if (index >= inputSize) {
+        return false;
+      }
+      value = input[index++];
+      length += value;
+    } while (value == 255);
+    return true;
+  }
+}
+
+int Lz4Decoder::Decode(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize) {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < inputSize) {
+    uint8_t token = input[in++];
+
+    size_t nbLiterals = token >> 4;
+    if (nbLiterals == 15 && !ReadLength(input, inputSize, in, nbLiterals)) {
+      return -1;
+    }
+    if (nbLiterals > inputSize - in || nbLiterals > outputSize - out) {
+      return -1;
+    }
+    // The input may be stored after the output in the same buffer
+    std::memmove(output + out, input + in, nbLiterals);
+    in += nbLiterals;
+    out += nbLiterals;
+
+    // The last sequence only has literals
+    if (in == inputSize) {
+      break;
+    }
+
+    if (inputSize - in < 2) {
+      return -1;
+    }
+    size_t offset = input[in] | (input[in + 1] << 8);
+    in += 2;
+    if (offset == 0 || offset > out) {
+      return -1;
+    }
+
+    size_t matchLength = token & 0x0f;
+    if (matchLength == 15 && !ReadLength(input, inputSize, in, matchLength)) {
+      return -1;
+    }
+    matchLength += minMatchLength;
+    if (matchLength > outputSize - out) {
+      return -1;
+    }
+    // Byte by byte, the match may overlap the bytes it is copying
+    for (; matchLength > 0; matchLength--, out++) {
+      output[out] = output[out - offset];
+    }
+  }
+  return static_cast<int>(out);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Tools {
+    /* Decoder for the LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+     * The encoded block may be stored at the end of the output buffer and decoded in place, provided that the buffer
+     * is at least InPlaceMargin() bytes longer than the decoded data.
+     */
+    class Lz4Decoder {
+    public:
+      static constexpr size_t InPlaceMargin(size_t encodedSize) {
+        return (encodedSize >> 8) + 32;
+      }
+
+      // Returns the size of the decoded data, or -1 if the block is malformed or doesn't fit in the output buffer
+      static int Decode(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize);
+    };
+  }
+}
@@ -1,5 +1,6 @@
 #include "components/motion/MotionController.h"
 
+#include <algorithm>
 #include <task.h>
 
 #include "utility/Math.h"
@@ -41,43 +42,73 @@ void MotionController::AdvanceDay() {
   if (service != nullptr) {
     service->OnNewStepCountValue(NbSteps(Days::Today));
   }
+  changeNotifier.Publish(ChangeNotifier::Topic::Motion);
 }
 
 void MotionController::Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps) {
+  const Drivers::Bma421::Sample sample {x, y, z};
+  Update(&sample, 1, 0, nbSteps);
+}
+
+void MotionController::Update(const Drivers::Bma421::Sample* samples, size_t nbSamples, uint32_t samplePeriodMs, uint32_t nbSteps) {
   uint32_t oldSteps = NbSteps(Days::Today);
-  if (oldSteps != nbSteps && service != nullptr) {
-    service->OnNewStepCountValue(nbSteps);
+  if (oldSteps != nbSteps) {
+    if (service != nullptr) {
+      service->OnNewStepCountValue(nbSteps);
+    }
+    changeNotifier.Publish(ChangeNotifier::Topic::Motion);
   }
 
-  if (service != nullptr && (xHistory[0] != x || yHistory[0] != y || zHistory[0] != z)) {
-    service->OnNewMotionValues(x, y, z);
+  TickType_t now = xTaskGetTickCount();
+  if (service != nullptr && samplePeriodMs > 0) {
+    service->OnNewMotionSamples(samples, nbSamples, samplePeriodMs, now);
+  }
+
+  raiseWakeDetected = false;
+  lowerSleepDetected = false;
+  maxShakeSpeed = accumulatedSpeed;
+  const uint32_t decimation = samplePeriodMs > 0 ? std::max<uint32_t>(gesturePeriodMs / samplePeriodMs, 1) : 1;
+  for (size_t i = 0; i < nbSamples; i++) {
+    decimationCounter = (decimationCounter + 1) % decimation;
+    if (decimationCounter == 0) {
+      AddSample(samples[i], now - pdMS_TO_TICKS((nbSamples - 1 - i) * samplePeriodMs));
+    }
+  }
+
+  int32_t deltaSteps = nbSteps - oldSteps;
+  if (deltaSteps > 0) {
+    currentTripSteps += deltaSteps;
+  }
+  SetSteps(Days::Today, nbSteps);
+}
+
+void MotionController::AddSample(const Drivers::Bma421::Sample& sample, TickType_t sampleTime) {
+  if (service != nullptr && (xHistory[0] != sample.x || yHistory[0] != sample.y || zHistory[0] != sample.z)) {
+    service->OnNewMotionValues(sample.x, sample.y, sample.z);
   }
 
   lastTime = time;
-  time = xTaskGetTickCount();
+  time = sampleTime;
 
   xHistory++;
-  xHistory[0] = x;
+  xHistory[0] = sample.x;
   yHistory++;
-  yHistory[0] = y;
+  yHistory[0] = sample.y;
   zHistory++;
-  zHistory[0] = z;
+  zHistory[0] = sample.z;
 
   // Update accumulated speed
-  // Currently polling at 10Hz, if this ever goes faster scalar and EMA might need adjusting
+  // Samples come at 10 to 12.5Hz, if this ever goes faster scalar and EMA might need adjusting
   int32_t speed = std::abs(zHistory[0] - zHistory[histSize - 1] + ((yHistory[0] - yHistory[histSize - 1]) / 2) +
                            ((xHistory[0] - xHistory[histSize - 1]) / 4)) *
-                  100 / (time - lastTime);
+                  100 / std::max<int32_t>(time - lastTime, 1);
   // integer version of (.2 * speed) + ((1 - .2) * accumulatedSpeed);
   accumulatedSpeed = speed / 5 + accumulatedSpeed * 4 / 5;
+  maxShakeSpeed = std::max(maxShakeSpeed, accumulatedSpeed);
 
   stats = GetAccelStats();
-
-  int32_t deltaSteps = nbSteps - oldSteps;
-  if (deltaSteps > 0) {
-    currentTripSteps += deltaSteps;
-  }
-  SetSteps(Days::Today, nbSteps);
+  raiseWakeDetected |= IsRaiseWakeGesture();
+  lowerSleepDetected |= IsLowerSleepGesture();
 }
 
 MotionController::AccelStats MotionController::GetAccelStats() const {
@@ -110,7 +141,7 @@ MotionController::AccelStats MotionController::GetAccelStats() const {
   return stats;
 }
 
-bool MotionController::ShouldRaiseWake() const {
+bool MotionController::IsRaiseWakeGesture() const {
   constexpr uint32_t varianceThresh = 56 * 56;
   constexpr int16_t xThresh = 384;
   constexpr int16_t yThresh = -64;
@@ -128,7 +159,7 @@ bool MotionController::ShouldRaiseWake() const {
   return DegreesRolled(stats.yMean, stats.zMean, stats.prevYMean, stats.prevZMean) < rollDegreesThresh;
 }
 
-bool MotionController::ShouldLowerSleep() const {
+bool MotionController::IsLowerSleepGesture() const {
   if ((stats.xMean > 887 && DegreesRolled(stats.xMean, stats.zMean, stats.prevXMean, stats.prevZMean) > 30) ||
       (stats.xMean < -887 && DegreesRolled(stats.xMean, stats.zMean, stats.prevXMean, stats.prevZMean) < -30)) {
     return true;
@@ -6,6 +6,7 @@
 
 #include "drivers/Bma421.h"
 #include "components/ble/MotionService.h"
+#include "components/changes/ChangeNotifier.h"
 #include "utility/CircularBuffer.h"
 
 namespace Pinetime {
@@ -25,9 +26,15 @@ namespace Pinetime {
 
       static constexpr size_t stepHistorySize = 2; // Store this many day's step counter
 
+      explicit MotionController(ChangeNotifier& changeNotifier) : changeNotifier {changeNotifier} {
+      }
+
       void AdvanceDay();
 
       void Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps);
+      // Ingests a batch of samples taken samplePeriodMs apart, the last one being the most recent.
+      // Samples faster than the gesture detection rate are all streamed but decimated for the gesture detection.
+      void Update(const Drivers::Bma421::Sample* samples, size_t nbSamples, uint32_t samplePeriodMs, uint32_t nbSteps);
 
       int16_t X() const {
         return xHistory[0];
@@ -53,13 +60,24 @@ namespace Pinetime {
         return currentTripSteps;
       }
 
-      bool ShouldRaiseWake() const;
-      bool ShouldLowerSleep() const;
+      // Gestures detected on any of the samples of the last update
+      bool ShouldRaiseWake() const {
+        return raiseWakeDetected;
+      }
+
+      bool ShouldLowerSleep() const {
+        return lowerSleepDetected;
+      }
 
       int32_t CurrentShakeSpeed() const {
         return accumulatedSpeed;
       }
 
+      // Highest shake speed reached during the last update
+      int32_t MaxShakeSpeed() const {
+        return maxShakeSpeed;
+      }
+
       DeviceTypes DeviceType() const {
         return deviceType;
       }
@@ -101,8 +119,18 @@ namespace Pinetime {
       };
 
       AccelStats GetAccelStats() const;
+      void AddSample(const Drivers::Bma421::Sample& sample, TickType_t sampleTime);
+      bool IsRaiseWakeGesture() const;
+      bool IsLowerSleepGesture() const;
+
+      // The gesture detection and the shake speed are tuned for 10 to 12.5Hz
+      static constexpr uint32_t gesturePeriodMs = 80;
+      uint32_t decimationCounter = 0;
 
       AccelStats stats = {};
+      bool raiseWakeDetected = false;
+      bool lowerSleepDetected = false;
+      int32_t maxShakeSpeed = 0;
 
       static constexpr uint8_t histSize = 8;
       Utility::CircularBuffer<int16_t, histSize> xHistory = {};
@@ -112,6 +140,7 @@ namespace Pinetime {
 
       DeviceTypes deviceType = DeviceTypes::Unknown;
       Pinetime::Controllers::MotionService* service = nullptr;
+      ChangeNotifier& changeNotifier;
     };
   }
 }
@@ -0,0 +1,119 @@
+#include "components/profiling/FrameProfiler.h"
+#include <FreeRTOS.h>
+#include <task.h>
+#include <libraries/log/nrf_log.h>
+#include <algorithm>
+
+using namespace Pinetime::Controllers;
+
+void FrameProfiler::Totals::Add(const Frame& frame) {
+  nbFrames++;
+  renderTimeUs += frame.renderTimeUs;
+  maxRenderTimeUs = std::max(maxRenderTimeUs, frame.renderTimeUs);
+  flushTimeUs += frame.flushTimeUs;
+  maxFlushTimeUs = std::max(maxFlushTimeUs, frame.flushTimeUs);
+  queueWaitMs += frame.queueWaitMs;
+  dirtyPixels += frame.dirtyPixels;
+}
+
+FrameProfiler::Summary FrameProfiler::Totals::ToSummary() const {
+  if (nbFrames == 0) {
+    return {};
+  }
+  return {.nbFrames = nbFrames,
+          .avgRenderTimeUs = static_cast<uint32_t>(renderTimeUs / nbFrames),
+          .maxRenderTimeUs = maxRenderTimeUs,
+          .avgFlushTimeUs = static_cast<uint32_t>(flushTimeUs / nbFrames),
+          .maxFlushTimeUs = maxFlushTimeUs,
+          .avgQueueWaitMs = static_cast<uint32_t>(queueWaitMs / nbFrames),
+          .avgDirtyPixels = static_cast<uint32_t>(dirtyPixels / nbFrames)};
+}
+
+void FrameProfiler::RecordFrame(uint8_t app, uint8_t watchFace) {
+  if (dirtyPixels == 0) {
+    // Nothing was drawn, keep accumulating the queue wait time until the next frame
+    return;
+  }
+
+  // A transfer still in progress is accounted to the next frame
+  taskENTER_CRITICAL();
+  uint32_t frameFlushTimeUs = flushTimeUs;
+  flushTimeUs = 0;
+  taskEXIT_CRITICAL();
+
+  const Frame frame {.renderTimeUs = Drivers::ProfilingTimer::ElapsedUs(renderStart),
+           .flushTimeUs = frameFlushTimeUs,
+           .queueWaitMs = Drivers::ProfilingTimer::TicksToMs(queueWaitTicks),
+           .dirtyPixels = dirtyPixels,
+           .app = app,
+           .watchFace = watchFace};
+  if (watchFace < MaxWatchFaces) {
+    watchFaceTotals[watchFace].Add(frame);
+  }
+
+  // Read by GetSnapshot() from other tasks
+  taskENTER_CRITICAL();
+  frames[head] = frame;
+  head = (head + 1) % MaxFrames;
+  totalFrames++;
+  taskEXIT_CRITICAL();
+  queueWaitTicks = 0;
+  dirtyPixels = 0;
+
+  if (head == 0) {
+    Log();
+  }
+}
+
+size_t FrameProfiler::NbFrames() const {
+  if constexpr (!Enabled) {
+    return 0;
+  }
+  return std::min<size_t>(totalFrames, MaxFrames);
+}
+
+const FrameProfiler::Frame& FrameProfiler::GetFrame(size_t index) const {
+  return frames[(head + MaxFrames - NbFrames() + index) % MaxFrames];
+}
+
+FrameProfiler::Snapshot FrameProfiler::GetSnapshot() const {
+  Snapshot snapshot {};
+  if constexpr (!Enabled) {
+    return snapshot;
+  }
+  // A few hundred bytes: the copy is short enough for a critical section
+  taskENTER_CRITICAL();
+  snapshot.totalFrames = totalFrames;
+  snapshot.nbFrames = static_cast<uint8_t>(std::min<size_t>(totalFrames, MaxFrames));
+  const size_t first = (head + MaxFrames - snapshot.nbFrames) % MaxFrames;
+  for (size_t i = 0; i < snapshot.nbFrames; i++) {
+    snapshot.frames[i] = frames[(first + i) % MaxFrames];
+  }
+  taskEXIT_CRITICAL();
+  return snapshot;
+}
+
+FrameProfiler::Summary FrameProfiler::GetSummary() const {
+  Totals totals;
+  for (size_t i = 0; i < NbFrames(); i++) {
+    totals.Add(GetFrame(i));
+  }
+  return totals.ToSummary();
+}
+
+FrameProfiler::Summary FrameProfiler::GetWatchFaceSummary(uint8_t watchFace) const {
+  if (!Enabled || watchFace >= MaxWatchFaces) {
+    return {};
+  }
+  return watchFaceTotals[watchFace].ToSummary();
+}
+
+void FrameProfiler::Log() const {
+  if constexpr (Enabled) {
+    [[maybe_unused]] auto summary = GetSummary();
+    NRF_LOG_INFO("[FrameProfiler] %lu frames, last %lu:", totalFrames, summary.nbFrames);
+    NRF_LOG_INFO("[FrameProfiler]  render avg %luus max %luus", summary.avgRenderTimeUs, summary.maxRenderTimeUs);
+    NRF_LOG_INFO("[FrameProfiler]  flush avg %luus max %luus", summary.avgFlushTimeUs, summary.maxFlushTimeUs);
+    NRF_LOG_INFO("[FrameProfiler]  dirty avg %lupx, wait avg %lums", summary.avgDirtyPixels, summary.avgQueueWaitMs);
+  }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "drivers/ProfilingTimer.h"
+
+#ifndef FRAME_PROFILER_ENABLED
+  #define FRAME_PROFILER_ENABLED 0
+#endif
+
+namespace Pinetime {
+  namespace Controllers {
+    // Records the cost of every frame DisplayApp sends to the display: time spent in lv_task_handler(),
+    // time spent in SPI transfers, number of pixels flushed and time spent waiting for a message before it.
+    // The hooks compile to nothing unless FRAME_PROFILER_ENABLED is set (cmake -DENABLE_FRAME_PROFILER=1).
+    // The render and flush times are measured in µs with the profiling TIMER, which then runs from the first frame on
+    // (it keeps the HF clock running). The queue wait spans the sleep of the CPU, it is measured with the tick RTC in ms.
+    class FrameProfiler {
+    public:
+      static constexpr bool Enabled = FRAME_PROFILER_ENABLED != 0;
+      // Disabled builds keep a single, never written, slot so that the ring arithmetic stays valid
+      static constexpr size_t MaxFrames = Enabled ? 16 : 1;
+      static constexpr size_t MaxWatchFaces = Enabled ? 8 : 1;
+      static constexpr uint8_t NoWatchFace = 0xff;
+
+      struct __attribute__((packed)) Frame {
+        uint32_t renderTimeUs; // Time spent in lv_task_handler(), including waiting for the flushes
+        uint32_t flushTimeUs;  // Sum of the SPI transfer times of all the strips of the frame
+        uint32_t queueWaitMs;  // Time DisplayApp was blocked on its message queue since the previous frame
+        uint32_t dirtyPixels;
+        uint8_t app;
+        uint8_t watchFace; // NoWatchFace unless app is the clock
+      };
+
+      // Frames of the ring buffer, from the oldest to the newest
+      struct Snapshot {
+        uint32_t totalFrames;
+        uint8_t nbFrames;
+        std::array<Frame, MaxFrames> frames;
+      };
+
+      struct Summary {
+        uint32_t nbFrames;
+        uint32_t avgRenderTimeUs;
+        uint32_t maxRenderTimeUs;
+        uint32_t avgFlushTimeUs;
+        uint32_t maxFlushTimeUs;
+        uint32_t avgQueueWaitMs;
+        uint32_t avgDirtyPixels;
+      };
+
+      void OnRenderStart() {
+        if constexpr (Enabled) {
+          if (!isTimerStarted) {
+            Drivers::ProfilingTimer::Start();
+            isTimerStarted = true;
+          }
+          renderStart = Drivers::ProfilingTimer::NowUs();
+        }
+      }
+
+      void OnRenderEnd(uint8_t app, uint8_t watchFace) {
+        if constexpr (Enabled) {
+          RecordFrame(app, watchFace);
+        }
+      }
+
+      void OnQueueWaitStart() {
+        if constexpr (Enabled) {
+          queueWaitStart = Drivers::ProfilingTimer::NowTicks();
+        }
+      }
+
+      void OnQueueWaitEnd() {
+        if constexpr (Enabled) {
+          queueWaitTicks += Drivers::ProfilingTimer::ElapsedTicks(queueWaitStart);
+        }
+      }
+
+      void OnFlushStart(uint32_t nbPixels) {
+        if constexpr (Enabled) {
+          dirtyPixels += nbPixels;
+          flushStart = Drivers::ProfilingTimer::NowUs();
+        }
+      }
+
+      // Called from the SPI interrupt
+      void OnFlushEnd() {
+        if constexpr (Enabled) {
+          flushTimeUs = flushTimeUs + Drivers::ProfilingTimer::ElapsedUs(flushStart);
+        }
+      }
+
+      // Copy of the ring buffer, consistent even while the display task records a frame. Can be called from any task.
+      Snapshot GetSnapshot() const;
+      // The functions below read the ring buffer without synchronization: they are called by the display task only.
+      // Number of frames currently held in the ring buffer
+      size_t NbFrames() const;
+      // Number of frames recorded since boot
+      uint32_t TotalFrames() const {
+        return totalFrames;
+      }
+      // 0 is the oldest frame still in the ring buffer
+      const Frame& GetFrame(size_t index) const;
+      // Statistics of the frames held in the ring buffer
+      Summary GetSummary() const;
+      // Statistics of all the frames drawn by the given watch face since boot
+      Summary GetWatchFaceSummary(uint8_t watchFace) const;
+      void Log() const;
+
+    private:
+      struct Totals {
+        uint32_t nbFrames = 0;
+        uint64_t renderTimeUs = 0;
+        uint32_t maxRenderTimeUs = 0;
+        uint64_t flushTimeUs = 0;
+        uint32_t maxFlushTimeUs = 0;
+        uint64_t queueWaitMs = 0;
+        uint64_t dirtyPixels = 0;
+
+        void Add(const Frame& frame);
+        Summary ToSummary() const;
+      };
+
+      void RecordFrame(uint8_t app, uint8_t watchFace);
+
+      std::array<Frame, MaxFrames> frames;
+      size_t head = 0;
+      uint32_t totalFrames = 0;
+      std::array<Totals, MaxWatchFaces> watchFaceTotals;
+
+      uint32_t renderStart = 0;
+      uint32_t queueWaitStart = 0;
+      uint32_t queueWaitTicks = 0;
+      uint32_t dirtyPixels = 0;
+      uint32_t flushStart = 0;
+      volatile uint32_t flushTimeUs = 0;
+      bool isTimerStarted = false;
+    };
+  }
+}
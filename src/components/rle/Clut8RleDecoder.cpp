@@ -0,0 +1,83 @@
+#include "components/rle/Clut8RleDecoder.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace Pinetime::Tools;
+
+Clut8RleDecoder::Clut8RleDecoder(const uint8_t* buffer, size_t size) : buffer {buffer}, size {size} {
+  if (size < headerSize || buffer[0] != format) {
+    return;
+  }
+  width = buffer[1] | (buffer[2] << 8);
+  height = buffer[3] | (buffer[4] << 8);
+  stripHeight = buffer[5];
+  if (width == 0 || stripHeight == 0) {
+    return;
+  }
+  nbStrips = (height + stripHeight - 1) / stripHeight;
+  isValid = size >= headerSize + nbStrips * 4;
+  nextLine = height;
+}
+
+bool Clut8RleDecoder::DecodeLine(uint16_t y, uint8_t* indices) {
+  if (!isValid || y >= height) {
+    return false;
+  }
+  if ((y != nextLine && !Seek(y)) || !Decode(indices, width)) {
+    // Corrupted, decode the line again from the start of its strip next time
+    nextLine = height;
+    return false;
+  }
+  nextLine = y + 1;
+  return true;
+}
+
+bool Clut8RleDecoder::Seek(uint16_t y) {
+  uint16_t strip = y / stripHeight;
+  const uint8_t* offset = buffer + headerSize + strip * 4;
+  encodedBufferIndex =
+    headerSize + nbStrips * 4 + (offset[0] | (offset[1] << 8) | (offset[2] << 16) | (static_cast<uint32_t>(offset[3]) << 24));
+  runRemaining = 0;
+  // The lines of the strip before y are skipped
+  return Decode(nullptr, (y - strip * stripHeight) * width);
+}
+
+bool Clut8RleDecoder::Decode(uint8_t* output, size_t nbPixels) {
+  while (nbPixels > 0) {
+    if (runRemaining == 0) {
+      if (encodedBufferIndex >= size) {
+        return false;
+      }
+      uint8_t control = buffer[encodedBufferIndex++];
+      isLiteralRun = control >= 128;
+      if (isLiteralRun) {
+        runRemaining = control - 127;
+      } else {
+        if (encodedBufferIndex >= size) {
+          return false;
+        }
+        runRemaining = control + 1;
+        runIndex = buffer[encodedBufferIndex++];
+      }
+    }
+
+    uint8_t count = std::min<size_t>(runRemaining, nbPixels);
+    if (isLiteralRun) {
+      if (size - encodedBufferIndex < count) {
+        return false;
+      }
+      if (output != nullptr) {
+        std::memcpy(output, buffer + encodedBufferIndex, count);
+      }
+      encodedBufferIndex += count;
+    } else if (output != nullptr) {
+      std::memset(output, runIndex, count);
+    }
+    if (output != nullptr) {
+      output += count;
+    }
+    nbPixels -= count;
+    runRemaining -= count;
+  }
+  return true;
+}
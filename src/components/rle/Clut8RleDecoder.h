@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Tools {
+    /* Run length decoder for full colour images, generated by tools/rle_encode.py --clut8.
+     *
+     * Pixels are indices in the 256 colours palette of wasp-os (CLUT8), coded in PackBits runs: a control byte
+     * c < 128 repeats the next index c + 1 times, c >= 128 is followed by c - 127 indices. The image is split in strips
+     * of a few lines, runs don't cross strips and a table gives the offset of every strip, so that any line can be
+     * decoded without decoding the strips before it.
+     *
+     * Layout: 8 | width (u16) | height (u16) | strip height (u8) | strip offsets (u32 each) | runs, little endian.
+     */
+    class Clut8RleDecoder {
+    public:
+      Clut8RleDecoder(const uint8_t* buffer, size_t size);
+
+      bool IsValid() const {
+        return isValid;
+      }
+
+      uint16_t Width() const {
+        return width;
+      }
+
+      uint16_t Height() const {
+        return height;
+      }
+
+      // Writes the width palette indices of line y. Decoding the line after the previous one doesn't seek.
+      bool DecodeLine(uint16_t y, uint8_t* indices);
+
+      static constexpr uint32_t ToRgb888(uint8_t index) {
+        if (index < 216) {
+          return (index % 6) * 0x33 + ((index / 6) % 6) * 0x3300 + (index / 36) * 0x330000;
+        }
+        if (index < 252) {
+          uint32_t i = index - 216;
+          return 0x7f + (i % 3) * 0x33 + 0x4c00 + ((i / 3) % 4) * 0x3300 + 0x7f0000 + (i / 12) * 0x330000;
+        }
+        return 0x2c2c2c + 0x101010 * (index - 252);
+      }
+
+      static constexpr uint16_t ToRgb565(uint8_t index) {
+        if (index < 216) {
+          return (((index % 6) * 0x33) >> 3) + ((((index / 6) % 6) * (0x33 << 3)) & 0x07e0) +
+                 (((index / 36) * (0x33 << 8)) & 0xf800);
+        }
+        if (index < 252) {
+          uint32_t i = index - 216;
+          return ((0x7f + (i % 3) * 0x33) >> 3) + (((0x4c << 3) + ((i / 3) % 4) * (0x33 << 3)) & 0x07e0) +
+                 (((0x7f << 8) + (i / 12) * (0x33 << 8)) & 0xf800);
+        }
+        uint16_t gray6 = (0x2c + 0x10 * (index - 252)) >> 2;
+        uint16_t gray5 = gray6 >> 1;
+        return (gray5 << 11) + (gray6 << 5) + gray5;
+      }
+
+    private:
+      static constexpr uint8_t format = 8;
+      static constexpr size_t headerSize = 6;
+
+      const uint8_t* buffer;
+      size_t size;
+      bool isValid = false;
+      uint16_t width = 0;
+      uint16_t height = 0;
+      uint8_t stripHeight = 0;
+      uint16_t nbStrips = 0;
+
+      // Line the encoded buffer index points to
+      uint16_t nextLine = 0;
+      size_t encodedBufferIndex = 0;
+      // Pixels left in the current run, which may continue on the next line
+      uint8_t runRemaining = 0;
+      bool isLiteralRun = false;
+      uint8_t runIndex = 0;
+
+      bool Seek(uint16_t y);
+      // Decodes nbPixels indices, skips them if output is null
+      bool Decode(uint8_t* output, size_t nbPixels);
+    };
+  }
+}
@@ -1,13 +1,15 @@
 #include "components/settings/Settings.h"
 #include <cstdlib>
 #include <cstring>
+#include "systemtask/SystemTask.h"
 
 using namespace Pinetime::Controllers;
 
 Settings::Settings(Pinetime::Controllers::FS& fs) : fs {fs} {
 }
 
-void Settings::Init() {
+void Settings::Init(System::SystemTask* systemTask) {
+  this->systemTask = systemTask;
 
   // Load default settings from Flash
   LoadSettingsFromFile();
@@ -17,7 +19,14 @@ void Settings::SaveSettings() {
 
   // verify if is necessary to save
   if (settingsChanged) {
-    SaveSettingsToFile();
+    if (systemTask != nullptr) {
+      taskENTER_CRITICAL();
+      savedSettings = settings;
+      taskEXIT_CRITICAL();
+      systemTask->QueueSave(System::Messages::SaveSettings);
+    } else {
+      WriteSettingsFile(settings);
+    }
   }
   settingsChanged = false;
 }
@@ -37,11 +46,19 @@ void Settings::LoadSettingsFromFile() {
 }
 
 void Settings::SaveSettingsToFile() {
+  // SaveSettings() may be called again while the file is being written
+  taskENTER_CRITICAL();
+  SettingsData data = savedSettings;
+  taskEXIT_CRITICAL();
+  WriteSettingsFile(data);
+}
+
+void Settings::WriteSettingsFile(const SettingsData& data) {
   lfs_file_t settingsFile;
 
   if (fs.FileOpen(&settingsFile, "/settings.dat", LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
     return;
   }
-  fs.FileWrite(&settingsFile, reinterpret_cast<uint8_t*>(&settings), sizeof(settings));
+  fs.FileWrite(&settingsFile, reinterpret_cast<const uint8_t*>(&data), sizeof(data));
   fs.FileClose(&settingsFile);
 }
@@ -9,6 +9,10 @@
 #include <nrf_log.h>
 
 namespace Pinetime {
+  namespace System {
+    class SystemTask;
+  }
+
   namespace Controllers {
     class Settings {
     public:
@@ -62,8 +66,12 @@ namespace Pinetime {
       Settings(Settings&&) = delete;
       Settings& operator=(Settings&&) = delete;
 
-      void Init();
+      void Init(System::SystemTask* systemTask);
+      // Once Init() is called, the file is written by the system task from a copy of the settings taken here, so that the
+      // caller doesn't wait for the flash. SystemTask::WaitForSaves() signals the end of the write.
       void SaveSettings();
+      // Called by the system task, writes the copy taken by the last SaveSettings()
+      void SaveSettingsToFile();
 
       void SetWatchFace(Pinetime::Applications::WatchFace face) {
         if (face != settings.watchFace) {
@@ -353,6 +361,7 @@ namespace Pinetime {
 
     private:
       Pinetime::Controllers::FS& fs;
+      System::SystemTask* systemTask = nullptr;
 
       static constexpr uint32_t settingsVersion = 0x000a;
 
@@ -387,6 +396,8 @@ namespace Pinetime {
 
       SettingsData settings;
       bool settingsChanged = false;
+      // Copied by SaveSettings() and read by the system task, in critical sections
+      SettingsData savedSettings;
 
       uint8_t appMenu = 0;
       uint8_t settingsMenu = 0;
@@ -398,7 +409,7 @@ namespace Pinetime {
       bool dfuAndFsEnabledTillReboot = false;
 
       void LoadSettingsFromFile();
-      void SaveSettingsToFile();
+      void WriteSettingsFile(const SettingsData& data);
     };
   }
 }
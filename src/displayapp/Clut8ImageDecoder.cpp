@@ -0,0 +1,89 @@
+#include "displayapp/Clut8ImageDecoder.h"
+#include <new>
+#include "components/rle/Clut8RleDecoder.h"
+
+using namespace Pinetime::Components;
+
+namespace {
+  // Followed by the palette indices of the last decoded line
+  struct DecoderState {
+    Pinetime::Tools::Clut8RleDecoder decoder;
+    lv_coord_t decodedLine = -1;
+  };
+
+  const lv_img_dsc_t* GetImage(const void* src) {
+    if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) {
+      return nullptr;
+    }
+    const auto* image = static_cast<const lv_img_dsc_t*>(src);
+    if (image->header.cf != Clut8ImageDecoder::colorFormat) {
+      return nullptr;
+    }
+    return image;
+  }
+
+  lv_res_t Info(lv_img_decoder_t* /*decoder*/, const void* src, lv_img_header_t* header) {
+    const auto* image = GetImage(src);
+    if (image == nullptr) {
+      return LV_RES_INV;
+    }
+    header->cf = LV_IMG_CF_TRUE_COLOR;
+    header->always_zero = 0;
+    header->w = image->header.w;
+    header->h = image->header.h;
+    return LV_RES_OK;
+  }
+
+  lv_res_t Open(lv_img_decoder_t* /*decoder*/, lv_img_decoder_dsc_t* dsc) {
+    const auto* image = GetImage(dsc->src);
+    if (image == nullptr) {
+      return LV_RES_INV;
+    }
+    Pinetime::Tools::Clut8RleDecoder decoder {image->data, image->data_size};
+    if (!decoder.IsValid() || decoder.Width() != image->header.w || decoder.Height() != image->header.h) {
+      return LV_RES_INV;
+    }
+    void* memory = lv_mem_alloc(sizeof(DecoderState) + decoder.Width());
+    if (memory == nullptr) {
+      return LV_RES_INV;
+    }
+    dsc->user_data = new (memory) DecoderState {decoder};
+    // Decoded a line at a time by ReadLine()
+    dsc->img_data = nullptr;
+    return LV_RES_OK;
+  }
+
+  lv_res_t ReadLine(lv_img_decoder_t* /*decoder*/, lv_img_decoder_dsc_t* dsc, lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t* buf) {
+    auto* state = static_cast<DecoderState*>(dsc->user_data);
+    auto* line = reinterpret_cast<uint8_t*>(state + 1);
+    // LVGL reads the same line again for every area of the image it redraws
+    if (state->decodedLine != y) {
+      if (!state->decoder.DecodeLine(y, line)) {
+        return LV_RES_INV;
+      }
+      state->decodedLine = y;
+    }
+    auto* pixels = reinterpret_cast<lv_color_t*>(buf);
+    for (lv_coord_t idx = 0; idx < len; idx++) {
+      pixels[idx] = lv_color_hex(Pinetime::Tools::Clut8RleDecoder::ToRgb888(line[x + idx]));
+    }
+    return LV_RES_OK;
+  }
+
+  void Close(lv_img_decoder_t* /*decoder*/, lv_img_decoder_dsc_t* dsc) {
+    auto* state = static_cast<DecoderState*>(dsc->user_data);
+    if (state != nullptr) {
+      state->~DecoderState();
+      lv_mem_free(state);
+      dsc->user_data = nullptr;
+    }
+  }
+}
+
+void Clut8ImageDecoder::Register() {
+  lv_img_decoder_t* decoder = lv_img_decoder_create();
+  lv_img_decoder_set_info_cb(decoder, Info);
+  lv_img_decoder_set_open_cb(decoder, Open);
+  lv_img_decoder_set_read_line_cb(decoder, ReadLine);
+  lv_img_decoder_set_close_cb(decoder, Close);
+}
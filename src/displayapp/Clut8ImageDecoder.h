@@ -0,0 +1,17 @@
+#pragma once
+
+#include <lvgl/lvgl.h>
+
+namespace Pinetime {
+  namespace Components {
+    // LVGL image decoder of the images encoded by tools/rle_encode.py --clut8 (see Tools::Clut8RleDecoder).
+    // The images are declared as lv_img_dsc_t with the colorFormat color format, and only the lines of the strip LVGL
+    // is rendering are decoded.
+    class Clut8ImageDecoder {
+    public:
+      static constexpr lv_img_cf_t colorFormat = LV_IMG_CF_USER_ENCODED_0;
+
+      static void Register();
+    };
+  }
+}
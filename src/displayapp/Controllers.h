@@ -23,6 +23,8 @@ namespace Pinetime {
     class BrightnessController;
     class SimpleWeatherService;
     class FS;
+    class HistoryController;
+    class ChangeNotifier;
     class Timer;
     class MusicService;
     class NavigationService;
@@ -47,6 +49,8 @@ namespace Pinetime {
       Pinetime::Controllers::BrightnessController& brightnessController;
       Pinetime::Controllers::SimpleWeatherService* weatherController;
       Pinetime::Controllers::FS& filesystem;
+      Pinetime::Controllers::HistoryController& historyController;
+      Pinetime::Controllers::ChangeNotifier& changeNotifier;
       Pinetime::Controllers::Timer& timer;
       Pinetime::System::SystemTask* systemTask;
       Pinetime::Applications::DisplayApp* displayApp;
@@ -1,5 +1,6 @@
 #include "displayapp/DisplayApp.h"
 #include <libraries/log/nrf_log.h>
+#include "displayapp/LvglArena.h"
 #include "displayapp/screens/HeartRate.h"
 #include "displayapp/screens/Motion.h"
 #include "displayapp/screens/Timer.h"
@@ -88,7 +89,10 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
                        Pinetime::Controllers::BrightnessController& brightnessController,
                        Pinetime::Controllers::TouchHandler& touchHandler,
                        Pinetime::Controllers::FS& filesystem,
-                       Pinetime::Drivers::SpiNorFlash& spiNorFlash)
+                       Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                       Pinetime::Controllers::FrameProfiler& frameProfiler,
+                       Pinetime::Controllers::HistoryController& historyController,
+                       Pinetime::Controllers::ChangeNotifier& changeNotifier)
   : lcd {lcd},
     touchPanel {touchPanel},
     batteryController {batteryController},
@@ -106,7 +110,10 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
     touchHandler {touchHandler},
     filesystem {filesystem},
     spiNorFlash {spiNorFlash},
-    lvgl {lcd, filesystem},
+    frameProfiler {frameProfiler},
+    historyController {historyController},
+    changeNotifier {changeNotifier},
+    lvgl {lcd, filesystem, frameProfiler},
     timer(this, TimerCallback),
     controllers {batteryController,
                  bleController,
@@ -121,6 +128,8 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
                  brightnessController,
                  nullptr,
                  filesystem,
+                 historyController,
+                 changeNotifier,
                  timer,
                  nullptr,
                  this,
@@ -133,6 +142,7 @@ void DisplayApp::Start(System::BootErrors error) {
   msgQueue = xQueueCreate(queueSize, itemSize);
 
   bootError = error;
+  changeNotifier.Register(this);
 
   if (pdPASS != xTaskCreate(DisplayApp::Process, "displayapp", 800, this, 0, &taskHandle)) {
     APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
@@ -201,6 +211,57 @@ TickType_t DisplayApp::CalculateSleepTime() {
   }
 }
 
+std::chrono::milliseconds DisplayApp::TimeRefreshPeriod() const {
+  using Topic = Controllers::ChangeNotifier::Topic;
+  auto subscriptions = changeNotifier.Subscriptions();
+  if ((subscriptions & Controllers::ChangeNotifier::Mask(Topic::Seconds)) != 0) {
+    return std::chrono::seconds {1};
+  }
+  if ((subscriptions & Controllers::ChangeNotifier::Mask(Topic::Minutes)) != 0) {
+    return std::chrono::minutes {1};
+  }
+  return std::chrono::milliseconds::zero();
+}
+
+TickType_t DisplayApp::TicksUntilTimeChange() {
+  auto period = TimeRefreshPeriod();
+  if (period == std::chrono::milliseconds::zero()) {
+    return portMAX_DELAY;
+  }
+  auto now = std::chrono::duration_cast<std::chrono::milliseconds>(dateTimeController.CurrentDateTime().time_since_epoch());
+  // Rounded up, the screen must be refreshed after the change, not just before
+  return pdMS_TO_TICKS((period - now % period).count()) + 1;
+}
+
+void DisplayApp::RefreshScreenOnChanges() {
+  using Topic = Controllers::ChangeNotifier::Topic;
+  auto changes = changeNotifier.TakeChanges();
+  auto period = TimeRefreshPeriod();
+  if (period != std::chrono::milliseconds::zero()) {
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(dateTimeController.CurrentDateTime().time_since_epoch());
+    auto timeSlot = static_cast<uint32_t>(now / period);
+    if (timeSlot != lastTimeSlot) {
+      lastTimeSlot = timeSlot;
+      changes |= Controllers::ChangeNotifier::Mask(Topic::Minutes);
+    }
+  }
+  if (changes != 0 || (changeNotifier.Subscriptions() & Controllers::ChangeNotifier::Mask(Topic::Frame)) != 0) {
+    currentScreen->Refresh();
+  }
+}
+
+bool DisplayApp::IsWaitingForChanges() {
+  using Topic = Controllers::ChangeNotifier::Topic;
+  auto subscriptions = changeNotifier.Subscriptions();
+  // Screens that don't subscribe poll the controllers in their own LVGL task
+  if (subscriptions == 0 || (subscriptions & Controllers::ChangeNotifier::Mask(Topic::Frame)) != 0) {
+    return false;
+  }
+  // LVGL must first process the release of the touch, run the animations and draw what the screen invalidated
+  return !touchHandler.IsTouching() && lv_disp_get_inactive_time(nullptr) >= pdMS_TO_TICKS(inputSettlingTime) &&
+         lv_anim_count_running() == 0 && lv_disp_get_default()->inv_p == 0 && !lvgl.IsFullRefreshPending();
+}
+
 void DisplayApp::Refresh() {
   auto LoadPreviousScreen = [this]() {
     FullRefreshDirections returnDirection;
@@ -232,6 +293,27 @@ void DisplayApp::Refresh() {
     return lv_disp_get_inactive_time(nullptr) >= pdMS_TO_TICKS(settingsController.GetScreenTimeOut());
   };
 
+  auto TicksUntilDimOrSleep = [this]() -> TickType_t {
+    TickType_t inactiveTime = lv_disp_get_inactive_time(nullptr);
+    TickType_t dimTime = pdMS_TO_TICKS(settingsController.GetScreenTimeOut() - 2000);
+    TickType_t sleepTime = pdMS_TO_TICKS(settingsController.GetScreenTimeOut());
+    if (inactiveTime < dimTime) {
+      return dimTime - inactiveTime;
+    }
+    if (inactiveTime < sleepTime) {
+      return sleepTime - inactiveTime;
+    }
+    return pdMS_TO_TICKS(LV_DISP_DEF_REFR_PERIOD);
+  };
+
+  auto OnRenderEnd = [this]() {
+    uint8_t watchFace = Controllers::FrameProfiler::NoWatchFace;
+    if (currentApp == Apps::Clock) {
+      watchFace = static_cast<uint8_t>(settingsController.GetWatchFace());
+    }
+    frameProfiler.OnRenderEnd(static_cast<uint8_t>(currentApp), watchFace);
+  };
+
   TickType_t queueTimeout;
   switch (state) {
     case States::Idle:
@@ -249,7 +331,11 @@ void DisplayApp::Refresh() {
         // Only advance the tick count when LVGL is done
         // Otherwise keep running the task handler while it still has things to draw
         // Note: under high graphics load, LVGL will always have more work to do
-        if (lv_task_handler() > 0) {
+        RefreshScreenOnChanges();
+        frameProfiler.OnRenderStart();
+        auto nextTaskRun = lv_task_handler();
+        OnRenderEnd();
+        if (nextTaskRun > 0) {
           // Drop frames that we've missed if drawing/event handling took way longer than expected
           while (queueTimeout == 0) {
             alwaysOnFrameCount += 1;
@@ -257,12 +343,26 @@ void DisplayApp::Refresh() {
           }
         }
       }
+      if (IsWaitingForChanges() && TimeRefreshPeriod() != std::chrono::milliseconds::zero()) {
+        // The notifier is suspended, the other values are refreshed along with the time
+        queueTimeout = TicksUntilTimeChange();
+      }
       break;
     case States::Running:
       if (!currentScreen->IsRunning()) {
         LoadPreviousScreen();
       }
+      RefreshScreenOnChanges();
+      frameProfiler.OnRenderStart();
       queueTimeout = lv_task_handler();
+      OnRenderEnd();
+      if (IsWaitingForChanges()) {
+        // Nothing to draw until a value shown by the screen changes, wake up anyway to dim the screen
+        queueTimeout = TicksUntilTimeChange();
+        if (!systemTask->IsSleepDisabled()) {
+          queueTimeout = std::min(queueTimeout, TicksUntilDimOrSleep());
+        }
+      }
 
       if (!systemTask->IsSleepDisabled() && IsPastDimTime()) {
         if (!isDimmed) {
@@ -295,7 +395,10 @@ void DisplayApp::Refresh() {
   }
 
   Messages msg;
-  if (xQueueReceive(msgQueue, &msg, queueTimeout) == pdTRUE) {
+  frameProfiler.OnQueueWaitStart();
+  auto received = xQueueReceive(msgQueue, &msg, queueTimeout);
+  frameProfiler.OnQueueWaitEnd();
+  if (received == pdTRUE) {
     switch (msg) {
       case Messages::GoToSleep:
       case Messages::GoToAOD:
@@ -332,15 +435,18 @@ void DisplayApp::Refresh() {
         lvgl.ClearTouchState();
         if (msg == Messages::GoToAOD) {
           lcd.LowPowerOn();
+          lvgl.SetAlwaysOnMode(true);
           // Record idle entry time
           alwaysOnFrameCount = 0;
           alwaysOnStartTime = xTaskGetTickCount();
           PushMessageToSystemTask(Pinetime::System::Messages::OnDisplayTaskAOD);
           state = States::AOD;
+          changeNotifier.Suspend();
         } else {
           lcd.Sleep();
           PushMessageToSystemTask(Pinetime::System::Messages::OnDisplayTaskSleeping);
           state = States::Idle;
+          changeNotifier.Suspend();
         }
         break;
       case Messages::NotifyDeviceActivity:
@@ -354,6 +460,7 @@ void DisplayApp::Refresh() {
           break;
         }
         if (state == States::AOD) {
+          lvgl.SetAlwaysOnMode(false);
           lcd.LowPowerOff();
         } else {
           lcd.Wakeup();
@@ -361,6 +468,7 @@ void DisplayApp::Refresh() {
         lv_disp_trig_activity(nullptr);
         ApplyBrightness();
         state = States::Running;
+        changeNotifier.Resume();
         break;
       case Messages::UpdateBleConnection:
         // Only used for recovery firmware
@@ -482,6 +590,9 @@ void DisplayApp::Refresh() {
         LoadNewScreen(Apps::Clock, DisplayApp::FullRefreshDirections::None);
         motorController.RunForDuration(35);
         break;
+      case Messages::ValuesChanged:
+        // The screen is refreshed by the next call to Refresh()
+        break;
     }
   }
 
@@ -517,6 +628,11 @@ void DisplayApp::LoadScreen(Apps app, DisplayApp::FullRefreshDirections directio
   motorController.StopRinging();
 
   currentScreen.reset(nullptr);
+  uint32_t lvglPeak = Components::LvglArena::StartScreen();
+  if constexpr (Controllers::FrameProfiler::Enabled) {
+    NRF_LOG_INFO("LVGL arena peak of app %d : %d bytes", static_cast<uint8_t>(currentApp), lvglPeak);
+  }
+  changeNotifier.Unsubscribe();
   SetFullRefresh(direction);
 
   switch (app) {
@@ -550,7 +666,7 @@ void DisplayApp::LoadScreen(Apps app, DisplayApp::FullRefreshDirections directio
       break;
 
     case Apps::FirmwareValidation:
-      currentScreen = std::make_unique<Screens::FirmwareValidation>(validator);
+      currentScreen = std::make_unique<Screens::FirmwareValidation>(validator, *systemTask);
       break;
     case Apps::FirmwareUpdate:
       currentScreen = std::make_unique<Screens::FirmwareUpdate>(bleController);
@@ -643,7 +759,9 @@ void DisplayApp::LoadScreen(Apps app, DisplayApp::FullRefreshDirections directio
                                                             watchdog,
                                                             motionController,
                                                             touchPanel,
-                                                            spiNorFlash);
+                                                            spiNorFlash,
+                                                            frameProfiler,
+                                                            systemTask->GetSystemMonitor());
       break;
     case Apps::FlashLight:
       currentScreen = std::make_unique<Screens::FlashLight>(*systemTask, brightnessController);
@@ -673,7 +791,8 @@ void DisplayApp::PushMessage(Messages msg) {
     // Make xQueueSend() non-blocking if the message is a Notification message. We do this to avoid
     // deadlock between SystemTask and DisplayApp when their respective message queues are getting full
     // when a lot of notifications are received on a very short time span.
-    if (msg == Messages::NewNotification) {
+    // ValuesChanged can be dropped too, the changes are checked every time DisplayApp wakes up.
+    if (msg == Messages::NewNotification || msg == Messages::ValuesChanged) {
       timeout = static_cast<TickType_t>(0);
     }
 
@@ -2,6 +2,7 @@
 #include <FreeRTOS.h>
 #include <queue.h>
 #include <task.h>
+#include <chrono>
 #include <memory>
 #include <systemtask/Messages.h>
 #include "displayapp/apps/Apps.h"
@@ -15,6 +16,7 @@
 #include "components/timer/Timer.h"
 #include "components/stopwatch/StopWatchController.h"
 #include "components/alarm/AlarmController.h"
+#include "components/changes/ChangeNotifier.h"
 #include "touchhandler/TouchHandler.h"
 
 #include "displayapp/Messages.h"
@@ -41,6 +43,9 @@ namespace Pinetime {
     class MotionController;
     class TouchHandler;
     class SimpleWeatherService;
+    class FrameProfiler;
+    class HistoryController;
+    class ChangeNotifier;
   }
 
   namespace System {
@@ -69,7 +74,10 @@ namespace Pinetime {
                  Pinetime::Controllers::BrightnessController& brightnessController,
                  Pinetime::Controllers::TouchHandler& touchHandler,
                  Pinetime::Controllers::FS& filesystem,
-                 Pinetime::Drivers::SpiNorFlash& spiNorFlash);
+                 Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                 Pinetime::Controllers::FrameProfiler& frameProfiler,
+                 Pinetime::Controllers::HistoryController& historyController,
+                 Pinetime::Controllers::ChangeNotifier& changeNotifier);
       void Start(System::BootErrors error);
       void PushMessage(Display::Messages msg);
 
@@ -101,6 +109,9 @@ namespace Pinetime {
       Pinetime::Controllers::TouchHandler& touchHandler;
       Pinetime::Controllers::FS& filesystem;
       Pinetime::Drivers::SpiNorFlash& spiNorFlash;
+      Pinetime::Controllers::FrameProfiler& frameProfiler;
+      Pinetime::Controllers::HistoryController& historyController;
+      Pinetime::Controllers::ChangeNotifier& changeNotifier;
 
       Pinetime::Controllers::FirmwareValidator validator;
       Pinetime::Components::LittleVgl lvgl;
@@ -141,6 +152,15 @@ namespace Pinetime {
 
       bool isDimmed = false;
 
+      // Screens subscribed to ChangeNotifier are only refreshed when the values they show change
+      void RefreshScreenOnChanges();
+      bool IsWaitingForChanges();
+      TickType_t TicksUntilTimeChange();
+      std::chrono::milliseconds TimeRefreshPeriod() const;
+      uint32_t lastTimeSlot = 0;
+      // LVGL keeps running for this long (ms) after the last touch, to process its release
+      static constexpr uint32_t inputSettlingTime = 200;
+
       TickType_t CalculateSleepTime();
       TickType_t alwaysOnFrameCount;
       TickType_t alwaysOnStartTime;
@@ -26,7 +26,10 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
                        Pinetime::Controllers::BrightnessController& /*brightnessController*/,
                        Pinetime::Controllers::TouchHandler& /*touchHandler*/,
                        Pinetime::Controllers::FS& /*filesystem*/,
-                       Pinetime::Drivers::SpiNorFlash& /*spiNorFlash*/)
+                       Pinetime::Drivers::SpiNorFlash& /*spiNorFlash*/,
+                       Pinetime::Controllers::FrameProfiler& /*frameProfiler*/,
+                       Pinetime::Controllers::HistoryController& /*historyController*/,
+                       Pinetime::Controllers::ChangeNotifier& /*changeNotifier*/)
   : lcd {lcd}, bleController {bleController} {
 }
 
@@ -38,6 +38,9 @@ namespace Pinetime {
     class SimpleWeatherService;
     class MusicService;
     class NavigationService;
+    class FrameProfiler;
+    class HistoryController;
+    class ChangeNotifier;
   }
 
   namespace System {
@@ -63,7 +66,10 @@ namespace Pinetime {
                  Pinetime::Controllers::BrightnessController& brightnessController,
                  Pinetime::Controllers::TouchHandler& touchHandler,
                  Pinetime::Controllers::FS& filesystem,
-                 Pinetime::Drivers::SpiNorFlash& spiNorFlash);
+                 Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                 Pinetime::Controllers::FrameProfiler& frameProfiler,
+                 Pinetime::Controllers::HistoryController& historyController,
+                 Pinetime::Controllers::ChangeNotifier& changeNotifier);
       void Start();
 
       void Start(Pinetime::System::BootErrors) {
@@ -0,0 +1,355 @@
+#include "displayapp/GlyphCache.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <FreeRTOS.h>
+#include "components/fs/FS.h"
+
+using namespace Pinetime::Components;
+
+namespace {
+  // The 5 glyphs of the time in 7 segments 115 px (1 bpp) fit in the buffer
+  constexpr size_t bufferSize = 4096;
+  constexpr size_t maxEntries = 24;
+  constexpr size_t maxFonts = 4;
+  constexpr size_t maxPathLength = 64;
+
+  // Bin fonts of lv_font_conv, as read by lv_font_loader.c: a sequence of sections (head, cmap, loca, glyf, kern), each
+  // of them starting with a label. The glyphs in the glyf section are bit streams: a header of nbits (advance width, x
+  // and y offsets, width and height), immediately followed by the bitmap.
+  struct SectionLabel {
+    uint32_t length; // Of the whole section, label included
+    char name[4];
+  };
+
+  struct FontHeader {
+    uint32_t version;
+    uint16_t tablesCount;
+    uint16_t fontSize;
+    uint16_t ascent;
+    int16_t descent;
+    uint16_t typoAscent;
+    int16_t typoDescent;
+    uint16_t typoLineGap;
+    int16_t minY;
+    int16_t maxY;
+    uint16_t defaultAdvanceWidth;
+    uint16_t kerningScale;
+    uint8_t indexToLocFormat; // 0: the offsets of the loca section are 16 bits, 1: 32 bits
+    uint8_t glyphIdFormat;
+    uint8_t advanceWidthFormat;
+    uint8_t bitsPerPixel;
+    uint8_t xyBits;
+    uint8_t whBits;
+    uint8_t advanceWidthBits;
+    uint8_t compressionId;
+    uint8_t subpixelsMode;
+    uint8_t padding;
+  };
+
+  static_assert(sizeof(FontHeader) == 36);
+
+  struct CachedFont {
+    const lv_font_t* font;
+    Pinetime::Controllers::FS* fs;
+    lfs_file_t file;
+    // The bitmaps start this many bits after the byte given by their bitmap_index
+    uint8_t bitShift;
+  };
+
+  struct Entry {
+    const lv_font_t* font;
+    uint32_t letter;
+    size_t offset; // In buffer
+    size_t size;
+    uint32_t lastUsed; // 0 if the entry is free
+  };
+
+  std::array<CachedFont, maxFonts> fonts {};
+  std::array<Entry, maxEntries> entries {};
+  // Allocated from the FreeRTOS heap while a font is cached, the bitmaps are packed at its beginning
+  uint8_t* buffer = nullptr;
+  size_t bufferUsed = 0;
+  uint32_t useCounter = 0;
+
+  // Same lookup as LVGL (lv_font_fmt_txt.c), which doesn't export it
+  uint32_t GlyphId(const lv_font_fmt_txt_dsc_t* fdsc, uint32_t letter) {
+    for (uint16_t i = 0; i < fdsc->cmap_num; i++) {
+      const auto& cmap = fdsc->cmaps[i];
+      if (letter < cmap.range_start || letter - cmap.range_start >= cmap.range_length) {
+        continue;
+      }
+      uint32_t rcp = letter - cmap.range_start;
+      switch (cmap.type) {
+        case LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY:
+          return cmap.glyph_id_start + rcp;
+        case LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL:
+          return cmap.glyph_id_start + static_cast<const uint8_t*>(cmap.glyph_id_ofs_list)[rcp];
+        case LV_FONT_FMT_TXT_CMAP_SPARSE_TINY:
+        case LV_FONT_FMT_TXT_CMAP_SPARSE_FULL: {
+          const uint16_t* end = cmap.unicode_list + cmap.list_length;
+          const uint16_t* found = std::lower_bound(cmap.unicode_list, end, rcp);
+          if (found == end || *found != rcp) {
+            return 0;
+          }
+          auto index = static_cast<uint32_t>(found - cmap.unicode_list);
+          if (cmap.type == LV_FONT_FMT_TXT_CMAP_SPARSE_TINY) {
+            return cmap.glyph_id_start + index;
+          }
+          return cmap.glyph_id_start + static_cast<const uint16_t*>(cmap.glyph_id_ofs_list)[index];
+        }
+      }
+      return 0;
+    }
+    return 0;
+  }
+
+  size_t BitmapSize(const lv_font_fmt_txt_dsc_t* fdsc, const lv_font_fmt_txt_glyph_dsc_t& glyph) {
+    return (glyph.box_w * glyph.box_h * fdsc->bpp + 7) / 8;
+  }
+
+  CachedFont* Find(const lv_font_t* font) {
+    auto it = std::find_if(fonts.begin(), fonts.end(), [font](const CachedFont& cached) {
+      return cached.font == font;
+    });
+    return it != fonts.end() ? &*it : nullptr;
+  }
+
+  // Moves the following bitmaps down, so that the free space stays at the end of the buffer
+  void Evict(Entry& entry) {
+    const size_t end = entry.offset + entry.size;
+    std::memmove(buffer + entry.offset, buffer + end, bufferUsed - end);
+    for (auto& other : entries) {
+      if (other.lastUsed != 0 && other.offset > entry.offset) {
+        other.offset -= entry.size;
+      }
+    }
+    bufferUsed -= entry.size;
+    entry = {};
+  }
+
+  // Evicts the least recently used bitmaps until size fits in the buffer and an entry is free
+  Entry* Allocate(size_t size) {
+    if (size > bufferSize) {
+      return nullptr;
+    }
+    while (true) {
+      Entry* lru = nullptr;
+      Entry* unused = nullptr;
+      for (auto& entry : entries) {
+        if (entry.lastUsed == 0) {
+          unused = &entry;
+        } else if (lru == nullptr || entry.lastUsed < lru->lastUsed) {
+          lru = &entry;
+        }
+      }
+      if (unused != nullptr && bufferUsed + size <= bufferSize) {
+        unused->offset = bufferUsed;
+        unused->size = size;
+        bufferUsed += size;
+        return unused;
+      }
+      Evict(*lru);
+    }
+  }
+
+  bool ReadBitmap(CachedFont& cached, uint32_t offset, uint8_t* bitmap, size_t size) {
+    if (cached.fs->FileSeek(&cached.file, offset) < 0 || cached.fs->FileRead(&cached.file, bitmap, size) != static_cast<int>(size)) {
+      return false;
+    }
+    if (cached.bitShift != 0) {
+      // The last bits of the bitmap are in the next byte, which is beyond the end of the file for the last glyph
+      uint8_t next = 0;
+      cached.fs->FileRead(&cached.file, &next, 1);
+      for (size_t i = 0; i < size; i++) {
+        uint8_t following = (i + 1 < size) ? bitmap[i + 1] : next;
+        bitmap[i] = static_cast<uint8_t>((bitmap[i] << cached.bitShift) | (following >> (8 - cached.bitShift)));
+      }
+    }
+    return true;
+  }
+
+  const uint8_t* GetGlyphBitmap(const lv_font_t* font, uint32_t letter) {
+    for (auto& entry : entries) {
+      if (entry.lastUsed != 0 && entry.font == font && entry.letter == letter) {
+        entry.lastUsed = ++useCounter;
+        return buffer + entry.offset;
+      }
+    }
+
+    CachedFont* cached = Find(font);
+    if (cached == nullptr) {
+      return nullptr;
+    }
+    const auto* fdsc = static_cast<const lv_font_fmt_txt_dsc_t*>(font->dsc);
+    uint32_t glyphId = GlyphId(fdsc, letter);
+    if (glyphId == 0) {
+      return nullptr;
+    }
+    const auto& glyph = fdsc->glyph_dsc[glyphId];
+    size_t size = BitmapSize(fdsc, glyph);
+    if (size == 0) {
+      return nullptr;
+    }
+
+    // The bitmap returned previously isn't used anymore, LVGL draws a glyph before getting the next one: it can be evicted
+    // or moved
+    Entry* entry = Allocate(size);
+    if (entry == nullptr) {
+      return nullptr;
+    }
+    if (!ReadBitmap(*cached, glyph.bitmap_index, buffer + entry->offset, size)) {
+      Evict(*entry);
+      return nullptr;
+    }
+    entry->font = font;
+    entry->letter = letter;
+    entry->lastUsed = ++useCounter;
+    return buffer + entry->offset;
+  }
+
+  bool ReadAt(Pinetime::Controllers::FS& fs, lfs_file_t& file, uint32_t offset, void* data, size_t size) {
+    return fs.FileSeek(&file, offset) >= 0 && fs.FileRead(&file, static_cast<uint8_t*>(data), size) == static_cast<int>(size);
+  }
+
+  // Returns the offset of the label of the section, searched from offset
+  bool FindSection(Pinetime::Controllers::FS& fs, lfs_file_t& file, uint32_t offset, const char* name, SectionLabel& label, uint32_t& found) {
+    while (ReadAt(fs, file, offset, &label, sizeof(label)) && label.length >= sizeof(label)) {
+      if (std::memcmp(label.name, name, sizeof(label.name)) == 0) {
+        found = offset;
+        return true;
+      }
+      offset += label.length;
+    }
+    return false;
+  }
+
+  // Replaces the index of every bitmap in the RAM of the font by its offset in the file.
+  // Returns false if the font can't be read, in which case the font is left half converted and must be freed.
+  bool IndexBitmapsInFile(Pinetime::Controllers::FS& fs, lfs_file_t& file, lv_font_t* font, uint8_t& bitShift) {
+    auto* fdsc = static_cast<lv_font_fmt_txt_dsc_t*>(font->dsc);
+    SectionLabel label;
+    FontHeader header;
+    uint32_t locaOffset;
+    uint32_t glyfOffset;
+    uint32_t locaCount;
+    if (!ReadAt(fs, file, 0, &label, sizeof(label)) || std::memcmp(label.name, "head", 4) != 0 ||
+        !ReadAt(fs, file, sizeof(label), &header, sizeof(header)) || !FindSection(fs, file, label.length, "loca", label, locaOffset) ||
+        !ReadAt(fs, file, locaOffset + sizeof(label), &locaCount, sizeof(locaCount)) ||
+        !FindSection(fs, file, locaOffset + label.length, "glyf", label, glyfOffset)) {
+      return false;
+    }
+
+    // The offsets must fit in bitmap_index (20 bits)
+    lv_font_fmt_txt_glyph_dsc_t probe {};
+    probe.bitmap_index = glyfOffset + label.length;
+    if (probe.bitmap_index != glyfOffset + label.length) {
+      return false;
+    }
+
+    const uint32_t nbits = header.advanceWidthBits + 2 * header.xyBits + 2 * header.whBits;
+    const size_t entrySize = header.indexToLocFormat == 0 ? sizeof(uint16_t) : sizeof(uint32_t);
+    // Allocated by lv_font_load(), const for the fonts compiled in the firmware only
+    auto* glyphs = const_cast<lv_font_fmt_txt_glyph_dsc_t*>(fdsc->glyph_dsc);
+    bitShift = static_cast<uint8_t>(nbits % 8);
+
+    // Glyph 0 has no bitmap
+    std::array<uint8_t, 64> chunk;
+    const uint32_t perChunk = chunk.size() / entrySize;
+    for (uint32_t first = 1; first < locaCount; first += perChunk) {
+      const uint32_t count = std::min(perChunk, locaCount - first);
+      if (!ReadAt(fs, file, locaOffset + sizeof(label) + sizeof(locaCount) + first * entrySize, chunk.data(), count * entrySize)) {
+        return false;
+      }
+      for (uint32_t i = 0; i < count; i++) {
+        uint32_t glyphOffset;
+        if (entrySize == sizeof(uint16_t)) {
+          uint16_t value;
+          std::memcpy(&value, &chunk[i * entrySize], sizeof(value));
+          glyphOffset = value;
+        } else {
+          std::memcpy(&glyphOffset, &chunk[i * entrySize], sizeof(glyphOffset));
+        }
+        glyphs[first + i].bitmap_index = glyfOffset + glyphOffset + nbits / 8;
+      }
+    }
+    return true;
+  }
+}
+
+lv_font_t* GlyphCache::Load(Controllers::FS& fs, const char* path) {
+  // littlefs links the open files together: the handle kept for the lifetime of the font is opened in place
+  CachedFont* cached = Find(nullptr);
+  lfs_file_t uncachedFile = {};
+  lfs_file_t& file = cached != nullptr ? cached->file : uncachedFile;
+
+  // LVGL crashes when the font doesn't exist
+  if (fs.FileOpen(&file, path, LFS_O_RDONLY) < 0) {
+    file = {};
+    return nullptr;
+  }
+
+  std::array<char, maxPathLength> lvglPath;
+  int length = snprintf(lvglPath.data(), lvglPath.size(), "F:%s", path);
+  lv_font_t* font = nullptr;
+  if (length >= 0 && static_cast<size_t>(length) < lvglPath.size()) {
+    font = lv_font_load(lvglPath.data());
+  }
+
+  // The font keeps its bitmaps in RAM if it can't be cached
+  auto* fdsc = font != nullptr ? static_cast<lv_font_fmt_txt_dsc_t*>(font->dsc) : nullptr;
+  if (cached == nullptr || fdsc == nullptr || fdsc->bitmap_format != LV_FONT_FMT_TXT_PLAIN || fdsc->glyph_bitmap == nullptr) {
+    fs.FileClose(&file);
+    file = {};
+    return font;
+  }
+  if (buffer == nullptr) {
+    buffer = static_cast<uint8_t*>(pvPortMalloc(bufferSize));
+    if (buffer == nullptr) {
+      fs.FileClose(&file);
+      file = {};
+      return font;
+    }
+  }
+
+  uint8_t bitShift = 0;
+  if (!IndexBitmapsInFile(fs, file, font, bitShift)) {
+    fs.FileClose(&file);
+    *cached = {};
+    lv_font_free(font);
+    return nullptr;
+  }
+
+  // lv_font_free() ignores the null pointer
+  lv_mem_free(fdsc->glyph_bitmap);
+  fdsc->glyph_bitmap = nullptr;
+  font->get_glyph_bitmap = GetGlyphBitmap;
+  cached->font = font;
+  cached->fs = &fs;
+  cached->bitShift = bitShift;
+  return font;
+}
+
+void GlyphCache::Free(lv_font_t* font) {
+  if (font == nullptr) {
+    return;
+  }
+  CachedFont* cached = Find(font);
+  if (cached != nullptr) {
+    for (auto& entry : entries) {
+      if (entry.lastUsed != 0 && entry.font == font) {
+        Evict(entry);
+      }
+    }
+    cached->fs->FileClose(&cached->file);
+    *cached = {};
+    if (std::none_of(fonts.begin(), fonts.end(), [](const CachedFont& other) {
+          return other.font != nullptr;
+        })) {
+      vPortFree(buffer);
+      buffer = nullptr;
+    }
+  }
+  lv_font_free(font);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <lvgl/lvgl.h>
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+  }
+
+  namespace Components {
+    // Loads the bin fonts of the external resources without keeping their glyph bitmaps in RAM.
+    // lv_font_load() reads the whole font in RAM, bitmaps included. The bitmaps are freed, the index of each of them is
+    // replaced by its offset in the glyf section of the font file, and the bitmaps LVGL draws are read in place through a
+    // file handle kept open with the font. They are kept in a LRU cache keyed by (font, letter), in a 4KB buffer of the
+    // FreeRTOS heap shared by all the fonts and allocated while at least one of them is loaded.
+    // Fonts that can't be cached (compressed bitmaps, file system errors,...) keep their bitmaps in RAM.
+    class GlyphCache {
+    public:
+      // Returns nullptr if path doesn't exist. The path is the path in the file system, without the LVGL drive letter.
+      static lv_font_t* Load(Controllers::FS& fs, const char* path);
+      // Frees a font returned by Load() and the bitmaps cached for it
+      static void Free(lv_font_t* font);
+    };
+  }
+}
@@ -1,10 +1,15 @@
 #include "displayapp/LittleVgl.h"
 #include "displayapp/InfiniTimeTheme.h"
+#include "displayapp/Clut8ImageDecoder.h"
 
+#include <algorithm>
+#include <array>
+#include <new>
 #include <FreeRTOS.h>
 #include <task.h>
 #include "drivers/St7789.h"
 #include "littlefs/lfs.h"
+#include "components/fs/CompressedFile.h"
 #include "components/fs/FS.h"
 
 using namespace Pinetime::Components;
@@ -16,41 +21,85 @@ namespace {
   }
 
   lv_fs_res_t lvglOpen(lv_fs_drv_t* drv, void* file_p, const char* path, lv_fs_mode_t /*mode*/) {
-    lfs_file_t* file = static_cast<lfs_file_t*>(file_p);
+    auto* file = new (file_p) Pinetime::Controllers::CompressedFile;
     Pinetime::Controllers::FS* filesys = static_cast<Pinetime::Controllers::FS*>(drv->user_data);
-    int res = filesys->FileOpen(file, path, LFS_O_RDONLY);
-    if (res == 0) {
-      if (file->type == 0) {
-        return LV_FS_RES_FS_ERR;
-      } else {
-        return LV_FS_RES_OK;
-      }
+    int res = file->Open(*filesys, path);
+    if (res == LFS_ERR_OK) {
+      return LV_FS_RES_OK;
+    }
+    if (res == LFS_ERR_ISDIR) {
+      return LV_FS_RES_FS_ERR;
+    }
+    if (res == LFS_ERR_NOMEM) {
+      return LV_FS_RES_OUT_OF_MEM;
     }
     return LV_FS_RES_NOT_EX;
   }
 
-  lv_fs_res_t lvglClose(lv_fs_drv_t* drv, void* file_p) {
-    Pinetime::Controllers::FS* filesys = static_cast<Pinetime::Controllers::FS*>(drv->user_data);
-    lfs_file_t* file = static_cast<lfs_file_t*>(file_p);
-    filesys->FileClose(file);
-
+  lv_fs_res_t lvglClose(lv_fs_drv_t* /*drv*/, void* file_p) {
+    auto* file = static_cast<Pinetime::Controllers::CompressedFile*>(file_p);
+    file->Close();
+    file->~CompressedFile();
     return LV_FS_RES_OK;
   }
 
-  lv_fs_res_t lvglRead(lv_fs_drv_t* drv, void* file_p, void* buf, uint32_t btr, uint32_t* br) {
-    Pinetime::Controllers::FS* filesys = static_cast<Pinetime::Controllers::FS*>(drv->user_data);
-    lfs_file_t* file = static_cast<lfs_file_t*>(file_p);
-    filesys->FileRead(file, static_cast<uint8_t*>(buf), btr);
-    *br = btr;
+  lv_fs_res_t lvglRead(lv_fs_drv_t* /*drv*/, void* file_p, void* buf, uint32_t btr, uint32_t* br) {
+    auto* file = static_cast<Pinetime::Controllers::CompressedFile*>(file_p);
+    int res = file->Read(static_cast<uint8_t*>(buf), btr);
+    if (res < 0) {
+      *br = 0;
+      return LV_FS_RES_FS_ERR;
+    }
+    *br = static_cast<uint32_t>(res);
     return LV_FS_RES_OK;
   }
 
-  lv_fs_res_t lvglSeek(lv_fs_drv_t* drv, void* file_p, uint32_t pos) {
-    Pinetime::Controllers::FS* filesys = static_cast<Pinetime::Controllers::FS*>(drv->user_data);
-    lfs_file_t* file = static_cast<lfs_file_t*>(file_p);
-    filesys->FileSeek(file, pos);
+  lv_fs_res_t lvglSeek(lv_fs_drv_t* /*drv*/, void* file_p, uint32_t pos) {
+    auto* file = static_cast<Pinetime::Controllers::CompressedFile*>(file_p);
+    if (file->Seek(pos) < 0) {
+      return LV_FS_RES_FS_ERR;
+    }
     return LV_FS_RES_OK;
   }
+
+  // FNV-1a, two pixels at a time
+  uint32_t Checksum(const lv_color_t* pixels, uint32_t nbPixels) {
+    constexpr uint32_t prime = 16777619U;
+    uint32_t hash = 2166136261U;
+    uint32_t idx = 0;
+    for (; idx + 1 < nbPixels; idx += 2) {
+      hash = (hash ^ (pixels[idx].full | (static_cast<uint32_t>(pixels[idx + 1].full) << 16))) * prime;
+    }
+    if (idx < nbPixels) {
+      hash = (hash ^ pixels[idx].full) * prime;
+    }
+    return hash;
+  }
+
+  bool IsSameArea(const lv_area_t& a, const lv_area_t& b) {
+    return a.x1 == b.x1 && a.y1 == b.y1 && a.x2 == b.x2 && a.y2 == b.y2;
+  }
+
+  bool AreOverlapping(const lv_area_t& a, const lv_area_t& b) {
+    return a.x1 <= b.x2 && b.x1 <= a.x2 && a.y1 <= b.y2 && b.y1 <= a.y2;
+  }
+
+#if LV_COLOR_DEPTH == 8
+  // RGB332, as rendered by LVGL, to RGB565 with the bytes swapped as the display expects them
+  constexpr std::array<uint16_t, 256> MakeRgb565Table() {
+    std::array<uint16_t, 256> table {};
+    for (uint16_t color = 0; color < table.size(); color++) {
+      uint16_t red = (color >> 5) & 0x07;
+      uint16_t green = (color >> 2) & 0x07;
+      uint16_t blue = color & 0x03;
+      uint16_t rgb565 = ((red * 31 / 7) << 11) | ((green * 63 / 7) << 5) | (blue * 31 / 3);
+      table[color] = static_cast<uint16_t>((rgb565 >> 8) | (rgb565 << 8));
+    }
+    return table;
+  }
+
+  constexpr std::array<uint16_t, 256> rgb565Table = MakeRgb565Table();
+#endif
 }
 
 static void disp_flush(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_t* color_p) {
@@ -58,6 +107,23 @@ static void disp_flush(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_
   lvgl->FlushDisplay(area, color_p);
 }
 
+static void flush_complete(void* context) {
+  auto* lvgl = static_cast<LittleVgl*>(context);
+  lvgl->OnFlushComplete();
+}
+
+#if LV_COLOR_DEPTH == 8
+static const uint8_t* expand_pixels(void* context, size_t size) {
+  auto* stream = static_cast<LittleVgl::PixelStream*>(context);
+  return stream->lvgl->ExpandPixels(stream->pixels, size);
+}
+#endif
+
+static void wait_flush(lv_disp_drv_t* disp_drv) {
+  auto* lvgl = static_cast<LittleVgl*>(disp_drv->user_data);
+  lvgl->WaitForFlush();
+}
+
 static void rounder(lv_disp_drv_t* disp_drv, lv_area_t* area) {
   auto* lvgl = static_cast<LittleVgl*>(disp_drv->user_data);
   if (lvgl->GetFullRefresh()) {
@@ -66,6 +132,7 @@ static void rounder(lv_disp_drv_t* disp_drv, lv_area_t* area) {
     area->y1 = 0;
     area->y2 = LV_VER_RES - 1;
   }
+  lvgl->RoundToRowWindow(area);
 }
 
 bool touchpad_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
@@ -73,7 +140,10 @@ bool touchpad_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
   return lvgl->GetTouchPadInfo(data);
 }
 
-LittleVgl::LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::FS& filesystem) : lcd {lcd}, filesystem {filesystem} {
+LittleVgl::LittleVgl(Pinetime::Drivers::St7789& lcd,
+                     Pinetime::Controllers::FS& filesystem,
+                     Pinetime::Controllers::FrameProfiler& frameProfiler)
+  : lcd {lcd}, filesystem {filesystem}, frameProfiler {frameProfiler} {
 }
 
 void LittleVgl::Init() {
@@ -82,11 +152,16 @@ void LittleVgl::Init() {
   InitDisplay();
   InitTouchpad();
   InitFileSystem();
+  Clut8ImageDecoder::Register();
 }
 
 void LittleVgl::InitDisplay() {
-  lv_disp_buf_init(&disp_buf_2, buf2_1, buf2_2, LV_HOR_RES_MAX * 4); /*Initialize the display buffer*/
-  lv_disp_drv_init(&disp_drv);                                       /*Basic initialization*/
+  if (flushDone == nullptr) {
+    flushDone = xSemaphoreCreateBinary();
+  }
+
+  lv_disp_buf_init(&disp_buf_2, buf2_1, buf2_2, LV_HOR_RES_MAX * nbWriteLines); /*Initialize the display buffer*/
+  lv_disp_drv_init(&disp_drv);                                                  /*Basic initialization*/
 
   /*Set up the functions to access to your display*/
 
@@ -96,6 +171,8 @@ void LittleVgl::InitDisplay() {
 
   /*Used to copy the buffer's content to the display*/
   disp_drv.flush_cb = disp_flush;
+  /*Called by LVGL while it waits for the previous strip to be sent*/
+  disp_drv.wait_cb = wait_flush;
   /*Set a display buffer*/
   disp_drv.buffer = &disp_buf_2;
   disp_drv.user_data = this;
@@ -119,7 +196,7 @@ void LittleVgl::InitFileSystem() {
   lv_fs_drv_t fs_drv;
   lv_fs_drv_init(&fs_drv);
 
-  fs_drv.file_size = sizeof(lfs_file_t);
+  fs_drv.file_size = sizeof(Pinetime::Controllers::CompressedFile);
   fs_drv.letter = 'F';
   fs_drv.open_cb = lvglOpen;
   fs_drv.close_cb = lvglClose;
@@ -153,9 +230,57 @@ bool LittleVgl::IsScrolling() {
   return scrollDirection != LittleVgl::FullRefreshDirections::None;
 }
 
+void LittleVgl::SetAlwaysOnMode(bool enabled) {
+  alwaysOnMode = enabled;
+  nbFlushedWindows = 0;
+}
+
+void LittleVgl::RoundToRowWindow(lv_area_t* area) const {
+  // LVGL also rounds the height of the strips it renders, so an area invalidated again is sent in the same windows
+  if (alwaysOnMode) {
+    area->y1 -= area->y1 % nbWriteLines;
+    area->y2 += nbWriteLines - 1 - area->y2 % nbWriteLines;
+  }
+}
+
+// Returns true if the display already shows these pixels in this window, records the window otherwise
+bool LittleVgl::IsWindowUnchanged(const lv_area_t* area, const lv_color_t* color_p) {
+  if (scrollDirection != FullRefreshDirections::None) {
+    // The content of the display moves while scrolling
+    nbFlushedWindows = 0;
+    return false;
+  }
+
+  uint32_t checksum = Checksum(color_p, lv_area_get_size(area));
+  size_t idx = 0;
+  while (idx < nbFlushedWindows) {
+    auto& window = flushedWindows[idx];
+    if (IsSameArea(window.area, *area)) {
+      bool isUnchanged = window.checksum == checksum;
+      window.checksum = checksum;
+      return isUnchanged;
+    }
+    if (AreOverlapping(window.area, *area)) {
+      // Partly overwritten, what the display shows there is not known anymore
+      window = flushedWindows[--nbFlushedWindows];
+    } else {
+      idx++;
+    }
+  }
+  if (nbFlushedWindows < maxFlushedWindows) {
+    flushedWindows[nbFlushedWindows++] = {*area, checksum};
+  }
+  return false;
+}
+
 void LittleVgl::FlushDisplay(const lv_area_t* area, lv_color_t* color_p) {
   uint16_t y1, y2, width, height = 0;
 
+  if (alwaysOnMode && IsWindowUnchanged(area, color_p)) {
+    lv_disp_flush_ready(&disp_drv);
+    return;
+  }
+
   if ((scrollDirection == LittleVgl::FullRefreshDirections::Down) && (area->y2 == visibleNbLines - 1)) {
     writeOffset = ((writeOffset + totalNbLines) - visibleNbLines) % totalNbLines;
   } else if ((scrollDirection == FullRefreshDirections::Up) && (area->y1 == 0)) {
@@ -167,6 +292,7 @@ void LittleVgl::FlushDisplay(const lv_area_t* area, lv_color_t* color_p) {
 
   width = (area->x2 - area->x1) + 1;
   height = (area->y2 - area->y1) + 1;
+  frameProfiler.OnFlushStart(width * height);
 
   if (scrollDirection == LittleVgl::FullRefreshDirections::Down) {
 
@@ -214,24 +340,74 @@ void LittleVgl::FlushDisplay(const lv_area_t* area, lv_color_t* color_p) {
     }
   }
 
+  // The SPI transfers are serialized, so LVGL is informed that the flushing is done
+  // (and that it can reuse this buffer) when the last transfer of the strip completes.
   if (y2 < y1) {
     height = totalNbLines - y1;
 
     if (height > 0) {
-      lcd.DrawBuffer(area->x1, y1, width, height, reinterpret_cast<const uint8_t*>(color_p), width * height * 2);
+      DrawPixels(area->x1, y1, width, height, color_p, false);
     }
 
     uint16_t pixOffset = width * height;
     height = y2 + 1;
-    lcd.DrawBuffer(area->x1, 0, width, height, reinterpret_cast<const uint8_t*>(color_p + pixOffset), width * height * 2);
+    DrawPixels(area->x1, 0, width, height, color_p + pixOffset, true);
 
   } else {
-    lcd.DrawBuffer(area->x1, y1, width, height, reinterpret_cast<const uint8_t*>(color_p), width * height * 2);
+    DrawPixels(area->x1, y1, width, height, color_p, true);
+  }
+}
+
+// flush_complete is called once the last transfer of the strip is done
+void LittleVgl::DrawPixels(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const lv_color_t* pixels, bool isLast) {
+#if LV_COLOR_DEPTH == 8
+  // The pixels are expanded while the strip is sent, this returns as soon as the transfer is started
+  auto& stream = pixelStreams[pixelStreamIndex];
+  pixelStreamIndex ^= 1;
+  stream = {this, pixels};
+  lcd.DrawStream(x, y, width, height, width * height * 2, expand_pixels, &stream, isLast ? flush_complete : nullptr, this);
+#else
+  lcd.DrawBuffer(x,
+                 y,
+                 width,
+                 height,
+                 reinterpret_cast<const uint8_t*>(pixels),
+                 width * height * 2,
+                 isLast ? flush_complete : nullptr,
+                 this);
+#endif
+}
+
+#if LV_COLOR_DEPTH == 8
+// Called from the SPI interrupt. The transfers are serialized: the buffer returned two calls ago has been sent.
+const uint8_t* LittleVgl::ExpandPixels(const lv_color_t*& pixels, size_t size) {
+  auto& buffer = expandBuffers[expandBufferIndex];
+  expandBufferIndex ^= 1;
+  size_t nbPixels = size / 2;
+  for (size_t idx = 0; idx < nbPixels; idx++) {
+    buffer[idx] = rgb565Table[pixels[idx].full];
   }
+  pixels += nbPixels;
+  return reinterpret_cast<const uint8_t*>(buffer.data());
+}
+#endif
+
+// Called from the SPI interrupt
+void LittleVgl::OnFlushComplete() {
+  frameProfiler.OnFlushEnd();
 
   // IMPORTANT!!!
   // Inform the graphics library that you are ready with the flushing
   lv_disp_flush_ready(&disp_drv);
+
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  xSemaphoreGiveFromISR(flushDone, &xHigherPriorityTaskWoken);
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+void LittleVgl::WaitForFlush() {
+  // LVGL checks its flushing flag again when this returns, so a stale give only costs one extra loop
+  xSemaphoreTake(flushDone, pdMS_TO_TICKS(10));
 }
 
 void LittleVgl::SetNewTouchPoint(int16_t x, int16_t y, bool contact) {
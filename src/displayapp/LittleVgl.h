@@ -1,7 +1,17 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <FreeRTOS.h>
+#include <semphr.h>
 #include <lvgl/lvgl.h>
 #include <components/fs/FS.h>
+#include "components/profiling/FrameProfiler.h"
+#include "drivers/SpiMaster.h"
+
+#ifndef LVGL_DRAW_BUFFER_LINES
+  #define LVGL_DRAW_BUFFER_LINES 4
+#endif
 
 namespace Pinetime {
   namespace Drivers {
@@ -12,7 +22,7 @@ namespace Pinetime {
     class LittleVgl {
     public:
       enum class FullRefreshDirections { None, Up, Down, Left, Right, LeftAnim, RightAnim };
-      LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::FS& filesystem);
+      LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::FS& filesystem, Pinetime::Controllers::FrameProfiler& frameProfiler);
 
       LittleVgl(const LittleVgl&) = delete;
       LittleVgl& operator=(const LittleVgl&) = delete;
@@ -22,12 +32,27 @@ namespace Pinetime {
       void Init();
 
       void FlushDisplay(const lv_area_t* area, lv_color_t* color_p);
+      void OnFlushComplete();
+#if LV_COLOR_DEPTH == 8
+      // Pixels of a strip still to be expanded to RGB565 while it is sent to the display
+      struct PixelStream {
+        LittleVgl* lvgl;
+        const lv_color_t* pixels;
+      };
+
+      const uint8_t* ExpandPixels(const lv_color_t*& pixels, size_t size);
+#endif
+      void WaitForFlush();
       bool GetTouchPadInfo(lv_indev_data_t* ptr);
       void SetFullRefresh(FullRefreshDirections direction);
       void SetNewTouchPoint(int16_t x, int16_t y, bool contact);
       void CancelTap();
       void ClearTouchState();
       bool IsScrolling();
+      // In always on mode, areas are extended to whole strips of rows and the strips the display already shows
+      // are not sent again
+      void SetAlwaysOnMode(bool enabled);
+      void RoundToRowWindow(lv_area_t* area) const;
 
       bool GetFullRefresh() {
         bool returnValue = fullRefresh;
@@ -37,22 +62,43 @@ namespace Pinetime {
         return returnValue;
       }
 
+      // Unlike GetFullRefresh(), leaves the request to the rounder
+      bool IsFullRefreshPending() const {
+        return fullRefresh;
+      }
+
     private:
       void InitDisplay();
       void InitTouchpad();
       void InitFileSystem();
+      bool IsWindowUnchanged(const lv_area_t* area, const lv_color_t* color_p);
+      void DrawPixels(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const lv_color_t* pixels, bool isLast);
 
       Pinetime::Drivers::St7789& lcd;
       Pinetime::Controllers::FS& filesystem;
+      Pinetime::Controllers::FrameProfiler& frameProfiler;
 
+      static constexpr uint8_t nbWriteLines = LVGL_DRAW_BUFFER_LINES;
+      static_assert(LV_VER_RES_MAX % nbWriteLines == 0, "LVGL_DRAW_BUFFER_LINES must divide the screen height");
+      static_assert(LV_COLOR_DEPTH == 8 || LV_COLOR_DEPTH == 16, "LVGL_COLOR_DEPTH must be 8 or 16");
+
+      // LVGL renders a strip in one buffer while the other one is being sent to the display
       lv_disp_buf_t disp_buf_2;
-      lv_color_t buf2_1[LV_HOR_RES_MAX * 4];
-      lv_color_t buf2_2[LV_HOR_RES_MAX * 4];
+      lv_color_t buf2_1[LV_HOR_RES_MAX * nbWriteLines];
+      lv_color_t buf2_2[LV_HOR_RES_MAX * nbWriteLines];
+#if LV_COLOR_DEPTH == 8
+      // One per transfer of a strip, which is split in two when it wraps around the display RAM
+      std::array<PixelStream, 2> pixelStreams;
+      uint8_t pixelStreamIndex = 0;
+      // The 8 bit pixels are expanded from the SPI interrupt, in one buffer while the other one is being sent
+      std::array<uint16_t, Drivers::SpiMaster::StreamChunkSize / 2> expandBuffers[2];
+      uint8_t expandBufferIndex = 0;
+#endif
+      SemaphoreHandle_t flushDone = nullptr;
 
       lv_disp_drv_t disp_drv;
 
       bool fullRefresh = false;
-      static constexpr uint8_t nbWriteLines = 4;
       static constexpr uint16_t totalNbLines = 320;
       static constexpr uint16_t visibleNbLines = 240;
 
@@ -64,6 +110,17 @@ namespace Pinetime {
       uint16_t writeOffset = 0;
       uint16_t scrollOffset = 0;
 
+      struct FlushedWindow {
+        lv_area_t area;
+        uint32_t checksum;
+      };
+
+      // Windows sent to the display in always on mode, they never overlap each other
+      static constexpr size_t maxFlushedWindows = 32;
+      std::array<FlushedWindow, maxFlushedWindows> flushedWindows;
+      size_t nbFlushedWindows = 0;
+      bool alwaysOnMode = false;
+
       lv_point_t touchPoint = {};
       bool tapped = false;
       bool isCancelled = false;
@@ -0,0 +1,198 @@
+#include "displayapp/LvglArena.h"
+#include <algorithm>
+#include <array>
+#include <FreeRTOS.h>
+#include <task.h>
+
+using namespace Pinetime::Components;
+
+#ifndef LVGL_ARENA_SIZE
+  #define LVGL_ARENA_SIZE 0
+#endif
+
+namespace {
+  constexpr size_t pageSize = 128;
+  constexpr size_t nbPages = LVGL_ARENA_SIZE / pageSize;
+
+  // Blocks up to 192 bytes are served from slabs of 1 or 3 pages split in slots of a fixed size, so that at most a third
+  // of a small block is wasted. An object (lv_obj_t and the header of lv_mem) takes a 64 bytes slot, styles and small
+  // buffers the smaller ones. Larger blocks are rounded up to whole pages.
+  struct SlotClass {
+    uint16_t size;
+    uint8_t nbPages;
+  };
+
+  constexpr std::array<SlotClass, 6> slotClasses {{{16, 1}, {32, 1}, {48, 3}, {64, 1}, {96, 3}, {192, 3}}};
+  static_assert(LVGL_ARENA_SIZE % pageSize == 0, "LVGL_ARENA_SIZE must be a multiple of 128");
+  static_assert(std::all_of(slotClasses.begin(), slotClasses.end(), [](const SlotClass& slotClass) {
+                  return slotClass.nbPages * pageSize % slotClass.size == 0 && slotClass.nbPages * pageSize / slotClass.size <= 8;
+                }),
+                "The slots must fill the slab and fit in the bitmap");
+
+  enum class PageType : uint8_t { Free, Slots, Run, Continuation };
+
+  struct Page {
+    PageType type;
+    uint8_t slotClass;
+    uint8_t usedSlots; // Bitmap
+    // Slots and Run: number of pages of the slab or of the run. Continuation: distance to the first page.
+    uint16_t length;
+  };
+
+  alignas(8) std::array<uint8_t, nbPages * pageSize> arena;
+  std::array<Page, nbPages> pages;
+  LvglArena::Stats stats {LVGL_ARENA_SIZE, 0, 0, 0, 0, 0};
+
+  void OnAllocated(size_t size) {
+    stats.used += size;
+    stats.peak = std::max(stats.peak, stats.used);
+    stats.screenPeak = std::max(stats.screenPeak, stats.used);
+  }
+
+  // Marks length free pages as a new slab or run and returns the index of the first one, or nbPages if there is no room.
+  // Slabs are taken from the end of the arena, to keep the beginning for the runs.
+  size_t Reserve(size_t length, PageType type, uint8_t slotClass) {
+    size_t count = 0;
+    size_t first = nbPages;
+    for (size_t i = 0; i < nbPages; i++) {
+      const size_t index = (type == PageType::Slots) ? nbPages - 1 - i : i;
+      count = (pages[index].type == PageType::Free) ? count + 1 : 0;
+      if (count == length) {
+        first = (type == PageType::Slots) ? index : index + 1 - length;
+        break;
+      }
+    }
+    if (first == nbPages) {
+      return nbPages;
+    }
+    pages[first] = {type, slotClass, 0, static_cast<uint16_t>(length)};
+    for (size_t page = 1; page < length; page++) {
+      pages[first + page] = {PageType::Continuation, 0, 0, static_cast<uint16_t>(page)};
+    }
+    return first;
+  }
+
+  void* AllocateSlot(uint8_t slotClass) {
+    const auto& sizeClass = slotClasses[slotClass];
+    const auto allSlots = static_cast<uint8_t>((1U << (sizeClass.nbPages * pageSize / sizeClass.size)) - 1);
+    size_t index = nbPages;
+    for (size_t i = nbPages; i-- > 0;) {
+      const auto& page = pages[i];
+      if (page.type == PageType::Slots && page.slotClass == slotClass && page.usedSlots != allSlots) {
+        index = i;
+        break;
+      }
+    }
+    if (index == nbPages) {
+      index = Reserve(sizeClass.nbPages, PageType::Slots, slotClass);
+      if (index == nbPages) {
+        return nullptr;
+      }
+    }
+    auto& page = pages[index];
+    size_t slot = 0;
+    while ((page.usedSlots & (1U << slot)) != 0) {
+      slot++;
+    }
+    page.usedSlots |= static_cast<uint8_t>(1U << slot);
+    OnAllocated(sizeClass.size);
+    return &arena[index * pageSize + slot * sizeClass.size];
+  }
+
+  void* AllocateRun(size_t length) {
+    // First fit
+    size_t index = Reserve(length, PageType::Run, 0);
+    if (index == nbPages) {
+      return nullptr;
+    }
+    OnAllocated(length * pageSize);
+    return &arena[index * pageSize];
+  }
+
+  void* Allocate(size_t size) {
+    if (size == 0) {
+      return nullptr;
+    }
+    for (uint8_t slotClass = 0; slotClass < slotClasses.size(); slotClass++) {
+      if (size <= slotClasses[slotClass].size) {
+        return AllocateSlot(slotClass);
+      }
+    }
+    return AllocateRun((size + pageSize - 1) / pageSize);
+  }
+
+  bool IsInArena(const void* ptr) {
+    const auto* byte = static_cast<const uint8_t*>(ptr);
+    return byte >= arena.data() && byte < arena.data() + arena.size();
+  }
+
+  void Release(size_t index) {
+    for (size_t last = index + pages[index].length; index < last; index++) {
+      pages[index] = {};
+    }
+  }
+
+  void Free(void* ptr) {
+    size_t offset = static_cast<uint8_t*>(ptr) - arena.data();
+    size_t index = offset / pageSize;
+    if (pages[index].type == PageType::Continuation) {
+      // Slot in the second or third page of a slab
+      index -= pages[index].length;
+    }
+    auto& page = pages[index];
+    if (page.type == PageType::Slots) {
+      const size_t slotSize = slotClasses[page.slotClass].size;
+      page.usedSlots &= static_cast<uint8_t>(~(1U << ((offset - index * pageSize) / slotSize)));
+      stats.used -= slotSize;
+      if (page.usedSlots == 0) {
+        Release(index);
+      }
+    } else if (page.type == PageType::Run) {
+      stats.used -= page.length * pageSize;
+      Release(index);
+    }
+  }
+}
+
+void* lvgl_arena_alloc(size_t size) {
+  vTaskSuspendAll();
+  void* ptr = Allocate(size);
+  if (ptr == nullptr && size > 0) {
+    ptr = pvPortMalloc(size);
+    if (ptr != nullptr) {
+      stats.nbOverflows++;
+      stats.overflowBlocks++;
+    }
+  }
+  xTaskResumeAll();
+  return ptr;
+}
+
+void lvgl_arena_free(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  vTaskSuspendAll();
+  if (IsInArena(ptr)) {
+    Free(ptr);
+  } else {
+    vPortFree(ptr);
+    stats.overflowBlocks--;
+  }
+  xTaskResumeAll();
+}
+
+LvglArena::Stats LvglArena::GetStats() {
+  vTaskSuspendAll();
+  Stats result = stats;
+  xTaskResumeAll();
+  return result;
+}
+
+uint32_t LvglArena::StartScreen() {
+  vTaskSuspendAll();
+  uint32_t peak = stats.screenPeak;
+  stats.screenPeak = stats.used;
+  xTaskResumeAll();
+  return peak;
+}
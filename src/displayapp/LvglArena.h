@@ -0,0 +1,42 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+// Included by lvgl.h through LV_MEM_CUSTOM_INCLUDE, which used to be FreeRTOS.h: the screens rely on it
+#include <FreeRTOS.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Memory functions of LVGL, see LV_MEM_CUSTOM_ALLOC in lv_conf.h
+void* lvgl_arena_alloc(size_t size);
+void lvgl_arena_free(void* ptr);
+
+#ifdef __cplusplus
+}
+
+namespace Pinetime {
+  namespace Components {
+    // RAM dedicated to LVGL (objects, styles, fonts...), so that the screens don't fragment the FreeRTOS heap shared with
+    // the tasks, the timers and NimBLE. The arena is split in pages of 128 bytes: blocks up to 192 bytes are served from
+    // slabs of 1 or 3 pages holding slots of 16 to 192 bytes, allocated from the end of the arena, and larger blocks from
+    // runs of contiguous pages, allocated from the beginning. Allocations that don't fit fall back to the FreeRTOS heap.
+    // The size of the arena is set by LVGL_ARENA_SIZE, 0 sends all the allocations to the FreeRTOS heap.
+    class LvglArena {
+    public:
+      struct Stats {
+        uint32_t size;
+        uint32_t used;           // Bytes of the slots and pages currently allocated
+        uint32_t peak;           // Since boot
+        uint32_t screenPeak;     // Since the last call to StartScreen()
+        uint32_t nbOverflows;    // Allocations sent to the FreeRTOS heap since boot
+        uint32_t overflowBlocks; // Blocks currently allocated in the FreeRTOS heap
+      };
+
+      static Stats GetStats();
+      // Called when a screen is deleted, returns the peak usage since the previous call
+      static uint32_t StartScreen();
+    };
+  }
+}
+#endif
@@ -24,6 +24,8 @@ namespace Pinetime {
         AlarmTriggered,
         Chime,
         BleRadioEnableToggle,
+        // Values shown by the current screen have changed, see ChangeNotifier
+        ValuesChanged,
       };
     }
   }
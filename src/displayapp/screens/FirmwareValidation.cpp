@@ -5,6 +5,7 @@
 #include "displayapp/DisplayApp.h"
 #include "displayapp/InfiniTimeTheme.h"
 #include "displayapp/screens/Symbols.h"
+#include "systemtask/SystemTask.h"
 
 using namespace Pinetime::Applications::Screens;
 
@@ -15,7 +16,8 @@ namespace {
   }
 }
 
-FirmwareValidation::FirmwareValidation(Pinetime::Controllers::FirmwareValidator& validator) : validator {validator} {
+FirmwareValidation::FirmwareValidation(Pinetime::Controllers::FirmwareValidator& validator, System::SystemTask& systemTask)
+  : validator {validator}, systemTask {systemTask} {
   lv_obj_t* title = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_text_static(title, "Firmware");
   lv_label_set_align(title, LV_LABEL_ALIGN_CENTER);
@@ -82,6 +84,8 @@ void FirmwareValidation::OnButtonEvent(lv_obj_t* object, lv_event_t event) {
     validator.Validate();
     running = false;
   } else if (object == buttonReset && event == LV_EVENT_CLICKED) {
+    // The settings changed just before would otherwise be lost
+    systemTask.WaitForSaves(pdMS_TO_TICKS(1000));
     validator.Reset();
   }
 }
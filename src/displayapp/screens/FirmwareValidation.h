@@ -8,18 +8,23 @@ namespace Pinetime {
     class FirmwareValidator;
   }
 
+  namespace System {
+    class SystemTask;
+  }
+
   namespace Applications {
     namespace Screens {
 
       class FirmwareValidation : public Screen {
       public:
-        FirmwareValidation(Pinetime::Controllers::FirmwareValidator& validator);
+        FirmwareValidation(Pinetime::Controllers::FirmwareValidator& validator, System::SystemTask& systemTask);
         ~FirmwareValidation() override;
 
         void OnButtonEvent(lv_obj_t* object, lv_event_t event);
 
       private:
         Pinetime::Controllers::FirmwareValidator& validator;
+        System::SystemTask& systemTask;
 
         lv_obj_t* labelVersion;
         lv_obj_t* labelIsValidated;
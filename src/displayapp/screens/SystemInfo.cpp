@@ -4,6 +4,7 @@
 #include "displayapp/screens/SystemInfo.h"
 #include <lvgl/lvgl.h>
 #include "displayapp/DisplayApp.h"
+#include "displayapp/LvglArena.h"
 #include "displayapp/screens/Label.h"
 #include "Version.h"
 #include "BootloaderVersion.h"
@@ -12,7 +13,9 @@
 #include "components/brightness/BrightnessController.h"
 #include "components/datetime/DateTimeController.h"
 #include "components/motion/MotionController.h"
+#include "components/profiling/FrameProfiler.h"
 #include "drivers/Watchdog.h"
+#include "systemtask/SystemMonitor.h"
 #include "displayapp/InfiniTimeTheme.h"
 
 using namespace Pinetime::Applications::Screens;
@@ -39,7 +42,9 @@ SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
                        const Pinetime::Drivers::Watchdog& watchdog,
                        Pinetime::Controllers::MotionController& motionController,
                        const Pinetime::Drivers::Cst816S& touchPanel,
-                       const Pinetime::Drivers::SpiNorFlash& spiNorFlash)
+                       const Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                       const Pinetime::Controllers::FrameProfiler& frameProfiler,
+                       const Pinetime::System::SystemMonitor& systemMonitor)
   : dateTimeController {dateTimeController},
     batteryController {batteryController},
     brightnessController {brightnessController},
@@ -48,6 +53,8 @@ SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
     motionController {motionController},
     touchPanel {touchPanel},
     spiNorFlash {spiNorFlash},
+    frameProfiler {frameProfiler},
+    systemMonitor {systemMonitor},
     screens {app,
              0,
              {[this]() -> std::unique_ptr<Screen> {
@@ -64,6 +71,12 @@ SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
               },
               [this]() -> std::unique_ptr<Screen> {
                 return CreateScreen5();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen6();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen7();
               }},
              Screens::ScreenListModes::UpDown} {
 }
@@ -96,7 +109,7 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen1() {
                         BootloaderVersion::VersionString());
   lv_label_set_align(label, LV_LABEL_ALIGN_CENTER);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(0, 5, label);
+  return std::make_unique<Screens::Label>(0, 7, label);
 }
 
 std::unique_ptr<Screen> SystemInfo::CreateScreen2() {
@@ -175,14 +188,15 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen2() {
                         touchPanel.GetFwVersion(),
                         TARGET_DEVICE_NAME);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(1, 5, label);
+  return std::make_unique<Screens::Label>(1, 7, label);
 }
 
 extern int mallocFailedCount;
 extern int stackOverflowCount;
 std::unique_ptr<Screen> SystemInfo::CreateScreen3() {
-  lv_mem_monitor_t mon;
-  lv_mem_monitor(&mon);
+  auto lvglStats = Components::LvglArena::GetStats();
+  HeapStats_t heapStats;
+  vPortGetHeapStats(&heapStats);
 
   lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(label, true);
@@ -191,12 +205,13 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen3() {
   lv_label_set_text_fmt(label,
                         "#808080 BLE MAC#\n"
                         " %02x:%02x:%02x:%02x:%02x:%02x\n"
-                        "\n"
                         "#808080 SPI Flash# %02x-%02x-%02x\n"
-                        "\n"
+                        "#808080 LVGL# %d/%d\n"
+                        " #808080 Max# %d #808080 Ovf# %d\n"
                         "#808080 Memory heap#\n"
                         " #808080 Free# %d/%d\n"
                         " #808080 Min free# %d\n"
+                        " #808080 Largest# %d\n"
                         " #808080 Alloc err# %d\n"
                         " #808080 Ovrfl err# %d",
                         bleAddr[5],
@@ -208,13 +223,18 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen3() {
                         spiFlashId.manufacturer,
                         spiFlashId.type,
                         spiFlashId.density,
+                        lvglStats.used,
+                        lvglStats.size,
+                        lvglStats.peak,
+                        lvglStats.nbOverflows,
                         xPortGetFreeHeapSize(),
                         xPortGetHeapSize(),
                         xPortGetMinimumEverFreeHeapSize(),
+                        heapStats.xSizeOfLargestFreeBlockInBytes,
                         mallocFailedCount,
                         stackOverflowCount);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(2, 5, label);
+  return std::make_unique<Screens::Label>(2, 7, label);
 }
 
 bool SystemInfo::sortById(const TaskStatus_t& lhs, const TaskStatus_t& rhs) {
@@ -280,10 +300,98 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen4() {
     }
     lv_table_set_cell_value(infoTask, i + 1, 3, buffer);
   }
-  return std::make_unique<Screens::Label>(3, 5, infoTask);
+  return std::make_unique<Screens::Label>(3, 7, infoTask);
 }
 
 std::unique_ptr<Screen> SystemInfo::CreateScreen5() {
+  // One row per task, then the total of all the tasks but the idle task, over the last window of the system monitor
+  auto snapshot = systemMonitor.GetSnapshot();
+  const auto& stats = snapshot.stats;
+  lv_obj_t* infoCpu = lv_table_create(lv_scr_act(), nullptr);
+  lv_table_set_col_cnt(infoCpu, 3);
+  lv_table_set_row_cnt(infoCpu, stats.nbTasks + 2);
+  lv_obj_set_style_local_pad_all(infoCpu, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 0);
+  lv_obj_set_style_local_border_color(infoCpu, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, Colors::lightGray);
+
+  lv_table_set_cell_value(infoCpu, 0, 0, "Task");
+  lv_table_set_col_width(infoCpu, 0, 80);
+  lv_table_set_cell_value(infoCpu, 0, 1, "CPU%");
+  lv_table_set_col_width(infoCpu, 1, 80);
+  lv_table_set_cell_value(infoCpu, 0, 2, "Sw/s");
+  lv_table_set_col_width(infoCpu, 2, 80);
+
+  uint32_t windowSeconds = std::max<uint32_t>(1, stats.windowMs / 1000);
+  char buffer[12] = {0};
+  for (uint8_t i = 0; i < stats.nbTasks; i++) {
+    const auto& task = snapshot.tasks[i];
+    lv_table_set_cell_value(infoCpu, i + 1, 0, task.name);
+    snprintf(buffer, sizeof(buffer), "%u.%u", task.cpuPermille / 10, task.cpuPermille % 10);
+    lv_table_set_cell_value(infoCpu, i + 1, 1, buffer);
+    snprintf(buffer, sizeof(buffer), "%lu", task.contextSwitches / windowSeconds);
+    lv_table_set_cell_value(infoCpu, i + 1, 2, buffer);
+  }
+  lv_table_set_cell_value(infoCpu, stats.nbTasks + 1, 0, "*");
+  snprintf(buffer, sizeof(buffer), "%u.%u", stats.cpuPermille / 10, stats.cpuPermille % 10);
+  lv_table_set_cell_value(infoCpu, stats.nbTasks + 1, 1, buffer);
+  return std::make_unique<Screens::Label>(4, 7, infoCpu);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen6() {
+  if (!Controllers::FrameProfiler::Enabled) {
+    lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
+    lv_label_set_recolor(label, true);
+    lv_label_set_text_static(label,
+                             "#FFFF00 Frame profiler#\n\n"
+                             "Not available in\n"
+                             "this build\n\n"
+                             "#808080 Build with#\n"
+                             "#808080 ENABLE_FRAME_#\n"
+                             "#808080 PROFILER=1#");
+    lv_label_set_align(label, LV_LABEL_ALIGN_CENTER);
+    lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
+    return std::make_unique<Screens::Label>(5, 7, label);
+  }
+
+  // One row per watch face, then the frames currently held in the ring buffer (any app)
+  static constexpr uint8_t nbRows = Controllers::FrameProfiler::MaxWatchFaces + 2;
+  lv_obj_t* infoFrames = lv_table_create(lv_scr_act(), nullptr);
+  lv_table_set_col_cnt(infoFrames, 4);
+  lv_table_set_row_cnt(infoFrames, nbRows);
+  lv_obj_set_style_local_pad_all(infoFrames, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 0);
+  lv_obj_set_style_local_border_color(infoFrames, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, Colors::lightGray);
+
+  lv_table_set_cell_value(infoFrames, 0, 0, "WF");
+  lv_table_set_col_width(infoFrames, 0, 40);
+  lv_table_set_cell_value(infoFrames, 0, 1, "Frames");
+  lv_table_set_col_width(infoFrames, 1, 80);
+  lv_table_set_cell_value(infoFrames, 0, 2, "Rndr");
+  lv_table_set_col_width(infoFrames, 2, 60);
+  lv_table_set_cell_value(infoFrames, 0, 3, "Flsh");
+  lv_table_set_col_width(infoFrames, 3, 60);
+
+  auto fillRow = [infoFrames](uint16_t row, const char* name, const Controllers::FrameProfiler::Summary& summary) {
+    char buffer[12] = {0};
+    lv_table_set_cell_value(infoFrames, row, 0, name);
+    snprintf(buffer, sizeof(buffer), "%lu", summary.nbFrames);
+    lv_table_set_cell_value(infoFrames, row, 1, buffer);
+    // Average times, in ms
+    snprintf(buffer, sizeof(buffer), "%lu.%lu", summary.avgRenderTimeUs / 1000, (summary.avgRenderTimeUs / 100) % 10);
+    lv_table_set_cell_value(infoFrames, row, 2, buffer);
+    snprintf(buffer, sizeof(buffer), "%lu.%lu", summary.avgFlushTimeUs / 1000, (summary.avgFlushTimeUs / 100) % 10);
+    lv_table_set_cell_value(infoFrames, row, 3, buffer);
+  };
+
+  for (uint8_t i = 0; i < Controllers::FrameProfiler::MaxWatchFaces; i++) {
+    char name[4] = {0};
+    snprintf(name, sizeof(name), "%u", i);
+    fillRow(i + 1, name, frameProfiler.GetWatchFaceSummary(i));
+  }
+  fillRow(nbRows - 1, "*", frameProfiler.GetSummary());
+
+  return std::make_unique<Screens::Label>(5, 7, infoFrames);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen7() {
   lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(label, true);
   lv_label_set_text_static(label,
@@ -297,5 +405,5 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen5() {
                            "#FFFF00 InfiniTime#");
   lv_label_set_align(label, LV_LABEL_ALIGN_CENTER);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(4, 5, label);
+  return std::make_unique<Screens::Label>(6, 7, label);
 }
@@ -10,12 +10,17 @@ namespace Pinetime {
     class Battery;
     class BrightnessController;
     class Ble;
+    class FrameProfiler;
   }
 
   namespace Drivers {
     class Watchdog;
   }
 
+  namespace System {
+    class SystemMonitor;
+  }
+
   namespace Applications {
     class DisplayApp;
 
@@ -30,7 +35,9 @@ namespace Pinetime {
                             const Pinetime::Drivers::Watchdog& watchdog,
                             Pinetime::Controllers::MotionController& motionController,
                             const Pinetime::Drivers::Cst816S& touchPanel,
-                            const Pinetime::Drivers::SpiNorFlash& spiNorFlash);
+                            const Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                            const Pinetime::Controllers::FrameProfiler& frameProfiler,
+                            const Pinetime::System::SystemMonitor& systemMonitor);
         ~SystemInfo() override;
         bool OnTouchEvent(TouchEvents event) override;
 
@@ -43,8 +50,10 @@ namespace Pinetime {
         Pinetime::Controllers::MotionController& motionController;
         const Pinetime::Drivers::Cst816S& touchPanel;
         const Pinetime::Drivers::SpiNorFlash& spiNorFlash;
+        const Pinetime::Controllers::FrameProfiler& frameProfiler;
+        const Pinetime::System::SystemMonitor& systemMonitor;
 
-        ScreenList<5> screens;
+        ScreenList<7> screens;
 
         static bool sortById(const TaskStatus_t& lhs, const TaskStatus_t& rhs);
 
@@ -53,6 +62,8 @@ namespace Pinetime {
         std::unique_ptr<Screen> CreateScreen3();
         std::unique_ptr<Screen> CreateScreen4();
         std::unique_ptr<Screen> CreateScreen5();
+        std::unique_ptr<Screen> CreateScreen6();
+        std::unique_ptr<Screen> CreateScreen7();
       };
     }
   }
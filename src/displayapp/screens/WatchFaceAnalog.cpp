@@ -6,6 +6,7 @@
 #include "displayapp/screens/BleIcon.h"
 #include "displayapp/screens/Symbols.h"
 #include "displayapp/screens/NotificationIcon.h"
+#include "components/changes/ChangeNotifier.h"
 #include "components/settings/Settings.h"
 #include "displayapp/InfiniTimeTheme.h"
 
@@ -48,7 +49,8 @@ WatchFaceAnalog::WatchFaceAnalog(Controllers::DateTime& dateTimeController,
                                  const Controllers::Battery& batteryController,
                                  const Controllers::Ble& bleController,
                                  Controllers::NotificationManager& notificationManager,
-                                 Controllers::Settings& settingsController)
+                                 Controllers::Settings& settingsController,
+                                 Controllers::ChangeNotifier& changeNotifier)
   : currentDateTime {{}},
     batteryIcon(true),
     dateTimeController {dateTimeController},
@@ -157,14 +159,17 @@ WatchFaceAnalog::WatchFaceAnalog(Controllers::DateTime& dateTimeController,
   lv_style_set_line_rounded(&hour_line_style_trace, LV_STATE_DEFAULT, false);
   lv_obj_add_style(hour_body_trace, LV_LINE_PART_MAIN, &hour_line_style_trace);
 
-  taskRefresh = lv_task_create(RefreshTaskCallback, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, this);
+  using Topic = Controllers::ChangeNotifier::Topic;
+  changeNotifier.Subscribe(Controllers::ChangeNotifier::Mask(Topic::Minutes,
+                                                             Topic::Seconds,
+                                                             Topic::Battery,
+                                                             Topic::Ble,
+                                                             Topic::Notifications));
 
   Refresh();
 }
 
 WatchFaceAnalog::~WatchFaceAnalog() {
-  lv_task_del(taskRefresh);
-
   lv_style_reset(&hour_line_style);
   lv_style_reset(&hour_line_style_trace);
   lv_style_reset(&minute_line_style);
@@ -14,6 +14,7 @@
 
 namespace Pinetime {
   namespace Controllers {
+    class ChangeNotifier;
     class Settings;
     class Battery;
     class Ble;
@@ -29,7 +30,8 @@ namespace Pinetime {
                         const Controllers::Battery& batteryController,
                         const Controllers::Ble& bleController,
                         Controllers::NotificationManager& notificationManager,
-                        Controllers::Settings& settingsController);
+                        Controllers::Settings& settingsController,
+                        Controllers::ChangeNotifier& changeNotifier);
 
         ~WatchFaceAnalog() override;
 
@@ -84,7 +86,6 @@ namespace Pinetime {
         void UpdateClock();
         void SetBatteryIcon();
 
-        lv_task_t* taskRefresh;
       };
     }
 
@@ -98,7 +99,8 @@ namespace Pinetime {
                                             controllers.batteryController,
                                             controllers.bleController,
                                             controllers.notificationManager,
-                                            controllers.settingsController);
+                                            controllers.settingsController,
+                                            controllers.changeNotifier);
       };
 
       static bool IsAvailable(Pinetime::Controllers::FS& /*filesystem*/) {
@@ -6,6 +6,8 @@
 #include "displayapp/screens/BleIcon.h"
 #include "displayapp/screens/NotificationIcon.h"
 #include "displayapp/screens/Symbols.h"
+#include "displayapp/GlyphCache.h"
+#include "components/changes/ChangeNotifier.h"
 #include "components/battery/BatteryController.h"
 #include "components/ble/BleController.h"
 #include "components/ble/NotificationManager.h"
@@ -21,7 +23,8 @@ WatchFaceCasioStyleG7710::WatchFaceCasioStyleG7710(Controllers::DateTime& dateTi
                                                    Controllers::Settings& settingsController,
                                                    Controllers::HeartRateController& heartRateController,
                                                    Controllers::MotionController& motionController,
-                                                   Controllers::FS& filesystem)
+                                                   Controllers::FS& filesystem,
+                                                   Controllers::ChangeNotifier& changeNotifier)
   : currentDateTime {{}},
     batteryIcon(false),
     dateTimeController {dateTimeController},
@@ -32,21 +35,9 @@ WatchFaceCasioStyleG7710::WatchFaceCasioStyleG7710(Controllers::DateTime& dateTi
     heartRateController {heartRateController},
     motionController {motionController} {
 
-  lfs_file f = {};
-  if (filesystem.FileOpen(&f, "/fonts/lv_font_dots_40.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_dot40 = lv_font_load("F:/fonts/lv_font_dots_40.bin");
-  }
-
-  if (filesystem.FileOpen(&f, "/fonts/7segments_40.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_segment40 = lv_font_load("F:/fonts/7segments_40.bin");
-  }
-
-  if (filesystem.FileOpen(&f, "/fonts/7segments_115.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_segment115 = lv_font_load("F:/fonts/7segments_115.bin");
-  }
+  font_dot40 = Components::GlyphCache::Load(filesystem, "/fonts/lv_font_dots_40.bin");
+  font_segment40 = Components::GlyphCache::Load(filesystem, "/fonts/7segments_40.bin");
+  font_segment115 = Components::GlyphCache::Load(filesystem, "/fonts/7segments_115.bin");
 
   label_battery_value = lv_label_create(lv_scr_act(), nullptr);
   lv_obj_align(label_battery_value, lv_scr_act(), LV_ALIGN_IN_TOP_RIGHT, 0, 0);
@@ -168,27 +159,24 @@ WatchFaceCasioStyleG7710::WatchFaceCasioStyleG7710(Controllers::DateTime& dateTi
   lv_label_set_text_static(stepIcon, Symbols::shoe);
   lv_obj_align(stepIcon, stepValue, LV_ALIGN_OUT_LEFT_MID, -5, 0);
 
-  taskRefresh = lv_task_create(RefreshTaskCallback, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, this);
+  using Topic = Controllers::ChangeNotifier::Topic;
+  changeNotifier.Subscribe(Controllers::ChangeNotifier::Mask(Topic::Minutes,
+                                                             Topic::Battery,
+                                                             Topic::Ble,
+                                                             Topic::HeartRate,
+                                                             Topic::Motion,
+                                                             Topic::Notifications));
   Refresh();
 }
 
 WatchFaceCasioStyleG7710::~WatchFaceCasioStyleG7710() {
-  lv_task_del(taskRefresh);
 
   lv_style_reset(&style_line);
   lv_style_reset(&style_border);
 
-  if (font_dot40 != nullptr) {
-    lv_font_free(font_dot40);
-  }
-
-  if (font_segment40 != nullptr) {
-    lv_font_free(font_segment40);
-  }
-
-  if (font_segment115 != nullptr) {
-    lv_font_free(font_segment115);
-  }
+  Components::GlyphCache::Free(font_dot40);
+  Components::GlyphCache::Free(font_segment40);
+  Components::GlyphCache::Free(font_segment115);
 
   lv_obj_clean(lv_scr_act());
 }
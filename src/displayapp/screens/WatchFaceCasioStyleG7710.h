@@ -14,6 +14,7 @@
 
 namespace Pinetime {
   namespace Controllers {
+    class ChangeNotifier;
     class Settings;
     class Battery;
     class Ble;
@@ -34,7 +35,8 @@ namespace Pinetime {
                                  Controllers::Settings& settingsController,
                                  Controllers::HeartRateController& heartRateController,
                                  Controllers::MotionController& motionController,
-                                 Controllers::FS& filesystem);
+                                 Controllers::FS& filesystem,
+                                 Controllers::ChangeNotifier& changeNotifier);
         ~WatchFaceCasioStyleG7710() override;
 
         void Refresh() override;
@@ -95,7 +97,6 @@ namespace Pinetime {
         Controllers::HeartRateController& heartRateController;
         Controllers::MotionController& motionController;
 
-        lv_task_t* taskRefresh;
         lv_font_t* font_dot40 = nullptr;
         lv_font_t* font_segment40 = nullptr;
         lv_font_t* font_segment115 = nullptr;
@@ -115,7 +116,8 @@ namespace Pinetime {
                                                      controllers.settingsController,
                                                      controllers.heartRateController,
                                                      controllers.motionController,
-                                                     controllers.filesystem);
+                                                     controllers.filesystem,
+                                                     controllers.changeNotifier);
       };
 
       static bool IsAvailable(Pinetime::Controllers::FS& filesystem) {
@@ -6,6 +6,7 @@
 #include "displayapp/screens/NotificationIcon.h"
 #include "displayapp/screens/Symbols.h"
 #include "displayapp/screens/WeatherSymbols.h"
+#include "components/changes/ChangeNotifier.h"
 #include "components/battery/BatteryController.h"
 #include "components/ble/BleController.h"
 #include "components/ble/NotificationManager.h"
@@ -24,7 +25,8 @@ WatchFaceDigital::WatchFaceDigital(Controllers::DateTime& dateTimeController,
                                    Controllers::Settings& settingsController,
                                    Controllers::HeartRateController& heartRateController,
                                    Controllers::MotionController& motionController,
-                                   Controllers::SimpleWeatherService& weatherService)
+                                   Controllers::SimpleWeatherService& weatherService,
+                                   Controllers::ChangeNotifier& changeNotifier)
   : currentDateTime {{}},
     dateTimeController {dateTimeController},
     notificationManager {notificationManager},
@@ -86,12 +88,18 @@ WatchFaceDigital::WatchFaceDigital(Controllers::DateTime& dateTimeController,
   lv_label_set_text_static(stepIcon, Symbols::shoe);
   lv_obj_align(stepIcon, stepValue, LV_ALIGN_OUT_LEFT_MID, -5, 0);
 
-  taskRefresh = lv_task_create(RefreshTaskCallback, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, this);
+  using Topic = Controllers::ChangeNotifier::Topic;
+  changeNotifier.Subscribe(Controllers::ChangeNotifier::Mask(Topic::Minutes,
+                                                             Topic::Battery,
+                                                             Topic::Ble,
+                                                             Topic::HeartRate,
+                                                             Topic::Motion,
+                                                             Topic::Notifications,
+                                                             Topic::Weather));
   Refresh();
 }
 
 WatchFaceDigital::~WatchFaceDigital() {
-  lv_task_del(taskRefresh);
   lv_obj_clean(lv_scr_act());
 }
 
@@ -14,6 +14,7 @@
 
 namespace Pinetime {
   namespace Controllers {
+    class ChangeNotifier;
     class Settings;
     class Battery;
     class Ble;
@@ -36,7 +37,8 @@ namespace Pinetime {
                          Controllers::Settings& settingsController,
                          Controllers::HeartRateController& heartRateController,
                          Controllers::MotionController& motionController,
-                         Controllers::SimpleWeatherService& weather);
+                         Controllers::SimpleWeatherService& weather,
+                         Controllers::ChangeNotifier& changeNotifier);
         ~WatchFaceDigital() override;
 
         void Refresh() override;
@@ -72,7 +74,6 @@ namespace Pinetime {
         Controllers::MotionController& motionController;
         Controllers::SimpleWeatherService& weatherService;
 
-        lv_task_t* taskRefresh;
         Widgets::StatusIcons statusIcons;
       };
     }
@@ -91,7 +92,8 @@ namespace Pinetime {
                                              controllers.settingsController,
                                              controllers.heartRateController,
                                              controllers.motionController,
-                                             *controllers.weatherController);
+                                             *controllers.weatherController,
+                                             controllers.changeNotifier);
       };
 
       static bool IsAvailable(Pinetime::Controllers::FS& /*filesystem*/) {
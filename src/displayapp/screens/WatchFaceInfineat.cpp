@@ -3,7 +3,9 @@
 #include <lvgl/lvgl.h>
 #include <cstdio>
 #include "displayapp/screens/Symbols.h"
+#include "displayapp/GlyphCache.h"
 #include "displayapp/screens/BleIcon.h"
+#include "components/changes/ChangeNotifier.h"
 #include "components/settings/Settings.h"
 #include "components/battery/BatteryController.h"
 #include "components/ble/BleController.h"
@@ -18,6 +20,10 @@ namespace {
     screen->UpdateSelected(obj, event);
   }
 
+  using Topic = Pinetime::Controllers::ChangeNotifier::Topic;
+  constexpr auto refreshTopics =
+    Pinetime::Controllers::ChangeNotifier::Mask(Topic::Minutes, Topic::Battery, Topic::Ble, Topic::Motion, Topic::Notifications);
+
   enum class colors {
     orange,
     blue,
@@ -125,24 +131,18 @@ WatchFaceInfineat::WatchFaceInfineat(Controllers::DateTime& dateTimeController,
                                      Controllers::NotificationManager& notificationManager,
                                      Controllers::Settings& settingsController,
                                      Controllers::MotionController& motionController,
-                                     Controllers::FS& filesystem)
+                                     Controllers::FS& filesystem,
+                                     Controllers::ChangeNotifier& changeNotifier)
   : currentDateTime {{}},
     dateTimeController {dateTimeController},
     batteryController {batteryController},
     bleController {bleController},
     notificationManager {notificationManager},
     settingsController {settingsController},
-    motionController {motionController} {
-  lfs_file f = {};
-  if (filesystem.FileOpen(&f, "/fonts/teko.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_teko = lv_font_load("F:/fonts/teko.bin");
-  }
-
-  if (filesystem.FileOpen(&f, "/fonts/bebas.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_bebas = lv_font_load("F:/fonts/bebas.bin");
-  }
+    motionController {motionController},
+    changeNotifier {changeNotifier} {
+  font_teko = Components::GlyphCache::Load(filesystem, "/fonts/teko.bin");
+  font_bebas = Components::GlyphCache::Load(filesystem, "/fonts/bebas.bin");
 
   // Side Cover
   static constexpr lv_point_t linePoints[nLines][2] = {{{30, 25}, {68, -8}},
@@ -296,19 +296,12 @@ WatchFaceInfineat::WatchFaceInfineat(Controllers::DateTime& dateTimeController,
   lv_label_set_text_static(labelBtnSettings, Symbols::settings);
   lv_obj_set_hidden(btnSettings, true);
 
-  taskRefresh = lv_task_create(RefreshTaskCallback, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, this);
   Refresh();
 }
 
 WatchFaceInfineat::~WatchFaceInfineat() {
-  lv_task_del(taskRefresh);
-
-  if (font_bebas != nullptr) {
-    lv_font_free(font_bebas);
-  }
-  if (font_teko != nullptr) {
-    lv_font_free(font_teko);
-  }
+  Components::GlyphCache::Free(font_bebas);
+  Components::GlyphCache::Free(font_teko);
 
   lv_obj_clean(lv_scr_act());
 }
@@ -317,6 +310,7 @@ bool WatchFaceInfineat::OnTouchEvent(Pinetime::Applications::TouchEvents event)
   if ((event == Pinetime::Applications::TouchEvents::LongTap) && lv_obj_get_hidden(btnSettings)) {
     lv_obj_set_hidden(btnSettings, false);
     savedTick = xTaskGetTickCount();
+    UpdateSubscriptions();
     return true;
   }
   // Prevent screen from sleeping when double tapping with settings on
@@ -468,6 +462,17 @@ void WatchFaceInfineat::Refresh() {
       savedTick = 0;
     }
   }
+
+  UpdateSubscriptions();
+}
+
+void WatchFaceInfineat::UpdateSubscriptions() {
+  // The charging animation and the timeout of the settings button need a refresh every frame
+  if (isCharging.Get() || !lv_obj_get_hidden(btnSettings)) {
+    changeNotifier.Subscribe(refreshTopics | Controllers::ChangeNotifier::Mask(Topic::Frame));
+  } else {
+    changeNotifier.Subscribe(refreshTopics);
+  }
 }
 
 void WatchFaceInfineat::SetBatteryLevel(uint8_t batteryPercent) {
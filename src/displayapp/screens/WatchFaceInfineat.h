@@ -12,6 +12,7 @@
 
 namespace Pinetime {
   namespace Controllers {
+    class ChangeNotifier;
     class Settings;
     class Battery;
     class Ble;
@@ -31,7 +32,8 @@ namespace Pinetime {
                           Controllers::NotificationManager& notificationManager,
                           Controllers::Settings& settingsController,
                           Controllers::MotionController& motionController,
-                          Controllers::FS& fs);
+                          Controllers::FS& fs,
+                          Controllers::ChangeNotifier& changeNotifier);
 
         ~WatchFaceInfineat() override;
 
@@ -91,11 +93,12 @@ namespace Pinetime {
         Controllers::NotificationManager& notificationManager;
         Controllers::Settings& settingsController;
         Controllers::MotionController& motionController;
+        Controllers::ChangeNotifier& changeNotifier;
 
         void SetBatteryLevel(uint8_t batteryPercent);
         void ToggleBatteryIndicatorColor(bool showSideCover);
+        void UpdateSubscriptions();
 
-        lv_task_t* taskRefresh;
         lv_font_t* font_teko = nullptr;
         lv_font_t* font_bebas = nullptr;
       };
@@ -113,7 +116,8 @@ namespace Pinetime {
                                               controllers.notificationManager,
                                               controllers.settingsController,
                                               controllers.motionController,
-                                              controllers.filesystem);
+                                              controllers.filesystem,
+                                              controllers.changeNotifier);
       };
 
       static bool IsAvailable(Pinetime::Controllers::FS& filesystem) {
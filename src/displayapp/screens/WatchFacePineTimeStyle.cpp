@@ -28,6 +28,7 @@
 #include "displayapp/screens/NotificationIcon.h"
 #include "displayapp/screens/Symbols.h"
 #include "displayapp/screens/WeatherSymbols.h"
+#include "components/changes/ChangeNotifier.h"
 #include "components/battery/BatteryController.h"
 #include "components/ble/BleController.h"
 #include "components/ble/NotificationManager.h"
@@ -51,7 +52,8 @@ WatchFacePineTimeStyle::WatchFacePineTimeStyle(Controllers::DateTime& dateTimeCo
                                                Controllers::NotificationManager& notificationManager,
                                                Controllers::Settings& settingsController,
                                                Controllers::MotionController& motionController,
-                                               Controllers::SimpleWeatherService& weatherService)
+                                               Controllers::SimpleWeatherService& weatherService,
+                                               Controllers::ChangeNotifier& changeNotifier)
   : currentDateTime {{}},
     batteryIcon(false),
     dateTimeController {dateTimeController},
@@ -394,12 +396,18 @@ WatchFacePineTimeStyle::WatchFacePineTimeStyle(Controllers::DateTime& dateTimeCo
   lv_label_set_text_static(lblSetOpts, Symbols::settings);
   lv_obj_set_hidden(btnSetOpts, true);
 
-  taskRefresh = lv_task_create(RefreshTaskCallback, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, this);
+  using Topic = Controllers::ChangeNotifier::Topic;
+  changeNotifier.Subscribe(Controllers::ChangeNotifier::Mask(Topic::Minutes,
+                                                             Topic::Seconds,
+                                                             Topic::Battery,
+                                                             Topic::Ble,
+                                                             Topic::Motion,
+                                                             Topic::Notifications,
+                                                             Topic::Weather));
   Refresh();
 }
 
 WatchFacePineTimeStyle::~WatchFacePineTimeStyle() {
-  lv_task_del(taskRefresh);
   lv_obj_clean(lv_scr_act());
 }
 
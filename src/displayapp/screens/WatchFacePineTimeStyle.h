@@ -15,6 +15,7 @@
 
 namespace Pinetime {
   namespace Controllers {
+    class ChangeNotifier;
     class Settings;
     class Battery;
     class Ble;
@@ -33,7 +34,8 @@ namespace Pinetime {
                                Controllers::NotificationManager& notificationManager,
                                Controllers::Settings& settingsController,
                                Controllers::MotionController& motionController,
-                               Controllers::SimpleWeatherService& weather);
+                               Controllers::SimpleWeatherService& weather,
+                               Controllers::ChangeNotifier& changeNotifier);
         ~WatchFacePineTimeStyle() override;
 
         bool OnTouchEvent(TouchEvents event) override;
@@ -117,7 +119,6 @@ namespace Pinetime {
         void SetBatteryIcon();
         void CloseMenu();
 
-        lv_task_t* taskRefresh;
       };
     }
 
@@ -133,7 +134,8 @@ namespace Pinetime {
                                                    controllers.notificationManager,
                                                    controllers.settingsController,
                                                    controllers.motionController,
-                                                   *controllers.weatherController);
+                                                   *controllers.weatherController,
+                                                   controllers.changeNotifier);
       };
 
       static bool IsAvailable(Pinetime::Controllers::FS& /*filesystem*/) {
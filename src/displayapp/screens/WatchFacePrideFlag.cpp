@@ -1,5 +1,6 @@
 #include "displayapp/screens/WatchFacePrideFlag.h"
 #include <lvgl/lvgl.h>
+#include "components/changes/ChangeNotifier.h"
 #include "components/battery/BatteryController.h"
 #include "components/ble/BleController.h"
 #include "displayapp/screens/Symbols.h"
@@ -86,7 +87,8 @@ WatchFacePrideFlag::WatchFacePrideFlag(Controllers::DateTime& dateTimeController
                                        const Controllers::Ble& bleController,
                                        Controllers::NotificationManager& notificationManager,
                                        Controllers::Settings& settingsController,
-                                       Controllers::MotionController& motionController)
+                                       Controllers::MotionController& motionController,
+                                       Controllers::ChangeNotifier& changeNotifier)
   : currentDateTime {{}},
     dateTimeController {dateTimeController},
     batteryController {batteryController},
@@ -163,12 +165,17 @@ WatchFacePrideFlag::WatchFacePrideFlag(Controllers::DateTime& dateTimeController
 
   UpdateScreen(settingsController.GetPrideFlag());
 
-  taskRefresh = lv_task_create(RefreshTaskCallback, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, this);
+  using Topic = Controllers::ChangeNotifier::Topic;
+  changeNotifier.Subscribe(Controllers::ChangeNotifier::Mask(Topic::Minutes,
+                                                             Topic::Seconds,
+                                                             Topic::Battery,
+                                                             Topic::Ble,
+                                                             Topic::Motion,
+                                                             Topic::Notifications));
   Refresh();
 }
 
 WatchFacePrideFlag::~WatchFacePrideFlag() {
-  lv_task_del(taskRefresh);
   lv_obj_clean(lv_scr_act());
 }
 
@@ -282,6 +289,7 @@ void WatchFacePrideFlag::UpdateSelected(lv_obj_t* object, lv_event_t event) {
     settingsController.SetPrideFlag(valueFlag);
     if (flagChanged) {
       UpdateScreen(valueFlag);
+      Refresh();
     }
   }
 }
@@ -13,6 +13,7 @@
 
 namespace Pinetime {
   namespace Controllers {
+    class ChangeNotifier;
     class Settings;
     class Battery;
     class Ble;
@@ -30,7 +31,8 @@ namespace Pinetime {
                            const Controllers::Ble& bleController,
                            Controllers::NotificationManager& notificationManager,
                            Controllers::Settings& settingsController,
-                           Controllers::MotionController& motionController);
+                           Controllers::MotionController& motionController,
+                           Controllers::ChangeNotifier& changeNotifier);
         ~WatchFacePrideFlag() override;
 
         bool OnTouchEvent(TouchEvents event) override;
@@ -75,7 +77,6 @@ namespace Pinetime {
         Controllers::Settings& settingsController;
         Controllers::MotionController& motionController;
 
-        lv_task_t* taskRefresh;
         void CloseMenu();
       };
     }
@@ -91,7 +92,8 @@ namespace Pinetime {
                                                controllers.bleController,
                                                controllers.notificationManager,
                                                controllers.settingsController,
-                                               controllers.motionController);
+                                               controllers.motionController,
+                                               controllers.changeNotifier);
       };
 
       static bool IsAvailable(Pinetime::Controllers::FS& /*filesystem*/) {
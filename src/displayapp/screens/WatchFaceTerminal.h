@@ -11,6 +11,7 @@
 
 namespace Pinetime {
   namespace Controllers {
+    class ChangeNotifier;
     class Settings;
     class Battery;
     class Ble;
@@ -30,7 +31,8 @@ namespace Pinetime {
                           Controllers::NotificationManager& notificationManager,
                           Controllers::Settings& settingsController,
                           Controllers::HeartRateController& heartRateController,
-                          Controllers::MotionController& motionController);
+                          Controllers::MotionController& motionController,
+                          Controllers::ChangeNotifier& changeNotifier);
         ~WatchFaceTerminal() override;
 
         void Refresh() override;
@@ -65,7 +67,6 @@ namespace Pinetime {
         Controllers::HeartRateController& heartRateController;
         Controllers::MotionController& motionController;
 
-        lv_task_t* taskRefresh;
       };
     }
 
@@ -81,7 +82,8 @@ namespace Pinetime {
                                               controllers.notificationManager,
                                               controllers.settingsController,
                                               controllers.heartRateController,
-                                              controllers.motionController);
+                                              controllers.motionController,
+                                              controllers.changeNotifier);
       };
 
       static bool IsAvailable(Pinetime::Controllers::FS& /*filesystem*/) {
@@ -1,4 +1,5 @@
 #include "drivers/Bma421.h"
+#include <algorithm>
 #include <libraries/delay/nrf_delay.h>
 #include <libraries/log/nrf_log.h>
 #include "drivers/TwiMaster.h"
@@ -32,6 +33,13 @@ namespace {
     [BMA4_ACCEL_RANGE_8G] = 256,  // LSB/g +/- 8g range
     [BMA4_ACCEL_RANGE_16G] = 128  // LSB/g +/- 16g range
   };
+
+  // Headerless FIFO frames only contain the x, y and z accelerometer values
+  constexpr size_t fifoFrameSize = 6;
+  // The FIFO sample rate is the 100Hz ODR divided by 2^downsampling
+  constexpr uint32_t odrPeriodMs = 10;
+  constexpr uint8_t maxFifoDownsampling = 3;
+  constexpr uint8_t fifoFlushCommand = 0xb0;
 }
 
 Bma421::Bma421(TwiMaster& twiMaster, uint8_t twiAddress) : twiMaster {twiMaster}, deviceAddress {twiAddress} {
@@ -68,7 +76,8 @@ void Bma421::Init() {
   if (ret != BMA4_OK)
     return;
 
-  ret = bma4_set_interrupt_mode(BMA4_LATCH_MODE, &bma);
+  // The FIFO watermark interrupt line goes low again as soon as the FIFO has been read
+  ret = bma4_set_interrupt_mode(BMA4_NON_LATCH_MODE, &bma);
   if (ret != BMA4_OK)
     return;
 
@@ -93,6 +102,47 @@ void Bma421::Init() {
     return;
 
   isOk = true;
+  isFifoEnabled = InitFifo();
+}
+
+bool Bma421::InitFifo() {
+  // Headerless mode with accelerometer data only
+  auto ret = bma4_set_fifo_config(BMA4_FIFO_HEADER | BMA4_FIFO_TIME | BMA4_FIFO_MAG, BMA4_DISABLE, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  ret = bma4_set_fifo_config(BMA4_FIFO_ACCEL, BMA4_ENABLE, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  ret = bma4_set_accel_fifo_filter_data(1, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  fifoDownsampling = maxFifoDownsampling;
+  ret = bma4_set_fifo_down_accel(fifoDownsampling, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  struct bma4_int_pin_config pinConfig = {.edge_ctrl = BMA4_EDGE_TRIGGER,
+                                          .lvl = BMA4_ACTIVE_HIGH,
+                                          .od = BMA4_PUSH_PULL,
+                                          .output_en = BMA4_OUTPUT_ENABLE,
+                                          .input_en = BMA4_INPUT_DISABLE};
+  ret = bma4_set_int_pin_config(&pinConfig, BMA4_INTR1_MAP, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  ret = bma423_map_interrupt(BMA4_INTR1_MAP, BMA4_FIFO_WM_INT, BMA4_ENABLE, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  ret = bma4_set_fifo_wm(fifoFrameSize, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  ret = bma4_set_command_register(fifoFlushCommand, &bma);
+  return ret == BMA4_OK;
 }
 
 void Bma421::Reset() {
@@ -100,40 +150,116 @@ void Bma421::Reset() {
   twiMaster.Write(deviceAddress, 0x7E, &data, 1);
 }
 
-void Bma421::Read(uint8_t registerAddress, uint8_t* buffer, size_t size) {
-  twiMaster.Read(deviceAddress, registerAddress, buffer, size);
+bool Bma421::Read(uint8_t registerAddress, uint8_t* buffer, size_t size) {
+  return twiMaster.Read(deviceAddress, registerAddress, buffer, size) == TwiMaster::ErrorCodes::NoError;
 }
 
 void Bma421::Write(uint8_t registerAddress, const uint8_t* data, size_t size) {
   twiMaster.Write(deviceAddress, registerAddress, data, size);
 }
 
+Bma421::Sample Bma421::Scale(const bma4_accel& rawData) const {
+  // Scale the measured ADC counts to units of 'binary milli-g'
+  // where 1g = 1024 'binary milli-g' units.
+  // See https://github.com/InfiniTimeOrg/InfiniTime/pull/1950 for
+  // discussion of why we opted for scaling to 1024 rather than 1000.
+  int16_t x = 1024 * rawData.x / accelScaleFactors[accel_conf.range];
+  int16_t y = 1024 * rawData.y / accelScaleFactors[accel_conf.range];
+  int16_t z = 1024 * rawData.z / accelScaleFactors[accel_conf.range];
+
+  // X and Y axis are swapped because of the way the sensor is mounted in the PineTime
+  return {y, x, z};
+}
+
 Bma421::Values Bma421::Process() {
   if (not isOk)
     return {};
   struct bma4_accel rawData;
-  struct bma4_accel data;
   bma4_read_accel_xyz(&rawData, &bma);
+  auto data = Scale(rawData);
+  return {ReadSteps(), data.x, data.y, data.z};
+}
 
-  // Scale the measured ADC counts to units of 'binary milli-g'
-  // where 1g = 1024 'binary milli-g' units.
-  // See https://github.com/InfiniTimeOrg/InfiniTime/pull/1950 for
-  // discussion of why we opted for scaling to 1024 rather than 1000.
-  data.x = 1024 * rawData.x / accelScaleFactors[accel_conf.range];
-  data.y = 1024 * rawData.y / accelScaleFactors[accel_conf.range];
-  data.z = 1024 * rawData.z / accelScaleFactors[accel_conf.range];
-
+uint32_t Bma421::ReadSteps() {
+  if (not isOk)
+    return 0;
   uint32_t steps = 0;
   bma423_step_counter_output(&steps, &bma);
+  return steps;
+}
 
-  // X and Y axis are swapped because of the way the sensor is mounted in the PineTime
-  return {steps, data.y, data.x, data.z};
+void Bma421::SetFifoWatermark(uint8_t nbSamples) {
+  if (not isFifoEnabled)
+    return;
+  nbSamples = std::clamp<uint8_t>(nbSamples, 1, MaxFifoSamples);
+  bma4_set_fifo_wm(nbSamples * fifoFrameSize, &bma);
+}
+
+void Bma421::SetFifoSampleRate(uint8_t rateHz) {
+  if (not isFifoEnabled)
+    return;
+  uint8_t downsampling = 0;
+  while (downsampling < maxFifoDownsampling && rateHz * (odrPeriodMs << (downsampling + 1)) <= 1000) {
+    downsampling++;
+  }
+  if (downsampling == fifoDownsampling)
+    return;
+  if (bma4_set_fifo_down_accel(downsampling, &bma) != BMA4_OK)
+    return;
+  fifoDownsampling = downsampling;
+  // Samples taken at the previous rate would be timestamped with the new period
+  bma4_set_command_register(fifoFlushCommand, &bma);
+}
+
+uint32_t Bma421::FifoSamplePeriodMs() const {
+  return odrPeriodMs << fifoDownsampling;
+}
+
+size_t Bma421::ReadFifo(std::array<Sample, MaxFifoSamples>& samples) {
+  if (not isFifoEnabled)
+    return 0;
+  uint16_t length = 0;
+  if (bma4_get_fifo_length(&length, &bma) != BMA4_OK)
+    return 0;
+
+  // Whole frames only: the chip repeats a partially read frame on the next read.
+  // Anything left in the FIFO is read with the next batch.
+  length = std::min<uint16_t>(length - (length % fifoFrameSize), MaxFifoSamples * fifoFrameSize);
+  uint16_t nbSamples = 0;
+  if (length > 0) {
+    std::array<uint8_t, MaxFifoSamples * fifoFrameSize> buffer;
+    // In bursts of whole frames, short enough for the freeze detection of TwiMaster. The frames of a failed burst are
+    // lost: the whole batch is dropped rather than decoding a partial buffer.
+    for (uint16_t offset = 0; offset < length;) {
+      uint16_t burst = std::min<uint16_t>(length - offset, MaxFifoBurstSamples * fifoFrameSize);
+      if (!Read(BMA4_FIFO_DATA_ADDR, buffer.data() + offset, burst))
+        return 0;
+      offset += burst;
+    }
+
+    struct bma4_fifo_frame fifo = {};
+    fifo.data = buffer.data();
+    fifo.length = length;
+    fifo.fifo_data_enable = BMA4_FIFO_A_ENABLE;
+    std::array<bma4_accel, MaxFifoSamples> rawData;
+    nbSamples = MaxFifoSamples;
+    if (bma4_extract_accel(rawData.data(), &nbSamples, &fifo, &bma) != BMA4_OK)
+      nbSamples = 0;
+    for (uint16_t i = 0; i < nbSamples; i++) {
+      samples[i] = Scale(rawData[i]);
+    }
+  }
+  return nbSamples;
 }
 
 bool Bma421::IsOk() const {
   return isOk;
 }
 
+bool Bma421::IsFifoEnabled() const {
+  return isFifoEnabled;
+}
+
 void Bma421::ResetStepCounter() {
   bma423_reset_step_counter(&bma);
 }
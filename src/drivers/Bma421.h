@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <drivers/Bma421_C/bma4_defs.h>
 
 namespace Pinetime {
@@ -16,6 +17,20 @@ namespace Pinetime {
         int16_t z;
       };
 
+      struct Sample {
+        int16_t x;
+        int16_t y;
+        int16_t z;
+      };
+
+      // The FIFO stores the accelerometer data downsampled from 100Hz to 12.5Hz by default
+      static constexpr uint8_t DefaultFifoSampleRate = 12;
+      // Samples moved by one call to ReadFifo()
+      static constexpr size_t MaxFifoSamples = 40;
+      // Samples read in a single TWI transfer. At about 390kHz a byte takes about 23µs: 16 samples of 6 bytes take about
+      // 2.3ms, under the 2.5ms after which TwiMaster considers the bus frozen.
+      static constexpr size_t MaxFifoBurstSamples = 16;
+
       Bma421(TwiMaster& twiMaster, uint8_t twiAddress);
       Bma421(const Bma421&) = delete;
       Bma421& operator=(const Bma421&) = delete;
@@ -29,14 +44,29 @@ namespace Pinetime {
       Values Process();
       void ResetStepCounter();
 
-      void Read(uint8_t registerAddress, uint8_t* buffer, size_t size);
+      /// Raises the interrupt line once the FIFO holds nbSamples samples (at most MaxFifoSamples, MaxFifoBurstSamples for the
+      /// batch to be read in a single transfer)
+      void SetFifoWatermark(uint8_t nbSamples);
+      /// Sets the lowest supported FIFO sample rate (12.5, 25, 50 or 100Hz) not below rateHz and flushes the FIFO if it changed
+      void SetFifoSampleRate(uint8_t rateHz);
+      uint32_t FifoSamplePeriodMs() const;
+      /// Moves the content of the FIFO to samples, oldest first, and returns the number of samples read (0 if the transfer
+      /// failed)
+      size_t ReadFifo(std::array<Sample, MaxFifoSamples>& samples);
+      uint32_t ReadSteps();
+
+      bool Read(uint8_t registerAddress, uint8_t* buffer, size_t size);
       void Write(uint8_t registerAddress, const uint8_t* data, size_t size);
 
       bool IsOk() const;
+      /// The accelerometer data is batched in the FIFO, signaled on the interrupt line, and must be read with ReadFifo()
+      bool IsFifoEnabled() const;
       DeviceTypes DeviceType() const;
 
     private:
       void Reset();
+      bool InitFifo();
+      Sample Scale(const bma4_accel& rawData) const;
 
       TwiMaster& twiMaster;
       uint8_t deviceAddress = 0x18;
@@ -44,6 +74,8 @@ namespace Pinetime {
       struct bma4_accel_config accel_conf; // Store the device configuration for later reference.
       bool isOk = false;
       bool isResetOk = false;
+      bool isFifoEnabled = false;
+      uint8_t fifoDownsampling = 0;
       DeviceTypes deviceType = DeviceTypes::Unknown;
     };
   }
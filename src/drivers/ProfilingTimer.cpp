@@ -0,0 +1,71 @@
+#include "drivers/ProfilingTimer.h"
+#include <FreeRTOS.h>
+#include <hal/nrf_rtc.h>
+#include <hal/nrf_timer.h>
+
+using namespace Pinetime::Drivers;
+
+namespace {
+  NRF_TIMER_Type* const timer = NRF_TIMER1;
+  // The counter of the FreeRTOS tick RTC is a 24-bit counter incremented at configTICK_RATE_HZ (1024Hz)
+  constexpr uint32_t rtcCounterMask = 0x00ffffff;
+
+  uint8_t nbUsers = 0;
+
+  // The capture register is shared by all the callers, including the interrupts
+  uint32_t EnterCritical() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+  }
+
+  void ExitCritical(uint32_t primask) {
+    __set_PRIMASK(primask);
+  }
+}
+
+void ProfilingTimer::Start() {
+  uint32_t primask = EnterCritical();
+  if (nbUsers == 0) {
+    nrf_timer_mode_set(timer, NRF_TIMER_MODE_TIMER);
+    nrf_timer_bit_width_set(timer, NRF_TIMER_BIT_WIDTH_32);
+    nrf_timer_frequency_set(timer, NRF_TIMER_FREQ_1MHz);
+    // Not cleared: the counter resumes where it stopped, durations measured by other users are kept consistent
+    nrf_timer_task_trigger(timer, NRF_TIMER_TASK_START);
+  }
+  nbUsers++;
+  ExitCritical(primask);
+}
+
+void ProfilingTimer::Stop() {
+  uint32_t primask = EnterCritical();
+  if (nbUsers > 0) {
+    nbUsers--;
+    if (nbUsers == 0) {
+      nrf_timer_task_trigger(timer, NRF_TIMER_TASK_STOP);
+    }
+  }
+  ExitCritical(primask);
+}
+
+uint32_t ProfilingTimer::NowUs() {
+  uint32_t primask = EnterCritical();
+  nrf_timer_task_trigger(timer, NRF_TIMER_TASK_CAPTURE0);
+  uint32_t now = nrf_timer_cc_read(timer, NRF_TIMER_CC_CHANNEL0);
+  ExitCritical(primask);
+  return now;
+}
+
+uint32_t ProfilingTimer::NowTicks() {
+  return nrf_rtc_counter_get(portNRF_RTC_REG);
+}
+
+uint32_t ProfilingTimer::ElapsedTicks(uint32_t since) {
+  return (NowTicks() - since) & rtcCounterMask;
+}
+
+uint32_t ProfilingTimer::TicksToMs(uint32_t ticks) {
+  static_assert(configTICK_RATE_HZ == 1024, "Change the conversion below");
+  // 1000 / 1024 = 125 / 128
+  return static_cast<uint32_t>((static_cast<uint64_t>(ticks) * 125) / 128);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Drivers {
+    // Time base of the profiling statistics.
+    // - Microseconds: TIMER1 counting at 1MHz on 32 bits (wraps after 71 minutes), read by a capture. The TIMER keeps the
+    //   HF clock running, so it only counts while at least one user holds it (Start() without Stop() yet), and durations
+    //   must be measured while holding it.
+    // - Ticks: counter of the FreeRTOS tick RTC, 1024Hz on 24 bits (wraps after 4.5 hours), always running. For durations
+    //   that span the sleep of the CPU, which a resolution of about 1ms is enough for.
+    // All the functions can be called from tasks and interrupts.
+    class ProfilingTimer {
+    public:
+      static void Start();
+      static void Stop();
+      static uint32_t NowUs();
+
+      static uint32_t ElapsedUs(uint32_t since) {
+        return NowUs() - since;
+      }
+
+      static uint32_t NowTicks();
+      static uint32_t ElapsedTicks(uint32_t since);
+      static uint32_t TicksToMs(uint32_t ticks);
+    };
+  }
+}
@@ -4,17 +4,21 @@
 
 using namespace Pinetime::Drivers;
 
-Spi::Spi(SpiMaster& spiMaster, uint8_t pinCsn) : spiMaster {spiMaster}, pinCsn {pinCsn} {
+Spi::Spi(SpiMaster& spiMaster, uint8_t pinCsn, SpiMaster::Client client) : spiMaster {spiMaster}, pinCsn {pinCsn}, client {client} {
   nrf_gpio_cfg_output(pinCsn);
   nrf_gpio_pin_set(pinCsn);
 }
 
-bool Spi::Write(const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook) {
-  return spiMaster.Write(pinCsn, data, size, preTransactionHook);
+bool Spi::Write(const uint8_t* data,
+                size_t size,
+                const std::function<void()>& preTransactionHook,
+                SpiMaster::TransferCompleteCallback onTransferComplete,
+                void* context) {
+  return spiMaster.Write(client, pinCsn, data, size, preTransactionHook, onTransferComplete, context);
 }
 
 bool Spi::Read(uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize) {
-  return spiMaster.Read(pinCsn, cmd, cmdSize, data, dataSize);
+  return spiMaster.Read(client, pinCsn, cmd, cmdSize, data, dataSize);
 }
 
 void Spi::Sleep() {
@@ -23,7 +27,16 @@ void Spi::Sleep() {
 }
 
 bool Spi::WriteCmdAndBuffer(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize) {
-  return spiMaster.WriteCmdAndBuffer(pinCsn, cmd, cmdSize, data, dataSize);
+  return spiMaster.WriteCmdAndBuffer(client, pinCsn, cmd, cmdSize, data, dataSize);
+}
+
+bool Spi::Transfer(const SpiMaster::Segment* segments,
+                   size_t nbSegments,
+                   const std::function<void()>& preTransactionHook,
+                   bool waitForCompletion,
+                   SpiMaster::TransferCompleteCallback onTransferComplete,
+                   void* context) {
+  return spiMaster.Transfer(client, pinCsn, segments, nbSegments, preTransactionHook, waitForCompletion, onTransferComplete, context);
 }
 
 bool Spi::Init() {
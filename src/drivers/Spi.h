@@ -8,22 +8,33 @@ namespace Pinetime {
   namespace Drivers {
     class Spi {
     public:
-      Spi(SpiMaster& spiMaster, uint8_t pinCsn);
+      Spi(SpiMaster& spiMaster, uint8_t pinCsn, SpiMaster::Client client);
       Spi(const Spi&) = delete;
       Spi& operator=(const Spi&) = delete;
       Spi(Spi&&) = delete;
       Spi& operator=(Spi&&) = delete;
 
       bool Init();
-      bool Write(const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook);
+      bool Write(const uint8_t* data,
+                 size_t size,
+                 const std::function<void()>& preTransactionHook,
+                 SpiMaster::TransferCompleteCallback onTransferComplete = nullptr,
+                 void* context = nullptr);
       bool Read(uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize);
       bool WriteCmdAndBuffer(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize);
+      bool Transfer(const SpiMaster::Segment* segments,
+                    size_t nbSegments,
+                    const std::function<void()>& preTransactionHook,
+                    bool waitForCompletion,
+                    SpiMaster::TransferCompleteCallback onTransferComplete = nullptr,
+                    void* context = nullptr);
       void Sleep();
       void Wakeup();
 
     private:
       SpiMaster& spiMaster;
       uint8_t pinCsn;
+      SpiMaster::Client client;
     };
   }
 }
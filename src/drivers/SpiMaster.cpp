@@ -3,6 +3,7 @@
 #include <hal/nrf_spim.h>
 #include <nrfx_log.h>
 #include <algorithm>
+#include "drivers/ProfilingTimer.h"
 
 using namespace Pinetime::Drivers;
 
@@ -10,9 +11,11 @@ SpiMaster::SpiMaster(const SpiMaster::SpiModule spi, const SpiMaster::Parameters
 }
 
 bool SpiMaster::Init() {
-  if (mutex == nullptr) {
-    mutex = xSemaphoreCreateBinary();
-    ASSERT(mutex != nullptr);
+  for (auto& grant : grants) {
+    if (grant == nullptr) {
+      grant = xSemaphoreCreateBinary();
+      ASSERT(grant != nullptr);
+    }
   }
 
   /* Configure GPIO pins used for pselsck, pselmosi, pselmiso and pselss for SPI0 */
@@ -90,7 +93,6 @@ bool SpiMaster::Init() {
   NRFX_IRQ_PRIORITY_SET(SPIM0_SPIS0_TWIM0_TWIS0_SPI0_TWI0_IRQn, 2);
   NRFX_IRQ_ENABLE(SPIM0_SPIS0_TWIM0_TWIS0_SPI0_TWI0_IRQn);
 
-  xSemaphoreGive(mutex);
   return true;
 }
 
@@ -136,25 +138,37 @@ void SpiMaster::DisableWorkaroundForErratum58() {
 }
 
 void SpiMaster::OnEndEvent() {
-  if (currentBufferAddr == 0) {
+  if (!transferInProgress) {
     return;
   }
 
-  auto s = currentBufferSize;
-  if (s > 0) {
-    auto currentSize = std::min((size_t) 255, s);
-    PrepareTx(currentBufferAddr, currentSize);
-    currentBufferAddr = currentBufferAddr + currentSize;
-    currentBufferSize = currentBufferSize - currentSize;
+  if (txRemaining > 0 || rxRemaining > 0) {
+    StartChunk();
+    return;
+  }
 
-    spiBaseAddress->TASKS_START = 1;
-  } else {
-    nrf_gpio_pin_set(this->pinCsn);
-    currentBufferAddr = 0;
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    xSemaphoreGiveFromISR(mutex, &xHigherPriorityTaskWoken);
-    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+  currentSegment = currentSegment + 1;
+  while (currentSegment < nbSegments) {
+    if (LoadSegment(currentSegment)) {
+      StartChunk();
+      return;
+    }
+    currentSegment = currentSegment + 1;
+  }
+
+  nrf_gpio_pin_set(this->pinCsn);
+  transferInProgress = false;
+  if (onTransferComplete != nullptr) {
+    onTransferComplete(onTransferCompleteContext);
+    onTransferComplete = nullptr;
   }
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  if (taskToNotify != nullptr) {
+    vTaskNotifyGiveFromISR(taskToNotify, &xHigherPriorityTaskWoken);
+    taskToNotify = nullptr;
+  }
+  ReleaseFromIsr(&xHigherPriorityTaskWoken);
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 void SpiMaster::OnStartedEvent() {
@@ -170,89 +184,171 @@ void SpiMaster::PrepareTx(const uint32_t bufferAddress, const size_t size) {
   spiBaseAddress->EVENTS_END = 0;
 }
 
-void SpiMaster::PrepareRx(const uint32_t bufferAddress, const size_t size) {
-  spiBaseAddress->TXD.PTR = 0;
-  spiBaseAddress->TXD.MAXCNT = 0;
-  spiBaseAddress->TXD.LIST = 0;
-  spiBaseAddress->RXD.PTR = bufferAddress;
-  spiBaseAddress->RXD.MAXCNT = size;
-  spiBaseAddress->RXD.LIST = 0;
+bool SpiMaster::LoadSegment(size_t index) {
+  const Segment& segment = segments[index];
+  if (segment.txSize == 0 && segment.rxSize == 0) {
+    return false;
+  }
+  if (segment.pin != NoPin) {
+    if (segment.pinLevel) {
+      nrf_gpio_pin_set(segment.pin);
+    } else {
+      nrf_gpio_pin_clear(segment.pin);
+    }
+  }
+
+  if (segment.stream != nullptr) {
+    // StartChunk() points EasyDMA to each chunk returned by the stream
+    spiBaseAddress->TXD.LIST = 0;
+    spiBaseAddress->RXD.PTR = 0;
+    spiBaseAddress->RXD.LIST = 0;
+    txRemaining = segment.txSize;
+    rxRemaining = 0;
+    nextStreamChunk = segment.stream(segment.streamContext, std::min(StreamChunkSize, segment.txSize));
+    return true;
+  }
+
+  // In ArrayList mode, EasyDMA advances PTR by MAXCNT after each transaction,
+  // so the following chunks of the same segment only need a new MAXCNT.
+  spiBaseAddress->TXD.PTR = reinterpret_cast<uint32_t>(segment.txData);
+  spiBaseAddress->TXD.LIST = SPIM_TXD_LIST_LIST_ArrayList << SPIM_TXD_LIST_LIST_Pos;
+  spiBaseAddress->RXD.PTR = reinterpret_cast<uint32_t>(segment.rxData);
+  spiBaseAddress->RXD.LIST = SPIM_RXD_LIST_LIST_ArrayList << SPIM_RXD_LIST_LIST_Pos;
+  txRemaining = segment.txSize;
+  rxRemaining = segment.rxSize;
+  return true;
+}
+
+void SpiMaster::StartChunk() {
+  const Segment& segment = segments[currentSegment];
+  if (segment.stream != nullptr) {
+    size_t txChunk = std::min(StreamChunkSize, static_cast<size_t>(txRemaining));
+    spiBaseAddress->TXD.PTR = reinterpret_cast<uint32_t>(nextStreamChunk);
+    spiBaseAddress->TXD.MAXCNT = txChunk;
+    spiBaseAddress->RXD.MAXCNT = 0;
+    txRemaining = txRemaining - txChunk;
+
+    spiBaseAddress->EVENTS_END = 0;
+    spiBaseAddress->TASKS_START = 1;
+
+    if (txRemaining > 0) {
+      nextStreamChunk = segment.stream(segment.streamContext, std::min(StreamChunkSize, static_cast<size_t>(txRemaining)));
+    }
+    return;
+  }
+
+  size_t txChunk = std::min(maxChunkSize, static_cast<size_t>(txRemaining));
+  size_t rxChunk = std::min(maxChunkSize, static_cast<size_t>(rxRemaining));
+  spiBaseAddress->TXD.MAXCNT = txChunk;
+  spiBaseAddress->RXD.MAXCNT = rxChunk;
+  txRemaining = txRemaining - txChunk;
+  rxRemaining = rxRemaining - rxChunk;
+
   spiBaseAddress->EVENTS_END = 0;
+  spiBaseAddress->TASKS_START = 1;
 }
 
-bool SpiMaster::Write(uint8_t pinCsn, const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook) {
-  if (data == nullptr)
+bool SpiMaster::Transfer(Client client,
+                         uint8_t pinCsn,
+                         const Segment* segments,
+                         size_t nbSegments,
+                         const std::function<void()>& preTransactionHook,
+                         bool waitForCompletion,
+                         TransferCompleteCallback onTransferComplete,
+                         void* context) {
+  if (segments == nullptr || nbSegments == 0 || nbSegments > MaxSegments) {
     return false;
-  auto ok = xSemaphoreTake(mutex, portMAX_DELAY);
-  ASSERT(ok == true);
+  }
+  size_t nbBytes = 0;
+  for (size_t i = 0; i < nbSegments; i++) {
+    nbBytes += std::max(segments[i].txSize, segments[i].rxSize);
+  }
+  Acquire(client, nbBytes);
 
   this->pinCsn = pinCsn;
+  DisableWorkaroundForErratum58();
 
-  if (size == 1) {
-    SetupWorkaroundForErratum58();
-  } else {
-    DisableWorkaroundForErratum58();
+  std::copy(segments, segments + nbSegments, this->segments);
+  this->nbSegments = nbSegments;
+  currentSegment = 0;
+  while (currentSegment < nbSegments && !LoadSegment(currentSegment)) {
+    currentSegment = currentSegment + 1;
+  }
+  if (currentSegment == nbSegments) {
+    Release();
+    if (onTransferComplete != nullptr) {
+      onTransferComplete(context);
+    }
+    return true;
   }
 
   if (preTransactionHook != nullptr) {
     preTransactionHook();
   }
-  nrf_gpio_pin_clear(this->pinCsn);
-
-  currentBufferAddr = (uint32_t) data;
-  currentBufferSize = size;
-
-  auto currentSize = std::min((size_t) 255, (size_t) currentBufferSize);
-  PrepareTx(currentBufferAddr, currentSize);
-  currentBufferSize = currentBufferSize - currentSize;
-  currentBufferAddr = currentBufferAddr + currentSize;
-  spiBaseAddress->TASKS_START = 1;
 
-  if (size == 1) {
-    while (spiBaseAddress->EVENTS_END == 0)
-      ;
-    nrf_gpio_pin_set(this->pinCsn);
-    currentBufferAddr = 0;
-
-    DisableWorkaroundForErratum58();
+  taskToNotify = waitForCompletion ? xTaskGetCurrentTaskHandle() : nullptr;
+  this->onTransferComplete = onTransferComplete;
+  onTransferCompleteContext = context;
+  transferInProgress = true;
+  nrf_gpio_pin_clear(this->pinCsn);
+  StartChunk();
 
-    xSemaphoreGive(mutex);
+  if (waitForCompletion) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
   }
-
   return true;
 }
 
-bool SpiMaster::Read(uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize) {
-  xSemaphoreTake(mutex, portMAX_DELAY);
+bool SpiMaster::Write(Client client,
+                      uint8_t pinCsn,
+                      const uint8_t* data,
+                      size_t size,
+                      const std::function<void()>& preTransactionHook,
+                      TransferCompleteCallback onTransferComplete,
+                      void* context) {
+  if (data == nullptr)
+    return false;
 
-  this->pinCsn = pinCsn;
-  DisableWorkaroundForErratum58();
-  spiBaseAddress->INTENCLR = (1 << 6);
-  spiBaseAddress->INTENCLR = (1 << 1);
-  spiBaseAddress->INTENCLR = (1 << 19);
+  if (size != 1) {
+    const Segment segment {data, size, nullptr, 0};
+    return Transfer(client, pinCsn, &segment, 1, preTransactionHook, false, onTransferComplete, context);
+  }
 
-  nrf_gpio_pin_clear(this->pinCsn);
+  Acquire(client, size);
 
-  currentBufferAddr = 0;
-  currentBufferSize = 0;
+  this->pinCsn = pinCsn;
+  SetupWorkaroundForErratum58();
 
-  PrepareTx((uint32_t) cmd, cmdSize);
-  spiBaseAddress->TASKS_START = 1;
-  while (spiBaseAddress->EVENTS_END == 0)
-    ;
+  if (preTransactionHook != nullptr) {
+    preTransactionHook();
+  }
+  nrf_gpio_pin_clear(this->pinCsn);
 
-  PrepareRx((uint32_t) data, dataSize);
+  PrepareTx(reinterpret_cast<uint32_t>(data), size);
   spiBaseAddress->TASKS_START = 1;
 
   while (spiBaseAddress->EVENTS_END == 0)
     ;
   nrf_gpio_pin_set(this->pinCsn);
 
-  xSemaphoreGive(mutex);
+  DisableWorkaroundForErratum58();
+
+  Release();
 
+  if (onTransferComplete != nullptr) {
+    onTransferComplete(context);
+  }
   return true;
 }
 
+bool SpiMaster::Read(Client client, uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize) {
+  const Segment segments[] = {
+    {cmd, cmdSize, nullptr, 0},
+    {nullptr, 0, data, dataSize},
+  };
+  return Transfer(client, pinCsn, segments, 2, nullptr, true);
+}
+
 void SpiMaster::Sleep() {
   while (spiBaseAddress->ENABLE != 0) {
     spiBaseAddress->ENABLE = (SPIM_ENABLE_ENABLE_Disabled << SPIM_ENABLE_ENABLE_Pos);
@@ -269,33 +365,129 @@ void SpiMaster::Wakeup() {
   NRF_LOG_INFO("[SPIMASTER] Wakeup");
 }
 
-bool SpiMaster::WriteCmdAndBuffer(uint8_t pinCsn, const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize) {
-  xSemaphoreTake(mutex, portMAX_DELAY);
+bool SpiMaster::WriteCmdAndBuffer(Client client,
+                                  uint8_t pinCsn,
+                                  const uint8_t* cmd,
+                                  size_t cmdSize,
+                                  const uint8_t* data,
+                                  size_t dataSize) {
+  const Segment segments[] = {
+    {cmd, cmdSize, nullptr, 0},
+    {data, dataSize, nullptr, 0},
+  };
+  return Transfer(client, pinCsn, segments, 2, nullptr, true);
+}
 
-  this->pinCsn = pinCsn;
-  DisableWorkaroundForErratum58();
-  spiBaseAddress->INTENCLR = (1 << 6);
-  spiBaseAddress->INTENCLR = (1 << 1);
-  spiBaseAddress->INTENCLR = (1 << 19);
+SpiMaster::ClientStats SpiMaster::GetStats(Client client) const {
+  const auto& c = counters[static_cast<size_t>(client)];
+  return {.nbTransfers = c.nbTransfers,
+          .bytes = c.bytes,
+          .busyTimeUs = c.busyTimeUs,
+          .waitTimeUs = c.waitTimeUs,
+          .maxWaitTimeUs = c.maxWaitTimeUs,
+          .nbPriorityGrants = c.nbPriorityGrants};
+}
 
-  nrf_gpio_pin_clear(this->pinCsn);
+/*
 
-  currentBufferAddr = 0;
-  currentBufferSize = 0;
+    ----------- Arbitration of the bus -----------
 
-  PrepareTx((uint32_t) cmd, cmdSize);
-  spiBaseAddress->TASKS_START = 1;
-  while (spiBaseAddress->EVENTS_END == 0)
-    ;
+*/
+// Returns once the bus is given to the client. The counters of a client are only updated while it holds the bus.
+// In the profiled builds, the profiling timer runs from the request to the release of the bus.
+void SpiMaster::Acquire(Client client, size_t nbBytes) {
+  const auto index = static_cast<size_t>(client);
+  uint32_t requestTime = 0;
+  if constexpr (IsProfiled) {
+    ProfilingTimer::Start();
+    requestTime = ProfilingTimer::NowUs();
+  }
+  bool isGranted = false;
+  taskENTER_CRITICAL();
+  if (!isBusy) {
+    isBusy = true;
+    owner = index;
+    isGranted = true;
+  } else {
+    nbWaiting[index]++;
+  }
+  taskEXIT_CRITICAL();
 
-  PrepareTx((uint32_t) data, dataSize);
-  spiBaseAddress->TASKS_START = 1;
+  if (!isGranted) {
+    // Given by the previous owner, which has already set owner
+    xSemaphoreTake(grants[index], portMAX_DELAY);
+  }
 
-  while (spiBaseAddress->EVENTS_END == 0)
-    ;
-  nrf_gpio_pin_set(this->pinCsn);
+  if constexpr (IsProfiled) {
+    auto& c = counters[index];
+    const uint32_t waitTimeUs = ProfilingTimer::ElapsedUs(requestTime);
+    c.nbTransfers++;
+    c.bytes += nbBytes;
+    c.waitTimeUs += waitTimeUs;
+    c.maxWaitTimeUs = std::max(c.maxWaitTimeUs, waitTimeUs);
+    grantTime = ProfilingTimer::NowUs();
+  }
+}
 
-  xSemaphoreGive(mutex);
+// Called in a critical section. Returns the semaphore of the next owner, to give once out of the critical section, or
+// nullptr if the bus is free.
+SemaphoreHandle_t SpiMaster::SelectNextOwner() {
+  if constexpr (IsProfiled) {
+    counters[owner].busyTimeUs += ProfilingTimer::ElapsedUs(grantTime);
+  }
 
-  return true;
+  size_t first = NbClients;
+  size_t last = NbClients;
+  for (size_t i = 0; i < NbClients; i++) {
+    if (nbWaiting[i] > 0) {
+      first = std::min(first, i);
+      last = i;
+    }
+  }
+  if (first == NbClients) {
+    isBusy = false;
+    nbPriorityGrantsInRow = 0;
+    return nullptr;
+  }
+
+  size_t next = first;
+  if (first == last) {
+    nbPriorityGrantsInRow = 0;
+  } else if (nbPriorityGrantsInRow < maxPriorityGrantsInRow) {
+    nbPriorityGrantsInRow++;
+    if constexpr (IsProfiled) {
+      counters[first].nbPriorityGrants++;
+    }
+  } else {
+    // Don't starve the client of lowest priority
+    next = last;
+    nbPriorityGrantsInRow = 0;
+  }
+  nbWaiting[next]--;
+  owner = next;
+  return grants[next];
+}
+
+void SpiMaster::Release() {
+  taskENTER_CRITICAL();
+  SemaphoreHandle_t grant = SelectNextOwner();
+  taskEXIT_CRITICAL();
+  if constexpr (IsProfiled) {
+    ProfilingTimer::Stop();
+  }
+  if (grant != nullptr) {
+    xSemaphoreGive(grant);
+  }
+}
+
+void SpiMaster::ReleaseFromIsr(BaseType_t* higherPriorityTaskWoken) {
+  UBaseType_t interruptStatus = taskENTER_CRITICAL_FROM_ISR();
+  SemaphoreHandle_t grant = SelectNextOwner();
+  taskEXIT_CRITICAL_FROM_ISR(interruptStatus);
+  if constexpr (IsProfiled) {
+    ProfilingTimer::Stop();
+  }
+  if (grant != nullptr) {
+    xSemaphoreGiveFromISR(grant, higherPriorityTaskWoken);
+  }
 }
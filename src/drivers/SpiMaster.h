@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -9,8 +10,16 @@
 #include "nrfx_gpiote.h"
 #include "nrf_ppi.h"
 
+#ifndef FRAME_PROFILER_ENABLED
+  #define FRAME_PROFILER_ENABLED 0
+#endif
+
 namespace Pinetime {
   namespace Drivers {
+    // The devices sharing the bus are its clients. Each transfer holds the bus from its start to its end. When the bus is
+    // released, it is given to the waiting client of highest priority, whatever the priority of the calling tasks, so that
+    // a display strip only waits for the flash transaction in progress (at most one page). A client of lower priority is
+    // served after at most maxPriorityGrantsInRow transfers of higher priority clients.
     class SpiMaster {
     public:
       enum class SpiModule : uint8_t { SPI0, SPI1 };
@@ -27,6 +36,51 @@ namespace Pinetime {
         uint8_t pinMISO;
       };
 
+      // In decreasing order of priority
+      enum class Client : uint8_t { Display, Flash };
+      static constexpr size_t NbClients = 2;
+
+      static constexpr uint8_t NoPin = 0xff;
+
+      // Called from the SPI interrupt to produce the next size bytes (at most StreamChunkSize) of a streamed segment. The next
+      // chunk is produced while the previous one is sent: the returned data must stay valid until the call after the next one.
+      using StreamCallback = const uint8_t* (*) (void* context, size_t size);
+      // Even, so that the 16 bit words of a stream are never split between two chunks
+      static constexpr size_t StreamChunkSize = 254;
+
+      // One step of a chip-select transaction: txSize bytes are clocked out of txData while
+      // rxSize bytes are clocked into rxData. Either side may be empty.
+      // If pin is set, it is driven to pinLevel before the segment starts (e.g. the data/command pin of the display), so
+      // that a command and its parameters can be sent in one transaction.
+      // If stream is set, the txSize bytes sent are produced by stream instead of being read from txData (e.g. pixels
+      // converted on the fly), and nothing is received.
+      struct Segment {
+        const uint8_t* txData;
+        size_t txSize;
+        uint8_t* rxData;
+        size_t rxSize;
+        uint8_t pin = NoPin;
+        bool pinLevel = false;
+        StreamCallback stream = nullptr;
+        void* streamContext = nullptr;
+      };
+
+      static constexpr size_t MaxSegments = 6;
+
+      // Since boot, in the builds with the frame profiler only (zero otherwise). The durations are measured in µs with the
+      // profiling timer (see ProfilingTimer), the sums wrap after 71 minutes.
+      struct __attribute__((packed)) ClientStats {
+        uint32_t nbTransfers;
+        uint32_t bytes;     // Clocked on the bus
+        uint32_t busyTimeUs; // Bus held by the client
+        uint32_t waitTimeUs; // Waiting for the bus
+        uint32_t maxWaitTimeUs;
+        uint32_t nbPriorityGrants; // Bus given to the client while a client of lower priority was waiting
+      };
+
+      // Called from the SPI interrupt once the last byte of a transfer is on the wire
+      using TransferCompleteCallback = void (*)(void* context);
+
       SpiMaster(const SpiModule spi, const Parameters& params);
       SpiMaster(const SpiMaster&) = delete;
       SpiMaster& operator=(const SpiMaster&) = delete;
@@ -34,10 +88,28 @@ namespace Pinetime {
       SpiMaster& operator=(SpiMaster&&) = delete;
 
       bool Init();
-      bool Write(uint8_t pinCsn, const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook);
-      bool Read(uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize);
+      bool Write(Client client,
+                 uint8_t pinCsn,
+                 const uint8_t* data,
+                 size_t size,
+                 const std::function<void()>& preTransactionHook,
+                 TransferCompleteCallback onTransferComplete = nullptr,
+                 void* context = nullptr);
+      bool Read(Client client, uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize);
+
+      bool WriteCmdAndBuffer(Client client, uint8_t pinCsn, const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize);
 
-      bool WriteCmdAndBuffer(uint8_t pinCsn, const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize);
+      // Runs all the segments back to back with the chip select held low. The whole list is driven
+      // from the END interrupt. If waitForCompletion is true, the calling task sleeps until the last
+      // segment is done, otherwise the buffers must stay valid until the bus is released.
+      bool Transfer(Client client,
+                    uint8_t pinCsn,
+                    const Segment* segments,
+                    size_t nbSegments,
+                    const std::function<void()>& preTransactionHook,
+                    bool waitForCompletion,
+                    TransferCompleteCallback onTransferComplete = nullptr,
+                    void* context = nullptr);
 
       void OnStartedEvent();
       void OnEndEvent();
@@ -45,11 +117,18 @@ namespace Pinetime {
       void Sleep();
       void Wakeup();
 
+      ClientStats GetStats(Client client) const;
+
     private:
       void SetupWorkaroundForErratum58();
       void DisableWorkaroundForErratum58();
       void PrepareTx(const volatile uint32_t bufferAddress, const volatile size_t size);
-      void PrepareRx(const volatile uint32_t bufferAddress, const volatile size_t size);
+      bool LoadSegment(size_t index);
+      void StartChunk();
+      void Acquire(Client client, size_t nbBytes);
+      void Release();
+      void ReleaseFromIsr(BaseType_t* higherPriorityTaskWoken);
+      SemaphoreHandle_t SelectNextOwner();
 
       NRF_SPIM_Type* spiBaseAddress;
       uint8_t pinCsn;
@@ -57,9 +136,44 @@ namespace Pinetime {
       SpiMaster::SpiModule spi;
       SpiMaster::Parameters params;
 
-      volatile uint32_t currentBufferAddr = 0;
-      volatile size_t currentBufferSize = 0;
-      SemaphoreHandle_t mutex = nullptr;
+      // EasyDMA MAXCNT registers are 8 bits wide on the nRF52832
+      static constexpr size_t maxChunkSize = 255;
+
+      Segment segments[MaxSegments];
+      volatile size_t nbSegments = 0;
+      volatile size_t currentSegment = 0;
+      volatile size_t txRemaining = 0;
+      volatile size_t rxRemaining = 0;
+      volatile bool transferInProgress = false;
+      TaskHandle_t taskToNotify = nullptr;
+      TransferCompleteCallback onTransferComplete = nullptr;
+      void* onTransferCompleteContext = nullptr;
+      // Next chunk of the streamed segment in progress, produced while the current one is sent
+      const uint8_t* nextStreamChunk = nullptr;
+
+      // The occupancy of the bus is only measured in the builds with the frame profiler: the profiling timer keeps the HF
+      // clock on and is read with the interrupts disabled
+      static constexpr bool IsProfiled = FRAME_PROFILER_ENABLED != 0;
+
+      // Arbitration, see Acquire()
+      static constexpr uint8_t maxPriorityGrantsInRow = 4;
+
+      struct Counters {
+        uint32_t nbTransfers;
+        uint32_t bytes;
+        uint32_t busyTimeUs;
+        uint32_t waitTimeUs;
+        uint32_t maxWaitTimeUs;
+        uint32_t nbPriorityGrants;
+      };
+
+      std::array<SemaphoreHandle_t, NbClients> grants {};
+      std::array<uint8_t, NbClients> nbWaiting {};
+      std::array<Counters, NbClients> counters {};
+      bool isBusy = false;
+      size_t owner = 0;
+      uint8_t nbPriorityGrantsInRow = 0;
+      uint32_t grantTime = 0;
       static constexpr nrf_ppi_channel_t workaroundPpi = NRF_PPI_CHANNEL0;
       bool workaroundActive = false;
     };
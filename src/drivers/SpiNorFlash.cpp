@@ -1,4 +1,5 @@
 #include "drivers/SpiNorFlash.h"
+#include <algorithm>
 #include <hal/nrf_gpio.h>
 #include <libraries/delay/nrf_delay.h>
 #include <libraries/log/nrf_log.h>
@@ -10,6 +11,9 @@ SpiNorFlash::SpiNorFlash(Spi& spi) : spi {spi} {
 }
 
 void SpiNorFlash::Init() {
+  if (mutex == nullptr) {
+    mutex = xSemaphoreCreateMutex();
+  }
   device_id = ReadIdentification();
   NRF_LOG_INFO("[SpiNorFlash] Manufacturer : %d, Memory type : %d, memory density : %d",
                device_id.manufacturer,
@@ -21,8 +25,11 @@ void SpiNorFlash::Uninit() {
 }
 
 void SpiNorFlash::Sleep() {
-  auto cmd = static_cast<uint8_t>(Commands::DeepPowerDown);
-  spi.Write(&cmd, sizeof(uint8_t), nullptr);
+  Lock();
+  // The flash ignores the deep power down command while it erases or programs
+  WaitForIdle();
+  SendCommand(Commands::DeepPowerDown);
+  Unlock();
   NRF_LOG_INFO("[SpiNorFlash] Sleep")
 }
 
@@ -31,8 +38,10 @@ void SpiNorFlash::Wakeup() {
   static constexpr uint8_t cmdSize = 4;
   uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::ReleaseFromDeepPowerDown), 0x01, 0x02, 0x03};
   uint8_t id = 0;
+  Lock();
   spi.Read(reinterpret_cast<uint8_t*>(&cmd), cmdSize, &id, 1);
   auto devId = device_id = ReadIdentification();
+  Unlock();
   if (devId.type != device_id.type) {
     NRF_LOG_INFO("[SpiNorFlash] ID on Wakeup: Failed");
   } else {
@@ -72,11 +81,26 @@ uint8_t SpiNorFlash::ReadConfigurationRegister() {
 
 void SpiNorFlash::Read(uint32_t address, uint8_t* buffer, size_t size) {
   static constexpr uint8_t cmdSize = 4;
-  uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::Read),
-                          static_cast<uint8_t>(address >> 16U),
-                          static_cast<uint8_t>(address >> 8U),
-                          static_cast<uint8_t>(address)};
-  spi.Read(reinterpret_cast<uint8_t*>(&cmd), cmdSize, buffer, size);
+  Lock();
+  bool isEraseSuspended = SuspendForRead(address, size);
+  // One transaction per page, so that the display can take the bus in between (see SpiMaster)
+  while (size > 0) {
+    uint32_t pageLimit = (address & ~(pageSize - 1u)) + pageSize;
+    size_t toRead = std::min(size, static_cast<size_t>(pageLimit - address));
+    uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::Read),
+                            static_cast<uint8_t>(address >> 16U),
+                            static_cast<uint8_t>(address >> 8U),
+                            static_cast<uint8_t>(address)};
+    spi.Read(reinterpret_cast<uint8_t*>(&cmd), cmdSize, buffer, toRead);
+    address += toRead;
+    buffer += toRead;
+    size -= toRead;
+  }
+  if (isEraseSuspended) {
+    SendCommand(Commands::EraseResume);
+    lastResume = xTaskGetTickCount();
+  }
+  Unlock();
 }
 
 void SpiNorFlash::WriteEnable() {
@@ -91,14 +115,16 @@ void SpiNorFlash::SectorErase(uint32_t sectorAddress) {
                           static_cast<uint8_t>(sectorAddress >> 8U),
                           static_cast<uint8_t>(sectorAddress)};
 
+  Lock();
+  WaitForIdle();
   WriteEnable();
   while (!WriteEnabled())
     vTaskDelay(1);
 
   spi.Read(reinterpret_cast<uint8_t*>(&cmd), cmdSize, nullptr, 0);
 
-  while (WriteInProgress())
-    vTaskDelay(1);
+  WaitForOperation(StartOperation(Operation::Erase, sectorAddress));
+  Unlock();
 }
 
 uint8_t SpiNorFlash::ReadSecurityRegister() {
@@ -131,14 +157,16 @@ void SpiNorFlash::Write(uint32_t address, const uint8_t* buffer, size_t size) {
                             static_cast<uint8_t>(addr >> 8U),
                             static_cast<uint8_t>(addr)};
 
+    Lock();
+    WaitForIdle();
     WriteEnable();
     while (!WriteEnabled())
       vTaskDelay(1);
 
     spi.WriteCmdAndBuffer(cmd, cmdSize, b, toWrite);
 
-    while (WriteInProgress())
-      vTaskDelay(1);
+    WaitForOperation(StartOperation(Operation::Program, addr));
+    Unlock();
 
     addr += toWrite;
     b += toWrite;
@@ -149,3 +177,77 @@ void SpiNorFlash::Write(uint32_t address, const uint8_t* buffer, size_t size) {
 SpiNorFlash::Identification SpiNorFlash::GetIdentification() const {
   return device_id;
 }
+
+/*
+
+    ----------- Scheduling of the erases and programs -----------
+
+*/
+void SpiNorFlash::Lock() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void SpiNorFlash::Unlock() {
+  xSemaphoreGive(mutex);
+}
+
+void SpiNorFlash::SendCommand(Commands command) {
+  auto cmd = static_cast<uint8_t>(command);
+  spi.Read(&cmd, sizeof(cmd), nullptr, 0);
+}
+
+// The functions below are called with the lock held
+bool SpiNorFlash::IsIdle() {
+  if (operation != Operation::None && !WriteInProgress()) {
+    operation = Operation::None;
+  }
+  return operation == Operation::None;
+}
+
+uint32_t SpiNorFlash::StartOperation(Operation newOperation, uint32_t address) {
+  operation = newOperation;
+  operationAddress = address;
+  return ++operationCount;
+}
+
+// Waits for the operation in progress, started by any task
+void SpiNorFlash::WaitForIdle() {
+  while (!IsIdle()) {
+    Unlock();
+    vTaskDelay(1);
+    Lock();
+  }
+}
+
+// Waits for the operation started by the caller: another task may have seen it complete and started its own meanwhile
+void SpiNorFlash::WaitForOperation(uint32_t id) {
+  while (id == operationCount && !IsIdle()) {
+    Unlock();
+    vTaskDelay(1);
+    Lock();
+  }
+}
+
+// Returns true if an erase was suspended, the caller then resumes it after the read
+bool SpiNorFlash::SuspendForRead(uint32_t address, size_t size) {
+  while (!IsIdle()) {
+    // The content of the sector being erased is undefined until the end of the erase, and page programs are short
+    bool isInErasedSector = address < operationAddress + sectorSize && address + size > operationAddress;
+    if (operation == Operation::Erase && !isInErasedSector && xTaskGetTickCount() - lastResume >= minEraseTicks) {
+      SendCommand(Commands::EraseSuspend);
+      // The flash reports it is idle once the erase is suspended (tSUS, a few tens of µs). A chip that ignores the
+      // command keeps erasing: it is resumed in case it suspended late, and the read waits like for a program.
+      for (uint8_t poll = 0; poll < maxSuspendPolls; poll++) {
+        if (!WriteInProgress()) {
+          return true;
+        }
+      }
+      SendCommand(Commands::EraseResume);
+      lastResume = xTaskGetTickCount();
+    }
+    Unlock();
+    vTaskDelay(1);
+    Lock();
+  }
+  return false;
+}
@@ -1,11 +1,18 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <FreeRTOS.h>
+#include <semphr.h>
 
 namespace Pinetime {
   namespace Drivers {
     class Spi;
 
+    // Erases and page programs run in the background of the flash: the task that starts one waits for it without holding
+    // the driver, so that the other tasks can still read. A read suspends an erase in progress (erase suspend, about
+    // 30 µs) rather than waiting for it (up to 300 ms), unless it reads the sector being erased.
+    // The display doesn't need to suspend anything: it shares the SPI bus, not the chip, and the bus is free while the
+    // flash erases.
     class SpiNorFlash {
     public:
       explicit SpiNorFlash(Spi& spi);
@@ -41,6 +48,8 @@ namespace Pinetime {
       void Wakeup();
 
     private:
+      enum class Operation : uint8_t { None, Erase, Program };
+
       Identification ReadIdentification();
 
       enum class Commands : uint8_t {
@@ -51,14 +60,36 @@ namespace Pinetime {
         ReadConfigurationRegister = 0x15,
         SectorErase = 0x20,
         ReadSecurityRegister = 0x2B,
+        EraseSuspend = 0x75,
+        EraseResume = 0x7A,
         ReadIdentification = 0x9F,
         ReleaseFromDeepPowerDown = 0xAB,
         DeepPowerDown = 0xB9
       };
       static constexpr uint16_t pageSize = 256;
+      static constexpr uint32_t sectorSize = 0x1000;
+      // An erase isn't suspended again less than this after it was resumed, so that a stream of reads can't starve it
+      static constexpr TickType_t minEraseTicks = 1;
+      // Reads of the status register (a few µs each) before giving up on an erase suspend
+      static constexpr uint8_t maxSuspendPolls = 32;
 
       Spi& spi;
       Identification device_id;
+
+      SemaphoreHandle_t mutex = nullptr;
+      Operation operation = Operation::None;
+      uint32_t operationAddress = 0;
+      uint32_t operationCount = 0; // Identifies the operation in progress
+      TickType_t lastResume = 0;
+
+      void Lock();
+      void Unlock();
+      bool IsIdle();
+      void WaitForIdle();
+      void WaitForOperation(uint32_t id);
+      uint32_t StartOperation(Operation newOperation, uint32_t address);
+      bool SuspendForRead(uint32_t address, size_t size);
+      void SendCommand(Commands command);
     };
   }
 }
@@ -237,11 +237,6 @@ void St7789::SetAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
   WriteData(addrWindowArgs, sizeof(addrWindowArgs));
 }
 
-void St7789::WriteToRam(const uint8_t* data, size_t size) {
-  WriteCommand(static_cast<uint8_t>(Commands::WriteToRam));
-  WriteData(data, size);
-}
-
 void St7789::SetVdv() {
   // By default there is a large step from pixel brightness zero to one.
   // After experimenting with VCOMS, VRH and VDV, this was found to produce good results.
@@ -267,9 +262,68 @@ void St7789::VerticalScrollStartAddress(uint16_t line) {
 void St7789::Uninit() {
 }
 
-void St7789::DrawBuffer(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* data, size_t size) {
-  SetAddrWindow(x, y, x + width - 1, y + height - 1);
-  WriteToRam(data, size);
+St7789::DrawCommands& St7789::NextDrawCommands(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+  const uint16_t x1 = x + width - 1;
+  const uint16_t y1 = y + height - 1;
+  auto& commands = drawCommands[drawCommandsIndex];
+  drawCommandsIndex ^= 1;
+  commands.columnAddressSet = static_cast<uint8_t>(Commands::ColumnAddressSet);
+  commands.columnArgs[0] = static_cast<uint8_t>(x >> 8);
+  commands.columnArgs[1] = static_cast<uint8_t>(x);
+  commands.columnArgs[2] = static_cast<uint8_t>(x1 >> 8);
+  commands.columnArgs[3] = static_cast<uint8_t>(x1);
+  commands.rowAddressSet = static_cast<uint8_t>(Commands::RowAddressSet);
+  commands.rowArgs[0] = static_cast<uint8_t>(y >> 8);
+  commands.rowArgs[1] = static_cast<uint8_t>(y);
+  commands.rowArgs[2] = static_cast<uint8_t>(y1 >> 8);
+  commands.rowArgs[3] = static_cast<uint8_t>(y1);
+  commands.writeToRam = static_cast<uint8_t>(Commands::WriteToRam);
+  return commands;
+}
+
+void St7789::DrawBuffer(uint16_t x,
+                        uint16_t y,
+                        uint16_t width,
+                        uint16_t height,
+                        const uint8_t* data,
+                        size_t size,
+                        DrawCompleteCallback onDrawComplete,
+                        void* context) {
+  const auto& commands = NextDrawCommands(x, y, width, height);
+
+  // One transaction, the data/command pin being switched between the segments: the bus is arbitrated once per strip
+  // instead of once per command, and the flash can't take it before the pixels.
+  const SpiMaster::Segment segments[] = {
+    {&commands.columnAddressSet, 1, nullptr, 0, pinDataCommand, false},
+    {commands.columnArgs, sizeof(commands.columnArgs), nullptr, 0, pinDataCommand, true},
+    {&commands.rowAddressSet, 1, nullptr, 0, pinDataCommand, false},
+    {commands.rowArgs, sizeof(commands.rowArgs), nullptr, 0, pinDataCommand, true},
+    {&commands.writeToRam, 1, nullptr, 0, pinDataCommand, false},
+    {data, size, nullptr, 0, pinDataCommand, true},
+  };
+  spi.Transfer(segments, sizeof(segments) / sizeof(segments[0]), nullptr, false, onDrawComplete, context);
+}
+
+void St7789::DrawStream(uint16_t x,
+                        uint16_t y,
+                        uint16_t width,
+                        uint16_t height,
+                        size_t size,
+                        PixelStreamCallback stream,
+                        void* streamContext,
+                        DrawCompleteCallback onDrawComplete,
+                        void* context) {
+  const auto& commands = NextDrawCommands(x, y, width, height);
+
+  const SpiMaster::Segment segments[] = {
+    {&commands.columnAddressSet, 1, nullptr, 0, pinDataCommand, false},
+    {commands.columnArgs, sizeof(commands.columnArgs), nullptr, 0, pinDataCommand, true},
+    {&commands.rowAddressSet, 1, nullptr, 0, pinDataCommand, false},
+    {commands.rowArgs, sizeof(commands.rowArgs), nullptr, 0, pinDataCommand, true},
+    {&commands.writeToRam, 1, nullptr, 0, pinDataCommand, false},
+    {nullptr, size, nullptr, 0, pinDataCommand, true, stream, streamContext},
+  };
+  spi.Transfer(segments, sizeof(segments) / sizeof(segments[0]), nullptr, false, onDrawComplete, context);
 }
 
 void St7789::HardwareReset() {
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -22,7 +23,32 @@ namespace Pinetime {
 
       void VerticalScrollStartAddress(uint16_t line);
 
-      void DrawBuffer(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* data, size_t size);
+      // Called from the SPI interrupt once the pixel data has been sent
+      using DrawCompleteCallback = void (*)(void* context);
+
+      // Returns as soon as the pixel transfer is started; data must remain valid until onDrawComplete is called
+      void DrawBuffer(uint16_t x,
+                      uint16_t y,
+                      uint16_t width,
+                      uint16_t height,
+                      const uint8_t* data,
+                      size_t size,
+                      DrawCompleteCallback onDrawComplete = nullptr,
+                      void* context = nullptr);
+
+      // Called from the SPI interrupt to produce the next size bytes of pixel data, see SpiMaster::StreamCallback
+      using PixelStreamCallback = const uint8_t* (*) (void* context, size_t size);
+
+      // Like DrawBuffer(), but the size bytes of pixel data are produced by stream while they are sent
+      void DrawStream(uint16_t x,
+                      uint16_t y,
+                      uint16_t width,
+                      uint16_t height,
+                      size_t size,
+                      PixelStreamCallback stream,
+                      void* streamContext,
+                      DrawCompleteCallback onDrawComplete = nullptr,
+                      void* context = nullptr);
 
       void LowPowerOn();
       void LowPowerOff();
@@ -47,7 +73,6 @@ namespace Pinetime {
       void MemoryDataAccessControl();
       void DisplayInversionOn();
       void NormalModeOn();
-      void WriteToRam(const uint8_t* data, size_t size);
       void IdleModeOn();
       void IdleModeOff();
       void FrameRateNormalSet();
@@ -60,6 +85,8 @@ namespace Pinetime {
       void PorchSet();
 
       void SetAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+      struct DrawCommands;
+      DrawCommands& NextDrawCommands(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
       void SetVdv();
       void WriteCommand(uint8_t cmd);
       void WriteCommand(const uint8_t* data, size_t size);
@@ -99,6 +126,19 @@ namespace Pinetime {
 
       uint8_t addrWindowArgs[4];
       uint8_t verticalScrollArgs[2];
+
+      // Address window and memory write sent before the pixels by DrawBuffer() and DrawStream(), in RAM for EasyDMA. They are alternated:
+      // the next ones are written while the transfer of the previous ones may still be in progress.
+      struct DrawCommands {
+        uint8_t columnAddressSet;
+        uint8_t columnArgs[4];
+        uint8_t rowAddressSet;
+        uint8_t rowArgs[4];
+        uint8_t writeToRam;
+      };
+
+      std::array<DrawCommands, 2> drawCommands;
+      uint8_t drawCommandsIndex = 0;
     };
   }
 }
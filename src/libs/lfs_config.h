@@ -42,8 +42,12 @@
 #endif
 #endif
 
-// This is required in order for the CRC implementation in littlefs/lfs_util.c to be compiled
+// Includes the default utilities of littlefs/lfs_util.h
 #undef LFS_CONFIG
 
 #undef LFS_UTIL_H
 #include <littlefs/lfs_util.h>
+
+// Defined again so that littlefs/lfs_util.c doesn't compile its CRC: lfs_crc() is implemented in components/fs/FS.cpp
+// with the lookup tables of components/crc/Crc.h
+#define LFS_CONFIG libs/lfs_config.h
@@ -23,7 +23,10 @@
  * - 16: RGB565
  * - 32: ARGB8888
  */
-#define LV_COLOR_DEPTH     16
+#ifndef LVGL_COLOR_DEPTH
+  #define LVGL_COLOR_DEPTH 16
+#endif
+#define LV_COLOR_DEPTH     LVGL_COLOR_DEPTH
 
 /* Swap the 2 bytes of RGB565 color.
  * Useful if the display has a 8 bit interface (e.g. SPI)*/
@@ -86,9 +89,9 @@ typedef int16_t lv_coord_t;
 /* Automatically defrag. on free. Defrag. means joining the adjacent free cells. */
 #define LV_MEM_AUTO_DEFRAG  1
 #else       /*LV_MEM_CUSTOM*/
-#define LV_MEM_CUSTOM_INCLUDE <FreeRTOS.h>   /*Header for the dynamic memory function*/
-#define LV_MEM_CUSTOM_ALLOC   pvPortMalloc       /*Wrapper to malloc*/
-#define LV_MEM_CUSTOM_FREE    vPortFree         /*Wrapper to free*/
+#define LV_MEM_CUSTOM_INCLUDE "displayapp/LvglArena.h"   /*Header for the dynamic memory function*/
+#define LV_MEM_CUSTOM_ALLOC   lvgl_arena_alloc       /*Wrapper to malloc*/
+#define LV_MEM_CUSTOM_FREE    lvgl_arena_free         /*Wrapper to free*/
 #endif     /*LV_MEM_CUSTOM*/
 
 /* Use the standard memcpy and memset instead of LVGL's own functions.
@@ -37,6 +37,9 @@
 #include "components/heartrate/HeartRateController.h"
 #include "components/stopwatch/StopWatchController.h"
 #include "components/fs/FS.h"
+#include "components/profiling/FrameProfiler.h"
+#include "components/history/HistoryController.h"
+#include "components/changes/ChangeNotifier.h"
 #include "drivers/Spi.h"
 #include "drivers/SpiMaster.h"
 #include "drivers/SpiNorFlash.h"
@@ -68,10 +71,10 @@ Pinetime::Drivers::SpiMaster spi {Pinetime::Drivers::SpiMaster::SpiModule::SPI0,
                                    Pinetime::PinMap::SpiMosi,
                                    Pinetime::PinMap::SpiMiso}};
 
-Pinetime::Drivers::Spi lcdSpi {spi, Pinetime::PinMap::SpiLcdCsn};
+Pinetime::Drivers::Spi lcdSpi {spi, Pinetime::PinMap::SpiLcdCsn, Pinetime::Drivers::SpiMaster::Client::Display};
 Pinetime::Drivers::St7789 lcd {lcdSpi, Pinetime::PinMap::LcdDataCommand, Pinetime::PinMap::LcdReset};
 
-Pinetime::Drivers::Spi flashSpi {spi, Pinetime::PinMap::SpiFlashCsn};
+Pinetime::Drivers::Spi flashSpi {spi, Pinetime::PinMap::SpiFlashCsn, Pinetime::Drivers::SpiMaster::Client::Flash};
 Pinetime::Drivers::SpiNorFlash spiNorFlash {flashSpi};
 
 // The TWI device should work @ up to 400Khz but there is a HW bug which prevent it from
@@ -91,25 +94,28 @@ Pinetime::Drivers::Hrs3300 heartRateSensor {twiMaster, heartRateSensorTwiAddress
 
 TimerHandle_t debounceTimer;
 TimerHandle_t debounceChargeTimer;
-Pinetime::Controllers::Battery batteryController;
-Pinetime::Controllers::Ble bleController;
+Pinetime::Controllers::ChangeNotifier changeNotifier;
+Pinetime::Controllers::Battery batteryController {changeNotifier};
+Pinetime::Controllers::Ble bleController {changeNotifier};
 
 Pinetime::Controllers::FS fs {spiNorFlash};
 Pinetime::Controllers::Settings settingsController {fs};
 Pinetime::Controllers::MotorController motorController {};
 
-Pinetime::Controllers::HeartRateController heartRateController;
+Pinetime::Controllers::HeartRateController heartRateController {changeNotifier};
 Pinetime::Applications::HeartRateTask heartRateApp(heartRateSensor, heartRateController, settingsController);
 
-Pinetime::Controllers::DateTime dateTimeController {settingsController};
+Pinetime::Controllers::DateTime dateTimeController {settingsController, changeNotifier};
 Pinetime::Drivers::Watchdog watchdog;
-Pinetime::Controllers::NotificationManager notificationManager;
-Pinetime::Controllers::MotionController motionController;
+Pinetime::Controllers::NotificationManager notificationManager {changeNotifier};
+Pinetime::Controllers::MotionController motionController {changeNotifier};
 Pinetime::Controllers::StopWatchController stopWatchController;
 Pinetime::Controllers::AlarmController alarmController {dateTimeController, fs};
 Pinetime::Controllers::TouchHandler touchHandler;
 Pinetime::Controllers::ButtonHandler buttonHandler;
 Pinetime::Controllers::BrightnessController brightnessController {};
+Pinetime::Controllers::FrameProfiler frameProfiler;
+Pinetime::Controllers::HistoryController historyController {fs, dateTimeController, motionController, heartRateController, batteryController};
 
 Pinetime::Applications::DisplayApp displayApp(lcd,
                                               touchPanel,
@@ -127,7 +133,10 @@ Pinetime::Applications::DisplayApp displayApp(lcd,
                                               brightnessController,
                                               touchHandler,
                                               fs,
-                                              spiNorFlash);
+                                              spiNorFlash,
+                                              frameProfiler,
+                                              historyController,
+                                              changeNotifier);
 
 Pinetime::System::SystemTask systemTask(spi,
                                         spiNorFlash,
@@ -149,7 +158,10 @@ Pinetime::System::SystemTask systemTask(spi,
                                         heartRateApp,
                                         fs,
                                         touchHandler,
-                                        buttonHandler);
+                                        buttonHandler,
+                                        frameProfiler,
+                                        historyController,
+                                        changeNotifier);
 int mallocFailedCount = 0;
 int stackOverflowCount = 0;
 extern "C" {
@@ -176,6 +188,11 @@ void nrfx_gpiote_evt_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action
     return;
   }
 
+  if (pin == Pinetime::PinMap::Bma421Irq) {
+    systemTask.PushMessage(Pinetime::System::Messages::OnMotionEvent);
+    return;
+  }
+
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
   if (pin == Pinetime::PinMap::PowerPresent and action == NRF_GPIOTE_POLARITY_TOGGLE) {
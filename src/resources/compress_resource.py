@@ -0,0 +1,126 @@
+#!/usr/bin/env python
+
+# Block compression of the resource files, read by CompressedFile (src/components/fs/CompressedFile.h) on the watch.
+# Blocks are compressed independently in the LZ4 block format, so that the watch can seek without decoding the whole
+# file.
+
+import struct
+
+MAGIC = b'ITZ4'
+BLOCK_SIZE = 512
+
+MIN_MATCH = 4
+# Constraints of the LZ4 block format: the last 5 bytes are literals and the last match starts 12 bytes before the end
+LAST_LITERALS = 5
+MATCH_LIMIT = 12
+MAX_OFFSET = 65535
+
+
+def _length_bytes(length: int) -> bytes:
+    out = bytearray()
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+    return bytes(out)
+
+
+def _sequence(literals: bytes, offset: int = 0, match_length: int = 0) -> bytes:
+    literal_length = len(literals)
+    match_code = match_length - MIN_MATCH if match_length else 0
+    out = bytearray([(min(literal_length, 15) << 4) | min(match_code, 15)])
+    if literal_length >= 15:
+        out += _length_bytes(literal_length - 15)
+    out += literals
+    if match_length:
+        out += struct.pack('<H', offset)
+        if match_code >= 15:
+            out += _length_bytes(match_code - 15)
+    return bytes(out)
+
+
+def compress_block(data: bytes) -> bytes:
+    """Greedy LZ4 block compression, keeping the last position of every 4 bytes sequence."""
+    size = len(data)
+    out = bytearray()
+    positions = {}
+    anchor = 0
+    pos = 0
+    while pos + MATCH_LIMIT < size:
+        key = data[pos:pos + MIN_MATCH]
+        candidate = positions.get(key)
+        positions[key] = pos
+        if candidate is None or pos - candidate > MAX_OFFSET:
+            pos += 1
+            continue
+        length = MIN_MATCH
+        while pos + length < size - LAST_LITERALS and data[candidate + length] == data[pos + length]:
+            length += 1
+        out += _sequence(data[anchor:pos], pos - candidate, length)
+        pos += length
+        anchor = pos
+    out += _sequence(data[anchor:])
+    return bytes(out)
+
+
+def decompress_block(data: bytes) -> bytes:
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        token = data[pos]
+        pos += 1
+        literal_length = token >> 4
+        if literal_length == 15:
+            while True:
+                value = data[pos]
+                pos += 1
+                literal_length += value
+                if value != 255:
+                    break
+        out += data[pos:pos + literal_length]
+        pos += literal_length
+        if pos == len(data):
+            break
+        offset = struct.unpack_from('<H', data, pos)[0]
+        pos += 2
+        match_length = token & 0x0f
+        if match_length == 15:
+            while True:
+                value = data[pos]
+                pos += 1
+                match_length += value
+                if value != 255:
+                    break
+        for _ in range(match_length + MIN_MATCH):
+            out.append(out[-offset])
+    return bytes(out)
+
+
+def compress(data: bytes, block_size: int = BLOCK_SIZE) -> bytes:
+    blocks = []
+    for start in range(0, len(data), block_size):
+        block = data[start:start + block_size]
+        compressed = compress_block(block)
+        # Blocks that don't get shorter are stored as is
+        blocks.append(compressed if len(compressed) < len(block) else block)
+
+    offsets = [0]
+    for block in blocks:
+        offsets.append(offsets[-1] + len(block))
+    header = MAGIC + struct.pack('<IHH', len(data), block_size, 0)
+    return header + struct.pack(f'<{len(offsets)}I', *offsets) + b''.join(blocks)
+
+
+def decompress(data: bytes) -> bytes:
+    if data[:4] != MAGIC:
+        return data
+    size, block_size, _ = struct.unpack_from('<IHH', data, 4)
+    nb_blocks = (size + block_size - 1) // block_size
+    offsets = struct.unpack_from(f'<{nb_blocks + 1}I', data, 12)
+    start = 12 + 4 * (nb_blocks + 1)
+    out = bytearray()
+    for index in range(nb_blocks):
+        block = data[start + offsets[index]:start + offsets[index + 1]]
+        length = min(block_size, size - index * block_size)
+        out += block if len(block) == length else decompress_block(block)
+    return bytes(out)
@@ -7,14 +7,31 @@ import shutil
 import typing
 import os.path
 import argparse
+import struct
+import zlib
 import subprocess
 from zipfile import ZipFile
+import compress_resource
+
+def write_archive(output, files):
+    # Archive installed by the resource installer of the watch (src/components/fs/ResourceInstaller.h)
+    archive = b'ITRA' + struct.pack('<HH', 1, len(files))
+    for path, content in files:
+        encoded_path = path.encode('utf-8')
+        if len(encoded_path) > 63:
+            sys.exit(f'Error: the path {path} is too long for the archive.')
+        archive += struct.pack('<IIB', len(content), zlib.crc32(content), len(encoded_path)) + encoded_path + content
+    with open(output, 'wb') as fd:
+        fd.write(archive)
+    print(f'Archive {output}: {len(archive)} bytes, CRC32 0x{zlib.crc32(archive):08x}')
 
 def main():
     ap = argparse.ArgumentParser(description='auto generate LVGL font files from fonts')
     ap.add_argument('--config', '-c', type=str, action='append', help='config file to use')
     ap.add_argument('--obsolete', type=str, help='List of obsolete files')
     ap.add_argument('--output', type=str, help='output file name')
+    ap.add_argument('--compress', action='store_true', help='compress the resources that get smaller')
+    ap.add_argument('--archive', type=str, help='also write the resources in a single archive for the resource installer')
     args = ap.parse_args()
 
     for config_file in args.config:
@@ -32,6 +49,7 @@ def main():
 
     zf = ZipFile(args.output, mode='w')
     resource_files = []
+    archive_files = []
 
     for config_file in args.config:
         with open(config_file, 'r') as fd:
@@ -48,7 +66,18 @@ def main():
             path = name + '.bin'
             if not os.path.exists(path):
                 path = os.path.join(os.path.dirname(sys.argv[0]), path)
+            with open(path, 'rb') as fd:
+                content = fd.read()
+            if args.compress:
+                compressed = compress_resource.compress(content)
+                if compress_resource.decompress(compressed) != content:
+                    sys.exit(f'Error: the compression of {path} is not reversible.')
+                if len(compressed) < len(content):
+                    zf.writestr(path, compressed)
+                    archive_files.append((resource['target_path'] + name + '.bin', compressed))
+                    continue
             zf.write(path)
+            archive_files.append((resource['target_path'] + name + '.bin', content))
 
     if args.obsolete:
         obsolete_file_path = os.path.join(os.path.dirname(sys.argv[0]), args.obsolete)
@@ -68,5 +97,8 @@ def main():
     zf.write('resources.json')
     zf.close()
 
+    if args.archive:
+        write_archive(args.archive, archive_files)
+
 if __name__ == '__main__':
     main()
@@ -13,6 +13,7 @@ namespace Pinetime {
       BleFirmwareUpdateStarted,
       BleFirmwareUpdateFinished,
       OnTouchEvent,
+      OnMotionEvent,
       HandleButtonEvent,
       HandleButtonTimerEvent,
       OnDisplayTaskSleeping,
@@ -29,7 +30,10 @@ namespace Pinetime {
       BatteryPercentageUpdated,
       StartFileTransfer,
       StopFileTransfer,
-      BleRadioEnableToggle
+      BleRadioEnableToggle,
+      MotionStreamChanged,
+      SaveSettings,
+      SaveAlarm
     };
   }
 }
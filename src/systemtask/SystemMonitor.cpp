@@ -1,27 +1,119 @@
-#include "systemtask/SystemTask.h"
-#if NRF_LOG_ENABLED
-  // FreeRtosMonitor
-  #include <FreeRTOS.h>
-  #include <task.h>
-  #include <nrf_log.h>
-
-void Pinetime::System::SystemMonitor::Process() {
-  if (xTaskGetTickCount() - lastTick > 10000) {
-    NRF_LOG_INFO("---------------------------------------\nFree heap : %d", xPortGetFreeHeapSize());
-    TaskStatus_t tasksStatus[10];
-    auto nb = uxTaskGetSystemState(tasksStatus, 10, nullptr);
-    for (uint32_t i = 0; i < nb; i++) {
-      NRF_LOG_INFO("Task [%s] - %d", tasksStatus[i].pcTaskName, tasksStatus[i].usStackHighWaterMark);
-      if (tasksStatus[i].usStackHighWaterMark < 20)
-        NRF_LOG_INFO("WARNING!!! Task %s task is nearly full, only %dB available",
-                     tasksStatus[i].pcTaskName,
-                     tasksStatus[i].usStackHighWaterMark * 4);
+#include "systemtask/SystemMonitor.h"
+#include <algorithm>
+#include <cstring>
+#include <nrf_log.h>
+
+using namespace Pinetime::System;
+
+namespace {
+  uint16_t Permille(uint32_t cycles, uint64_t windowCycles) {
+    if (windowCycles == 0) {
+      return 0;
     }
-    lastTick = xTaskGetTickCount();
+    return static_cast<uint16_t>(std::min<uint64_t>(1000, static_cast<uint64_t>(cycles) * 1000 / windowCycles));
+  }
+
+  bool SortByNumber(const TaskStatus_t& lhs, const TaskStatus_t& rhs) {
+    return lhs.xTaskNumber < rhs.xTaskNumber;
   }
 }
-#else
-// DummyMonitor
-void Pinetime::System::SystemMonitor::Process() {
+
+void SystemMonitor::Process() {
+  TickType_t now = xTaskGetTickCount();
+  TickType_t elapsed = now - lastTick;
+  if (elapsed < samplingPeriod) {
+    return;
+  }
+  lastTick = now;
+
+  std::array<TaskStatus_t, MaxTasks> status;
+  auto nb = uxTaskGetSystemState(status.data(), status.size(), nullptr);
+// g++ emits a spurious warning (and thus error because we compile with -Werror)
+// due to the way std::sort is implemented
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Warray-bounds"
+  std::sort(status.begin(), status.begin() + nb, SortByNumber);
+#pragma GCC diagnostic pop
+
+  const uint32_t published = sequence.load(std::memory_order_relaxed);
+  auto& snapshot = snapshots[(published + 1) % 2];
+  uint64_t windowCycles = static_cast<uint64_t>(elapsed) * configCPU_CLOCK_HZ / configTICK_RATE_HZ;
+  uint32_t busyCycles = 0;
+  std::array<Counters, MaxTasks> current;
+  for (size_t i = 0; i < nb; i++) {
+    const auto& task = status[i];
+    // Incremented by traceTASK_SWITCHED_IN() (see FreeRTOSConfig.h)
+    uint32_t contextSwitches = uxTaskGetTaskNumber(task.xHandle);
+    // Tasks created since the previous window start from 0
+    Counters last {task.xHandle, 0, 0};
+    const Counters* begin = previous.data();
+    const Counters* end = begin + nbPrevious;
+    const Counters* found = std::find_if(begin, end, [&task](const Counters& counters) {
+      return counters.handle == task.xHandle;
+    });
+    if (found != end) {
+      last = *found;
+    }
+
+    // The counters wrap, only the differences are meaningful
+    uint32_t runTime = task.ulRunTimeCounter - last.runTime;
+    auto& taskStats = snapshot.tasks[i];
+    std::strncpy(taskStats.name, task.pcTaskName, sizeof(taskStats.name) - 1);
+    taskStats.name[sizeof(taskStats.name) - 1] = '\0';
+    taskStats.number = static_cast<uint8_t>(task.xTaskNumber);
+    taskStats.state = static_cast<uint8_t>(task.eCurrentState);
+    taskStats.stackHighWaterMark = task.usStackHighWaterMark;
+    taskStats.cpuPermille = Permille(runTime, windowCycles);
+    taskStats.contextSwitches = contextSwitches - last.contextSwitches;
+    if (task.xHandle != xTaskGetIdleTaskHandle()) {
+      busyCycles += runTime;
+    }
+    current[i] = {task.xHandle, task.ulRunTimeCounter, contextSwitches};
+  }
+  previous = current;
+  nbPrevious = nb;
+
+  snapshot.stats = {.windowMs = static_cast<uint32_t>(static_cast<uint64_t>(elapsed) * 1000 / configTICK_RATE_HZ),
+           .cpuPermille = Permille(busyCycles, windowCycles),
+           .freeHeap = static_cast<uint32_t>(xPortGetFreeHeapSize()),
+           .minimumEverFreeHeap = static_cast<uint32_t>(xPortGetMinimumEverFreeHeapSize()),
+           .nbTasks = static_cast<uint8_t>(nb)};
+  sequence.store(published + 1, std::memory_order_release);
+  Log(snapshot);
+}
+
+SystemMonitor::Snapshot SystemMonitor::GetSnapshot() const {
+  // Process() writes the buffer being copied only after publishing the other one: retry if a window was published meanwhile
+  Snapshot snapshot;
+  uint32_t published;
+  do {
+    published = sequence.load(std::memory_order_acquire);
+    snapshot = snapshots[published % 2];
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while (sequence.load(std::memory_order_relaxed) != published);
+  return snapshot;
 }
+
+void SystemMonitor::Log(const Snapshot& snapshot) const {
+#if NRF_LOG_ENABLED
+  HeapStats_t heapStats;
+  vPortGetHeapStats(&heapStats);
+  const auto& stats = snapshot.stats;
+  NRF_LOG_INFO("---------------------------------------\nFree heap : %d (min %d, largest block %d), CPU %d permille",
+               stats.freeHeap,
+               stats.minimumEverFreeHeap,
+               heapStats.xSizeOfLargestFreeBlockInBytes,
+               stats.cpuPermille);
+  for (size_t i = 0; i < stats.nbTasks; i++) {
+    const auto& task = snapshot.tasks[i];
+    NRF_LOG_INFO("Task [%s] - %d - CPU %d permille, %d switches",
+                 task.name,
+                 task.stackHighWaterMark,
+                 task.cpuPermille,
+                 task.contextSwitches);
+    if (task.stackHighWaterMark < 20) {
+      NRF_LOG_INFO("WARNING!!! Task %s task is nearly full, only %dB available", task.name, task.stackHighWaterMark * 4);
+    }
+  }
 #endif
+}
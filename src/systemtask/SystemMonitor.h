@@ -1,16 +1,72 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <FreeRTOS.h> // declares configUSE_TRACE_FACILITY
 #include <task.h>
 
 namespace Pinetime {
   namespace System {
+    // Samples the CPU time, the context switches and the stack high water mark of every task, and the free heap, over
+    // windows of a few seconds. It runs in every build, the results are shown in the System Information app and exposed by
+    // the Profiling Service.
+    // The run time counter is the DWT cycle counter (see FreeRTOSConfig.h), which stops while the CPU sleeps: the CPU time
+    // of a task is the time it kept the CPU awake, relative to the duration of the window.
+    // Process() runs in the system task, the results are read from the display task and the BLE host task: they are
+    // published in a double buffer with a sequence counter, and readers copy them.
     class SystemMonitor {
     public:
+      // uxTaskGetSystemState() returns nothing if there are more tasks than that
+      static constexpr size_t MaxTasks = 10;
+
+      struct __attribute__((packed)) TaskStats {
+        char name[configMAX_TASK_NAME_LEN];
+        uint8_t number; // xTaskNumber, in the order of creation
+        uint8_t state;  // eTaskState
+        uint16_t stackHighWaterMark; // Minimum free stack since the task was created, in words
+        uint16_t cpuPermille;
+        uint32_t contextSwitches;
+      };
+
+      struct __attribute__((packed)) Stats {
+        uint32_t windowMs;
+        uint16_t cpuPermille; // All the tasks but the idle task
+        uint32_t freeHeap;
+        uint32_t minimumEverFreeHeap;
+        uint8_t nbTasks;
+      };
+
+      // Results of a complete window, the tasks are sorted by task number
+      struct Snapshot {
+        Stats stats;
+        std::array<TaskStats, MaxTasks> tasks;
+      };
+
       void Process();
-#if configUSE_TRACE_FACILITY == 1
+
+      // Copy of the results of the last complete window. Can be called from any task.
+      Snapshot GetSnapshot() const;
+
     private:
-      mutable TickType_t lastTick = 0;
-#endif
+      // Shorter than the 67 seconds after which the cycle counter wraps at 64MHz
+      static constexpr TickType_t samplingPeriod = pdMS_TO_TICKS(10 * 1000);
+
+      struct Counters {
+        TaskHandle_t handle;
+        uint32_t runTime;
+        uint32_t contextSwitches;
+      };
+
+      TickType_t lastTick = 0;
+      std::array<Counters, MaxTasks> previous {};
+      size_t nbPrevious = 0;
+
+      // The last complete window is in snapshots[sequence % 2], the next one is written in the other buffer
+      std::array<Snapshot, 2> snapshots {};
+      std::atomic<uint32_t> sequence {0};
+
+      void Log(const Snapshot& snapshot) const;
     };
   }
 }
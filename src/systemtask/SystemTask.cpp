@@ -5,6 +5,7 @@
 #include "BootloaderVersion.h"
 #include "components/battery/BatteryController.h"
 #include "components/ble/BleController.h"
+#include "components/history/HistoryController.h"
 #include "displayapp/TouchEvents.h"
 #include "drivers/Cst816s.h"
 #include "drivers/St7789.h"
@@ -17,6 +18,7 @@
 #include "main.h"
 #include "BootErrors.h"
 
+#include <algorithm>
 #include <memory>
 
 using namespace Pinetime::System;
@@ -52,7 +54,10 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
                        Pinetime::Applications::HeartRateTask& heartRateApp,
                        Pinetime::Controllers::FS& fs,
                        Pinetime::Controllers::TouchHandler& touchHandler,
-                       Pinetime::Controllers::ButtonHandler& buttonHandler)
+                       Pinetime::Controllers::ButtonHandler& buttonHandler,
+                       Pinetime::Controllers::FrameProfiler& frameProfiler,
+                       Pinetime::Controllers::HistoryController& historyController,
+                       Pinetime::Controllers::ChangeNotifier& changeNotifier)
   : spi {spi},
     spiNorFlash {spiNorFlash},
     twiMaster {twiMaster},
@@ -74,6 +79,7 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
     fs {fs},
     touchHandler {touchHandler},
     buttonHandler {buttonHandler},
+    historyController {historyController},
     nimbleController(*this,
                      bleController,
                      dateTimeController,
@@ -82,11 +88,15 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
                      spiNorFlash,
                      heartRateController,
                      motionController,
-                     fs) {
+                     fs,
+                     frameProfiler,
+                     changeNotifier) {
 }
 
 void SystemTask::Start() {
   systemTasksMsgQueue = xQueueCreate(10, 1);
+  saveEvents = xEventGroupCreate();
+  xEventGroupSetBits(saveEvents, savesWrittenBit);
   if (pdPASS != xTaskCreate(SystemTask::Process, "MAIN", 350, this, 1, &taskHandle)) {
     APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
   }
@@ -137,7 +147,8 @@ void SystemTask::Work() {
 
   motionSensor.Init();
   motionController.Init(motionSensor.DeviceType());
-  settingsController.Init();
+  settingsController.Init(this);
+  historyController.Init();
 
   displayApp.Register(this);
   displayApp.Register(&nimbleController.weather());
@@ -177,31 +188,45 @@ void SystemTask::Work() {
   nrfx_gpiote_in_init(PinMap::PowerPresent, &pinConfig, nrfx_gpiote_evt_handler);
   nrfx_gpiote_in_event_enable(PinMap::PowerPresent, true);
 
+  // Motion sensor FIFO watermark
+  if (motionSensor.IsFifoEnabled()) {
+    ConfigureMotionSensor();
+    pinConfig.sense = NRF_GPIOTE_POLARITY_LOTOHI;
+    pinConfig.pull = NRF_GPIO_PIN_PULLDOWN;
+    nrfx_gpiote_in_init(PinMap::Bma421Irq, &pinConfig, nrfx_gpiote_evt_handler);
+    nrfx_gpiote_in_event_enable(PinMap::Bma421Irq, true);
+  }
+
   batteryController.MeasureVoltage();
 
   measureBatteryTimer = xTimerCreate("measureBattery", batteryMeasurementPeriod, pdTRUE, this, MeasureBatteryTimerCallback);
   xTimerStart(measureBatteryTimer, portMAX_DELAY);
 
-  constexpr TickType_t stateUpdatePeriod = pdMS_TO_TICKS(100);
   // Stores when the state (motion, watchdog, time persistence etc) was last updated
   // If there are many events being received by the message queue, this prevents
   // having to update motion etc after every single event, which is bad
   // for efficiency and for motion wake algorithms which expect motion readings
-  // to be 100ms apart
+  // to be 100ms apart when they are polled
   TickType_t lastStateUpdate = xTaskGetTickCount() - stateUpdatePeriod; // Force immediate run
   TickType_t elapsed;
+  TickType_t updatePeriod;
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "EndlessLoop"
   while (true) {
     Messages msg;
 
+    if (state == SystemTaskState::Sleeping && motionSensor.IsFifoEnabled() && !isBleDiscoveryTimerRunning) {
+      updatePeriod = sleepingStateUpdatePeriod;
+    } else {
+      updatePeriod = stateUpdatePeriod;
+    }
     elapsed = xTaskGetTickCount() - lastStateUpdate;
     TickType_t waitTime;
-    if (elapsed >= stateUpdatePeriod) {
+    if (elapsed >= updatePeriod) {
       waitTime = 0;
     } else {
-      waitTime = stateUpdatePeriod - elapsed;
+      waitTime = updatePeriod - elapsed;
     }
     if (xQueueReceive(systemTasksMsgQueue, &msg, waitTime) == pdTRUE) {
       switch (msg) {
@@ -241,6 +266,8 @@ void SystemTask::Work() {
           bleDiscoveryTimer = 5;
           break;
         case Messages::BleFirmwareUpdateStarted:
+          // The watch resets at the end of the update
+          historyController.Flush();
           GoToRunning();
           wakeLocksHeld++;
           displayApp.PushMessage(Pinetime::Applications::Display::Messages::BleFirmwareUpdateStarted);
@@ -262,6 +289,12 @@ void SystemTask::Work() {
           wakeLocksHeld--;
           // TODO add intent of fs access icon or something
           break;
+        case Messages::OnMotionEvent:
+          UpdateMotion();
+          break;
+        case Messages::MotionStreamChanged:
+          ConfigureMotionSensor();
+          break;
         case Messages::OnTouchEvent:
           // Finish immediately if no new events
           if (!touchHandler.ProcessTouchInfo(touchPanel.GetTouchInfo())) {
@@ -337,6 +370,7 @@ void SystemTask::Work() {
           motionController.AdvanceDay();
           break;
         case Messages::OnNewHour:
+          historyController.OnNewHour();
           using Pinetime::Controllers::AlarmController;
           if (settingsController.GetNotificationStatus() != Controllers::Settings::Notification::Sleep &&
               settingsController.GetChimeOption() == Controllers::Settings::ChimesOption::Hours && !alarmController.IsAlerting()) {
@@ -366,6 +400,16 @@ void SystemTask::Work() {
           GoToRunning();
           displayApp.PushMessage(Pinetime::Applications::Display::Messages::ShowPairingKey);
           break;
+        case Messages::SaveSettings:
+          isSettingsSavePending = true;
+          nbReceivedSaves++;
+          SavePendingFiles();
+          break;
+        case Messages::SaveAlarm:
+          isAlarmSavePending = true;
+          nbReceivedSaves++;
+          SavePendingFiles();
+          break;
         case Messages::BleRadioEnableToggle:
           if (settingsController.GetBleRadioEnabled()) {
             nimbleController.EnableRadio();
@@ -378,8 +422,11 @@ void SystemTask::Work() {
       }
     }
     elapsed = xTaskGetTickCount() - lastStateUpdate;
-    if (elapsed >= stateUpdatePeriod) {
-      UpdateMotion();
+    if (elapsed >= updatePeriod) {
+      // The FIFO interrupt could have been missed if the line is still high
+      if (!motionSensor.IsFifoEnabled() || nrf_gpio_pin_read(PinMap::Bma421Irq) != 0) {
+        UpdateMotion();
+      }
       if (isBleDiscoveryTimerRunning) {
         if (bleDiscoveryTimer == 0) {
           isBleDiscoveryTimerRunning = false;
@@ -391,6 +438,7 @@ void SystemTask::Work() {
         }
       }
       monitor.Process();
+      historyController.Process();
       NoInit_BackUpTime = dateTimeController.CurrentDateTime();
       if (nrf_gpio_pin_read(PinMap::Button) == 0) {
         watchdog.Reload();
@@ -427,6 +475,8 @@ void SystemTask::GoToRunning() {
   }
 
   state = SystemTaskState::Running;
+  ConfigureMotionSensor();
+  SavePendingFiles();
 };
 
 void SystemTask::GoToSleep() {
@@ -445,21 +495,26 @@ void SystemTask::GoToSleep() {
   heartRateApp.PushMessage(Pinetime::Applications::HeartRateTask::Messages::GoToSleep);
 
   state = SystemTaskState::GoingToSleep;
+  ConfigureMotionSensor();
 };
 
 void SystemTask::UpdateMotion() {
   // Unconditionally update motion
   // Reading steps/motion characteristics must return up to date information even when not subscribed to notifications
 
-  auto motionValues = motionSensor.Process();
-
-  motionController.Update(motionValues.x, motionValues.y, motionValues.z, motionValues.steps);
+  if (motionSensor.IsFifoEnabled()) {
+    size_t nbSamples = motionSensor.ReadFifo(motionSamples);
+    motionController.Update(motionSamples.data(), nbSamples, motionSensor.FifoSamplePeriodMs(), motionSensor.ReadSteps());
+  } else {
+    auto motionValues = motionSensor.Process();
+    motionController.Update(motionValues.x, motionValues.y, motionValues.z, motionValues.steps);
+  }
 
   if (settingsController.GetNotificationStatus() != Controllers::Settings::Notification::Sleep) {
     if ((settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::RaiseWrist) &&
          motionController.ShouldRaiseWake()) ||
         (settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::Shake) &&
-         motionController.CurrentShakeSpeed() > settingsController.GetShakeThreshold())) {
+         motionController.MaxShakeSpeed() > settingsController.GetShakeThreshold())) {
       GoToRunning();
     }
   }
@@ -469,6 +524,65 @@ void SystemTask::UpdateMotion() {
   }
 }
 
+// The settings and the alarm are saved here rather than by the task that changed them (usually DisplayApp), which would
+// otherwise wait for the flash to erase. The flash (and the SPI bus) are off while sleeping: the saves wait for
+// GoToRunning().
+void SystemTask::SavePendingFiles() {
+  if (state == SystemTaskState::Sleeping || state == SystemTaskState::AODSleeping) {
+    return;
+  }
+  if (isSettingsSavePending) {
+    isSettingsSavePending = false;
+    settingsController.SaveSettingsToFile();
+  }
+  if (isAlarmSavePending) {
+    isAlarmSavePending = false;
+    alarmController.SaveSettingsToFile();
+  }
+  if (nbReceivedSaves > 0) {
+    vTaskSuspendAll();
+    nbQueuedSaves -= nbReceivedSaves;
+    if (nbQueuedSaves == 0) {
+      xEventGroupSetBits(saveEvents, savesWrittenBit);
+    }
+    xTaskResumeAll();
+    nbReceivedSaves = 0;
+
+    // Replaces the free blocks the saves used, so that the next ones don't erase with the file system locked
+    while (fs.EraseAhead()) {
+    }
+  }
+}
+
+void SystemTask::QueueSave(Messages msg) {
+  vTaskSuspendAll();
+  nbQueuedSaves++;
+  xEventGroupClearBits(saveEvents, savesWrittenBit);
+  xTaskResumeAll();
+  PushMessage(msg);
+}
+
+bool SystemTask::WaitForSaves(TickType_t timeout) {
+  return (xEventGroupWaitBits(saveEvents, savesWrittenBit, pdFALSE, pdTRUE, timeout) & savesWrittenBit) != 0;
+}
+
+void SystemTask::ConfigureMotionSensor() {
+  if (!motionSensor.IsFifoEnabled()) {
+    return;
+  }
+
+  const auto* motionService = motionController.GetService();
+  if (motionService != nullptr && motionService->IsStreaming()) {
+    motionSensor.SetFifoSampleRate(motionService->StreamSampleRate());
+  } else {
+    motionSensor.SetFifoSampleRate(Drivers::Bma421::DefaultFifoSampleRate);
+  }
+  // The motion latency doesn't depend on the sample rate, the stream is notified in batches independently of the FIFO reads
+  uint32_t batchMs = state == SystemTaskState::Running ? runningMotionBatchMs : sleepingMotionBatchMs;
+  // A batch larger than a burst would take several TWI transfers
+  motionSensor.SetFifoWatermark(std::min<uint32_t>(batchMs / motionSensor.FifoSamplePeriodMs(), Drivers::Bma421::MaxFifoBurstSamples));
+}
+
 void SystemTask::HandleButtonAction(Controllers::ButtonActions action) {
   if (IsSleeping()) {
     return;
@@ -4,6 +4,7 @@
 
 #include <FreeRTOS.h>
 #include <queue.h>
+#include <event_groups.h>
 #include <task.h>
 #include <timers.h>
 #include <heartratetask/HeartRateTask.h>
@@ -48,6 +49,8 @@ namespace Pinetime {
     class Battery;
     class TouchHandler;
     class ButtonHandler;
+    class FrameProfiler;
+    class HistoryController;
   }
 
   namespace System {
@@ -74,10 +77,18 @@ namespace Pinetime {
                  Pinetime::Applications::HeartRateTask& heartRateApp,
                  Pinetime::Controllers::FS& fs,
                  Pinetime::Controllers::TouchHandler& touchHandler,
-                 Pinetime::Controllers::ButtonHandler& buttonHandler);
+                 Pinetime::Controllers::ButtonHandler& buttonHandler,
+                 Pinetime::Controllers::FrameProfiler& frameProfiler,
+                 Pinetime::Controllers::HistoryController& historyController,
+                 Pinetime::Controllers::ChangeNotifier& changeNotifier);
 
       void Start();
       void PushMessage(Messages msg);
+      // Queues the save of a file (Messages::SaveSettings or Messages::SaveAlarm), written by the system task
+      void QueueSave(Messages msg);
+      // Waits until the saves queued so far are written, returns false on timeout. Called by the other tasks, for instance
+      // before a reset.
+      bool WaitForSaves(TickType_t timeout);
 
       bool IsSleepDisabled() {
         return wakeLocksHeld > 0;
@@ -99,6 +110,14 @@ namespace Pinetime {
         return state != SystemTaskState::Running;
       }
 
+      const SystemMonitor& GetSystemMonitor() const {
+        return monitor;
+      }
+
+      const Drivers::SpiMaster& GetSpiMaster() const {
+        return spi;
+      }
+
     private:
       TaskHandle_t taskHandle;
 
@@ -126,6 +145,7 @@ namespace Pinetime {
       Pinetime::Controllers::FS& fs;
       Pinetime::Controllers::TouchHandler& touchHandler;
       Pinetime::Controllers::ButtonHandler& buttonHandler;
+      Pinetime::Controllers::HistoryController& historyController;
       Pinetime::Controllers::NimbleController nimbleController;
 
       static void Process(void* instance);
@@ -142,7 +162,26 @@ namespace Pinetime {
       void GoToRunning();
       void GoToSleep();
       void UpdateMotion();
+      void ConfigureMotionSensor();
+      void SavePendingFiles();
+      // Saves requested by the other tasks while the flash was off
+      bool isSettingsSavePending = false;
+      bool isAlarmSavePending = false;
+      // savesWrittenBit is set while nbQueuedSaves is 0, both are updated with the scheduler suspended
+      EventGroupHandle_t saveEvents;
+      static constexpr EventBits_t savesWrittenBit = 1;
+      uint8_t nbQueuedSaves = 0;
+      // Save messages received since the last write
+      uint8_t nbReceivedSaves = 0;
       static constexpr TickType_t batteryMeasurementPeriod = pdMS_TO_TICKS(10 * 60 * 1000);
+      static constexpr TickType_t stateUpdatePeriod = pdMS_TO_TICKS(100);
+      // The motion data comes from the FIFO interrupt, the periodic work only needs to reload the watchdog and back up the time
+      static constexpr TickType_t sleepingStateUpdatePeriod = pdMS_TO_TICKS(1000);
+      // Time covered by the samples batched in the accelerometer FIFO before it raises its interrupt
+      static constexpr uint32_t runningMotionBatchMs = 160;
+      static constexpr uint32_t sleepingMotionBatchMs = 640;
+
+      std::array<Drivers::Bma421::Sample, Drivers::Bma421::MaxFifoSamples> motionSamples;
 
       SystemMonitor monitor;
     };
@@ -0,0 +1,149 @@
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "components/crc/Crc.h"
+
+using namespace Pinetime::Tools;
+
+namespace {
+  uint16_t ReferenceCrc16(uint16_t crc, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      crc ^= static_cast<uint16_t>(data[i] << 8);
+      for (int bit = 0; bit < 8; bit++) {
+        crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+      }
+    }
+    return crc;
+  }
+
+  // Byte table variant of the CRC16, measured against the shift-xor of Crc16::Update()
+  constexpr std::array<uint16_t, 256> MakeCrc16Table() {
+    std::array<uint16_t, 256> table {};
+    for (uint32_t byte = 0; byte < 256; byte++) {
+      uint16_t crc = static_cast<uint16_t>(byte << 8);
+      for (int bit = 0; bit < 8; bit++) {
+        crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+      }
+      table[byte] = crc;
+    }
+    return table;
+  }
+
+  constexpr auto crc16Table = MakeCrc16Table();
+
+  uint16_t TableCrc16(uint16_t crc, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      crc = static_cast<uint16_t>((crc << 8) ^ crc16Table[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+  }
+
+  uint32_t ReferenceCrc32(uint32_t crc, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      crc ^= data[i];
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+      }
+    }
+    return crc;
+  }
+
+  int nbErrors = 0;
+
+  void Check(bool condition, const char* what, size_t offset, size_t size) {
+    if (!condition) {
+      if (nbErrors < 10) {
+        std::printf("Mismatch: %s, offset %zu, size %zu\n", what, offset, size);
+      }
+      nbErrors++;
+    }
+  }
+
+  void CheckBuffer(const uint8_t* data, size_t offset, size_t size) {
+    const uint8_t* p = data + offset;
+    Check(Crc16::Compute(p, size) == ReferenceCrc16(0xFFFF, p, size), "CRC16", offset, size);
+    Check(TableCrc16(0xFFFF, p, size) == ReferenceCrc16(0xFFFF, p, size), "CRC16 table", offset, size);
+    Check(Crc32::Update(Crc32::initialValue, p, size) == ReferenceCrc32(0xFFFFFFFF, p, size), "CRC32", offset, size);
+
+    // Split updates, as done by the DFU and the resource installer on each packet
+    size_t split = size / 3;
+    uint16_t crc16 = Crc16::Update(Crc16::initialValue, p, split);
+    crc16 = Crc16::Update(crc16, p + split, size - split);
+    Check(crc16 == Crc16::Compute(p, size), "CRC16 split", offset, size);
+    uint32_t crc32 = Crc32::Update(Crc32::initialValue, p, split);
+    crc32 = Crc32::Update(crc32, p + split, size - split);
+    Check(crc32 == Crc32::Update(Crc32::initialValue, p, size), "CRC32 split", offset, size);
+  }
+
+  template <typename Function>
+  double Throughput(const std::vector<uint8_t>& data, Function function) {
+    constexpr int nbRuns = 200;
+    uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nbRuns; i++) {
+      // The data may have changed: keeps the compiler from computing an inlined CRC only once for all the runs
+      asm volatile("" : : "r"(data.data()) : "memory");
+      sink += function(data.data(), data.size());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    // Keeps the computations from being optimized out
+    if (sink == 0x12345678) {
+      std::printf(" ");
+    }
+    return (static_cast<double>(data.size()) * nbRuns) / (1024 * 1024) / elapsed.count();
+  }
+}
+
+int main() {
+  const auto* check = reinterpret_cast<const uint8_t*>("123456789");
+  Check(Crc16::Compute(check, 9) == 0x29B1, "CRC16 check value", 0, 9);
+  Check(Crc32::Compute(check, 9) == 0xCBF43926, "CRC32 check value", 0, 9);
+
+  std::mt19937 random(42);
+  std::vector<uint8_t> data(64 * 1024);
+  for (auto& byte : data) {
+    byte = static_cast<uint8_t>(random());
+  }
+
+  // All the short lengths from every alignment, then random slices
+  for (size_t offset = 0; offset < 4; offset++) {
+    for (size_t size = 0; size <= 64; size++) {
+      CheckBuffer(data.data(), offset, size);
+    }
+  }
+  for (int i = 0; i < 1000; i++) {
+    size_t offset = random() % 1024;
+    size_t size = random() % (data.size() - offset);
+    CheckBuffer(data.data(), offset, size);
+  }
+
+  std::printf("CRC_SLICES=%d\n", CRC_SLICES);
+  std::printf("  CRC16: %8.1f MB/s (byte table: %8.1f MB/s, bitwise: %8.1f MB/s)\n",
+              Throughput(data,
+                         [](const uint8_t* p, size_t size) {
+                           return Crc16::Compute(p, size);
+                         }),
+              Throughput(data,
+                         [](const uint8_t* p, size_t size) {
+                           return TableCrc16(0xFFFF, p, size);
+                         }),
+              Throughput(data, [](const uint8_t* p, size_t size) {
+                return ReferenceCrc16(0xFFFF, p, size);
+              }));
+  std::printf("  CRC32: %8.1f MB/s (bitwise: %8.1f MB/s)\n",
+              Throughput(data,
+                         [](const uint8_t* p, size_t size) {
+                           return Crc32::Compute(p, size);
+                         }),
+              Throughput(data, [](const uint8_t* p, size_t size) {
+                return ReferenceCrc32(0xFFFFFFFF, p, size);
+              }));
+
+  if (nbErrors > 0) {
+    std::printf("%d mismatches\n", nbErrors);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include "drivers/SpiNorFlash.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Pinetime::Drivers;
+
+namespace {
+  constexpr size_t cmdSize = 4;
+
+  [[noreturn]] void Fail(const char* message, uint32_t address) {
+    std::fprintf(stderr, "SpiNorFlash: %s (address 0x%06x)\n", message, address);
+    std::abort();
+  }
+}
+
+SpiNorFlash::SpiNorFlash() : memory(Size, 0xff) {
+}
+
+void SpiNorFlash::Transaction(size_t nbBytes) {
+  statistics.transactions++;
+  statistics.busyTimeUs += timings.transactionOverheadUs + (nbBytes * timings.byteTimeNs) / 1000;
+}
+
+void SpiNorFlash::WaitWhileBusy(uint32_t busyTimeUs) {
+  // The driver polls the status register and sleeps for one tick as long as the chip is busy
+  const uint32_t nbTicks = (busyTimeUs + timings.tickUs - 1) / timings.tickUs;
+  for (uint32_t i = 0; i < nbTicks; i++) {
+    Transaction(2);
+    statistics.busyTimeUs += timings.tickUs;
+  }
+  Transaction(2);
+}
+
+void SpiNorFlash::Read(uint32_t address, uint8_t* buffer, size_t size) {
+  if (address + size > Size) {
+    Fail("read out of range", address);
+  }
+  statistics.bytesRead += size;
+  std::copy_n(memory.begin() + address, size, buffer);
+  // The driver reads page by page
+  while (size > 0) {
+    const size_t toRead = std::min(size, PageSize - (address % PageSize));
+    statistics.readCommands++;
+    Transaction(cmdSize + toRead);
+    address += toRead;
+    size -= toRead;
+  }
+}
+
+void SpiNorFlash::Write(uint32_t address, const uint8_t* buffer, size_t size) {
+  if (address + size > Size) {
+    Fail("program out of range", address);
+  }
+  programFailed = false;
+  while (size > 0) {
+    const size_t toWrite = std::min(size, PageSize - (address % PageSize));
+
+    Transaction(1); // Write enable
+    Transaction(2); // Write enabled?
+    statistics.programCommands++;
+    statistics.bytesProgrammed += toWrite;
+    Transaction(cmdSize + toWrite);
+    for (size_t i = 0; i < toWrite; i++) {
+      // Programming can only clear bits
+      if ((memory[address + i] & buffer[i]) != buffer[i]) {
+        programFailed = true;
+      }
+      memory[address + i] &= buffer[i];
+    }
+    WaitWhileBusy(timings.pageProgramUs);
+
+    address += toWrite;
+    buffer += toWrite;
+    size -= toWrite;
+  }
+}
+
+void SpiNorFlash::SectorErase(uint32_t sectorAddress) {
+  if (sectorAddress % SectorSize != 0 || sectorAddress >= Size) {
+    Fail("invalid sector address", sectorAddress);
+  }
+  eraseFailed = false;
+  Transaction(1); // Write enable
+  Transaction(2); // Write enabled?
+  statistics.eraseCommands++;
+  Transaction(cmdSize);
+  std::fill_n(memory.begin() + sectorAddress, SectorSize, 0xff);
+  WaitWhileBusy(timings.sectorEraseUs);
+}
+
+bool SpiNorFlash::ProgramFailed() {
+  Transaction(2); // Read security register
+  return programFailed;
+}
+
+bool SpiNorFlash::EraseFailed() {
+  Transaction(2); // Read security register
+  return eraseFailed;
+}
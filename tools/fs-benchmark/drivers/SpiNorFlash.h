@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Pinetime {
+  namespace Drivers {
+    // RAM-backed stand-in for the SPI NOR flash driver, used to run Controllers::FS on the host.
+    // It enforces the NOR flash rules (4KiB sector erase, programming only clears bits, page-wrapping programs)
+    // and estimates the time the real driver would spend on the bus and waiting for the chip.
+    class SpiNorFlash {
+    public:
+      struct Statistics {
+        uint32_t transactions = 0; // SPI transactions, including write enable and status polling
+        uint32_t readCommands = 0;
+        uint32_t programCommands = 0;
+        uint32_t eraseCommands = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesProgrammed = 0;
+        uint64_t busyTimeUs = 0;
+      };
+
+      // Timings of the PineTime (8MHz SPI, 1024Hz FreeRTOS tick, XT25F32B datasheet typical values)
+      struct Timings {
+        uint32_t transactionOverheadUs = 10;
+        uint32_t byteTimeNs = 1000;
+        uint32_t tickUs = 977;
+        uint32_t pageProgramUs = 500;
+        uint32_t sectorEraseUs = 40000;
+      };
+
+      static constexpr size_t Size = 4 * 1024 * 1024;
+      static constexpr size_t SectorSize = 4096;
+      static constexpr size_t PageSize = 256;
+
+      SpiNorFlash();
+      SpiNorFlash(const SpiNorFlash&) = delete;
+      SpiNorFlash& operator=(const SpiNorFlash&) = delete;
+      SpiNorFlash(SpiNorFlash&&) = delete;
+      SpiNorFlash& operator=(SpiNorFlash&&) = delete;
+
+      // Interface used by Controllers::FS
+      void Read(uint32_t address, uint8_t* buffer, size_t size);
+      void Write(uint32_t address, const uint8_t* buffer, size_t size);
+      void SectorErase(uint32_t sectorAddress);
+      bool ProgramFailed();
+      bool EraseFailed();
+
+      const Statistics& GetStatistics() const {
+        return statistics;
+      }
+
+      void ResetStatistics() {
+        statistics = {};
+      }
+
+      Timings timings;
+
+    private:
+      void Transaction(size_t nbBytes);
+      void WaitWhileBusy(uint32_t busyTimeUs);
+
+      std::vector<uint8_t> memory;
+      Statistics statistics;
+      bool programFailed = false;
+      bool eraseFailed = false;
+    };
+  }
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+
+// Single threaded stand-in for the parts of FreeRTOS used by Controllers::FS
+using TickType_t = uint32_t;
+
+#define portMAX_DELAY 0xffffffffUL
+#define ASSERT(expression) assert(expression)
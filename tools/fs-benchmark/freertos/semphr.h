@@ -0,0 +1,20 @@
+#pragma once
+#include "FreeRTOS.h"
+
+// The mutex only checks that it isn't taken twice
+using SemaphoreHandle_t = bool*;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new bool(false);
+}
+
+inline int xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t /*timeout*/) {
+  assert(!*mutex);
+  *mutex = true;
+  return 1;
+}
+
+inline int xSemaphoreGive(SemaphoreHandle_t mutex) {
+  *mutex = false;
+  return 1;
+}
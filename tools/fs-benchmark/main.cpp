@@ -0,0 +1,195 @@
+// Runs the FS controller on a RAM-backed fake SPI NOR flash and reports how much flash traffic
+// typical InfiniTime workloads generate. See README.md.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+#include "components/fs/FS.h"
+#include "drivers/SpiNorFlash.h"
+
+using Pinetime::Controllers::FS;
+using Pinetime::Drivers::SpiNorFlash;
+
+namespace {
+  struct Workload {
+    const char* name;
+    std::function<void(FS&)> setup;
+    std::function<void(FS&)> run;
+  };
+
+  std::vector<uint8_t> RandomData(size_t size, uint32_t seed) {
+    std::mt19937 generator {seed};
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+      byte = static_cast<uint8_t>(generator());
+    }
+    return data;
+  }
+
+  void WriteFile(FS& fs, const char* path, const std::vector<uint8_t>& data) {
+    lfs_file_t file;
+    if (fs.FileOpen(&file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) != LFS_ERR_OK) {
+      std::fprintf(stderr, "Cannot create %s\n", path);
+      return;
+    }
+    fs.FileWrite(&file, data.data(), data.size());
+    fs.FileClose(&file);
+  }
+
+  // Settings::SaveSettingsToFile(), called each time a setting is changed
+  void SaveSettings(FS& fs) {
+    static constexpr size_t settingsSize = 64; // sizeof(Settings::SettingsData)
+    static constexpr int nbSaves = 50;
+    auto settings = RandomData(settingsSize, 1);
+    for (int i = 0; i < nbSaves; i++) {
+      settings[0] = static_cast<uint8_t>(i);
+      lfs_file_t file;
+      if (fs.FileOpen(&file, "/settings.dat", LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
+        return;
+      }
+      fs.FileWrite(&file, settings.data(), settings.size());
+      fs.FileClose(&file);
+    }
+  }
+
+  // FSService WRITE_DATA: every chunk re-opens the file, seeks, writes, closes and computes the free space
+  void BleFileTransfer(FS& fs) {
+    static constexpr size_t fileSize = 100 * 1024;
+    static constexpr size_t chunkSize = 235; // ATT MTU 247 - ATT header - WritePacing header
+    auto data = RandomData(fileSize, 2);
+    lfs_file_t file;
+    if (fs.FileOpen(&file, "/transfer.bin", LFS_O_RDWR | LFS_O_CREAT) == LFS_ERR_OK) {
+      fs.FileClose(&file);
+    }
+    for (size_t offset = 0; offset < fileSize; offset += chunkSize) {
+      const size_t size = std::min(chunkSize, fileSize - offset);
+      if (fs.FileOpen(&file, "/transfer.bin", LFS_O_RDWR | LFS_O_CREAT) != LFS_ERR_OK) {
+        return;
+      }
+      if (fs.FileSeek(&file, offset) >= 0) {
+        fs.FileWrite(&file, data.data() + offset, size);
+      }
+      fs.FileClose(&file);
+      fs.GetFSSize();
+    }
+  }
+
+  void CreateFont(FS& fs) {
+    fs.DirCreate("/fonts");
+    WriteFile(fs, "/fonts/font.bin", RandomData(24 * 1024, 3));
+  }
+
+  // lv_font_load(): reads the header and tables with many small reads, the glyph bitmaps with bigger ones
+  void LoadFont(FS& fs) {
+    std::mt19937 generator {4};
+    std::uniform_int_distribution<size_t> smallRead {2, 16};
+    std::vector<uint8_t> buffer(1024);
+    lfs_file_t file;
+    if (fs.FileOpen(&file, "/fonts/font.bin", LFS_O_RDONLY) != LFS_ERR_OK) {
+      return;
+    }
+    size_t offset = 0;
+    // Header, cmaps and glyph descriptions
+    while (offset < 8 * 1024) {
+      const size_t size = smallRead(generator);
+      fs.FileRead(&file, buffer.data(), size);
+      offset += size;
+    }
+    // Bitmaps
+    while (offset < 24 * 1024) {
+      const size_t size = std::min<size_t>(buffer.size(), 24 * 1024 - offset);
+      fs.FileRead(&file, buffer.data(), size);
+      offset += size;
+    }
+    fs.FileClose(&file);
+  }
+
+  void CreateDirectory(FS& fs) {
+    fs.DirCreate("/images");
+    for (int i = 0; i < 30; i++) {
+      char path[32];
+      std::snprintf(path, sizeof(path), "/images/image%02d.bin", i);
+      WriteFile(fs, path, RandomData(512, 5 + i));
+    }
+  }
+
+  // Resource listing (FSService LISTDIR) and file lookups
+  void ListDirectory(FS& fs) {
+    static constexpr int nbListings = 10;
+    for (int i = 0; i < nbListings; i++) {
+      lfs_dir_t dir;
+      lfs_info info;
+      if (fs.DirOpen("/images", &dir) != LFS_ERR_OK) {
+        return;
+      }
+      while (fs.DirRead(&dir, &info) > 0) {
+        fs.Stat("/images/image00.bin", &info);
+      }
+      fs.DirClose(&dir);
+    }
+  }
+
+  void PrintHeader() {
+    std::printf("%-20s %8s %8s %10s %8s %10s %6s %10s %8s %8s %8s\n",
+                "workload",
+                "xfers",
+                "reads",
+                "read B",
+                "progs",
+                "prog B",
+                "erases",
+                "flash ms",
+                "c.hits",
+                "c.misses",
+                "host ms");
+  }
+}
+
+int main() {
+  static SpiNorFlash flash;
+  static FS fs {flash};
+  fs.Init();
+
+  const std::vector<Workload> workloads {
+    {"settings save", nullptr, SaveSettings},
+    {"BLE transfer 100KB", nullptr, BleFileTransfer},
+    {"font load", CreateFont, LoadFont},
+    {"directory listing", CreateDirectory, ListDirectory},
+  };
+
+  std::printf("FS read cache: %d lines\n", FS_READ_CACHE_LINES);
+  PrintHeader();
+  for (const auto& workload : workloads) {
+    if (workload.setup) {
+      workload.setup(fs);
+    }
+
+    flash.ResetStatistics();
+    const auto cacheBefore = fs.GetReadCacheStats();
+    const auto start = std::chrono::steady_clock::now();
+    workload.run(fs);
+    const auto end = std::chrono::steady_clock::now();
+    const auto& stats = flash.GetStatistics();
+    const auto& cache = fs.GetReadCacheStats();
+
+    std::printf("%-20s %8" PRIu32 " %8" PRIu32 " %10" PRIu64 " %8" PRIu32 " %10" PRIu64 " %6" PRIu32 " %10.1f %8" PRIu32 " %8" PRIu32
+                " %8.2f\n",
+                workload.name,
+                stats.transactions,
+                stats.readCommands,
+                stats.bytesRead,
+                stats.programCommands,
+                stats.bytesProgrammed,
+                stats.eraseCommands,
+                static_cast<double>(stats.busyTimeUs) / 1000.0,
+                cache.hits - cacheBefore.hits,
+                cache.misses - cacheBefore.misses,
+                std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  return 0;
+}
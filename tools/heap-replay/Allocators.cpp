@@ -0,0 +1,169 @@
+#include "Allocators.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace Pinetime::HeapReplay;
+
+FreeListAllocator::FreeListAllocator(uint32_t heapSize, Fit fit) : fit {fit} {
+  // The end marker of heap_4 takes the last header of the heap
+  freeBytes = (heapSize - HeaderSize) & ~(Alignment - 1);
+  freeBlocks.emplace(0, freeBytes);
+}
+
+const char* FreeListAllocator::Name() const {
+  return fit == Fit::First ? "heap_4 (first fit)" : "best fit";
+}
+
+std::optional<uint32_t> FreeListAllocator::Allocate(uint32_t size) {
+  auto selected = freeBlocks.end();
+  for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+    if (it->second < size) {
+      continue;
+    }
+    if (fit == Fit::First) {
+      selected = it;
+      break;
+    }
+    if (selected == freeBlocks.end() || it->second < selected->second) {
+      selected = it;
+    }
+  }
+  if (selected == freeBlocks.end()) {
+    return {};
+  }
+
+  uint32_t offset = selected->first;
+  uint32_t blockSize = selected->second;
+  freeBlocks.erase(selected);
+  if (blockSize - size > minimumBlockSize) {
+    freeBlocks.emplace(offset + size, blockSize - size);
+    blockSize = size;
+  }
+  usedBlocks.emplace(offset, blockSize);
+  freeBytes -= blockSize;
+  return offset;
+}
+
+void FreeListAllocator::Free(uint32_t offset) {
+  auto used = usedBlocks.find(offset);
+  if (used == usedBlocks.end()) {
+    return;
+  }
+  uint32_t size = used->second;
+  usedBlocks.erase(used);
+  freeBytes += size;
+
+  auto next = freeBlocks.lower_bound(offset);
+  if (next != freeBlocks.end() && offset + size == next->first) {
+    size += next->second;
+    next = freeBlocks.erase(next);
+  }
+  if (next != freeBlocks.begin()) {
+    auto previous = std::prev(next);
+    if (previous->first + previous->second == offset) {
+      previous->second += size;
+      return;
+    }
+  }
+  freeBlocks.emplace(offset, size);
+}
+
+uint32_t FreeListAllocator::FreeBytes() const {
+  return freeBytes;
+}
+
+uint32_t FreeListAllocator::LargestFreeBlock() const {
+  uint32_t largest = 0;
+  for (const auto& block : freeBlocks) {
+    largest = std::max(largest, block.second);
+  }
+  return largest;
+}
+
+uint32_t FreeListAllocator::BlockSize(uint32_t offset) const {
+  auto it = usedBlocks.find(offset);
+  return it != usedBlocks.end() ? it->second : 0;
+}
+
+SegregatedAllocator::SegregatedAllocator(uint32_t heapSize) : heap {heapSize, FreeListAllocator::Fit::First} {
+}
+
+const char* SegregatedAllocator::Name() const {
+  return "size class pools";
+}
+
+uint32_t SegregatedAllocator::SlotsOffset(uint32_t chunkOffset) const {
+  return chunkOffset + HeaderSize;
+}
+
+std::optional<uint32_t> SegregatedAllocator::Allocate(uint32_t size) {
+  const uint32_t* slotSize = std::find_if(std::begin(slotSizes), std::end(slotSizes), [size](uint32_t slot) {
+    return slot >= size;
+  });
+  if (slotSize == std::end(slotSizes)) {
+    return heap.Allocate(size);
+  }
+
+  for (auto& [chunkOffset, chunk] : chunks) {
+    if (chunk.slotSize != *slotSize || chunk.nbUsed == chunk.used.size()) {
+      continue;
+    }
+    auto slot = static_cast<uint32_t>(std::find(chunk.used.begin(), chunk.used.end(), false) - chunk.used.begin());
+    chunk.used[slot] = true;
+    chunk.nbUsed++;
+    return SlotsOffset(chunkOffset) + slot * chunk.slotSize;
+  }
+
+  auto chunkOffset = heap.Allocate(chunkSize);
+  if (!chunkOffset) {
+    // The last free bytes may still hold the block
+    return heap.Allocate(size);
+  }
+  Chunk chunk {*slotSize, std::vector<bool>((chunkSize - HeaderSize) / *slotSize, false)};
+  chunk.used[0] = true;
+  chunk.nbUsed = 1;
+  chunks.emplace(*chunkOffset, std::move(chunk));
+  return SlotsOffset(*chunkOffset);
+}
+
+void SegregatedAllocator::Free(uint32_t offset) {
+  auto it = chunks.upper_bound(offset);
+  if (it != chunks.begin()) {
+    --it;
+    uint32_t slotsOffset = SlotsOffset(it->first);
+    auto& chunk = it->second;
+    if (offset >= slotsOffset && offset < slotsOffset + chunk.used.size() * chunk.slotSize) {
+      uint32_t slot = (offset - slotsOffset) / chunk.slotSize;
+      if (chunk.used[slot]) {
+        chunk.used[slot] = false;
+        chunk.nbUsed--;
+      }
+      if (chunk.nbUsed == 0) {
+        heap.Free(it->first);
+        chunks.erase(it);
+      }
+      return;
+    }
+  }
+  heap.Free(offset);
+}
+
+uint32_t SegregatedAllocator::FreeBytes() const {
+  uint32_t freeSlotBytes = 0;
+  for (const auto& [chunkOffset, chunk] : chunks) {
+    freeSlotBytes += (static_cast<uint32_t>(chunk.used.size()) - chunk.nbUsed) * chunk.slotSize;
+  }
+  return heap.FreeBytes() + freeSlotBytes;
+}
+
+uint32_t SegregatedAllocator::LargestFreeBlock() const {
+  return heap.LargestFreeBlock();
+}
+
+std::vector<std::unique_ptr<Allocator>> Pinetime::HeapReplay::CreateAllocators(uint32_t heapSize) {
+  std::vector<std::unique_ptr<Allocator>> allocators;
+  allocators.push_back(std::make_unique<FreeListAllocator>(heapSize, FreeListAllocator::Fit::First));
+  allocators.push_back(std::make_unique<FreeListAllocator>(heapSize, FreeListAllocator::Fit::Best));
+  allocators.push_back(std::make_unique<SegregatedAllocator>(heapSize));
+  return allocators;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Pinetime {
+  namespace HeapReplay {
+    // Models of allocators working on the heap of the watch: offsets and sizes are those of the target, sizes include the
+    // 8 bytes header of heap_4 and are multiples of 8.
+    class Allocator {
+    public:
+      static constexpr uint32_t HeaderSize = 8;
+      static constexpr uint32_t Alignment = 8;
+
+      virtual ~Allocator() = default;
+      virtual const char* Name() const = 0;
+      // Returns the offset of the block in the heap
+      virtual std::optional<uint32_t> Allocate(uint32_t size) = 0;
+      virtual void Free(uint32_t offset) = 0;
+      virtual uint32_t FreeBytes() const = 0;
+      virtual uint32_t LargestFreeBlock() const = 0;
+    };
+
+    // Address ordered free list with coalescing, like heap_4_infinitime.c. Blocks are split when at least 16 bytes remain.
+    class FreeListAllocator : public Allocator {
+    public:
+      enum class Fit { First, Best };
+
+      FreeListAllocator(uint32_t heapSize, Fit fit);
+
+      const char* Name() const override;
+      std::optional<uint32_t> Allocate(uint32_t size) override;
+      void Free(uint32_t offset) override;
+      uint32_t FreeBytes() const override;
+      uint32_t LargestFreeBlock() const override;
+      // Size of an allocated block, larger than the size requested when the remainder was too small to be split
+      uint32_t BlockSize(uint32_t offset) const;
+
+    private:
+      static constexpr uint32_t minimumBlockSize = 2 * HeaderSize;
+
+      Fit fit;
+      std::map<uint32_t, uint32_t> freeBlocks; // offset -> size
+      std::map<uint32_t, uint32_t> usedBlocks;
+      uint32_t freeBytes;
+    };
+
+    // Pools of fixed size slots for the small blocks, first fit for the others. The pools grow by chunks taken from the
+    // first fit heap, and give them back when they are empty.
+    class SegregatedAllocator : public Allocator {
+    public:
+      explicit SegregatedAllocator(uint32_t heapSize);
+
+      const char* Name() const override;
+      std::optional<uint32_t> Allocate(uint32_t size) override;
+      void Free(uint32_t offset) override;
+      uint32_t FreeBytes() const override;
+      uint32_t LargestFreeBlock() const override;
+
+    private:
+      static constexpr uint32_t chunkSize = 512;
+      static constexpr uint32_t slotSizes[] = {16, 32, 64};
+
+      struct Chunk {
+        uint32_t slotSize;
+        std::vector<bool> used;
+        uint32_t nbUsed = 0;
+      };
+
+      FreeListAllocator heap;
+      std::map<uint32_t, Chunk> chunks; // Offset of the chunk -> chunk
+
+      uint32_t SlotsOffset(uint32_t chunkOffset) const;
+    };
+
+    std::vector<std::unique_ptr<Allocator>> CreateAllocators(uint32_t heapSize);
+  }
+}
@@ -0,0 +1,203 @@
+#include "Trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include "Allocators.h"
+
+using namespace Pinetime::HeapReplay;
+
+namespace {
+  constexpr size_t headerSize = 12;
+  constexpr size_t recordSize = 12;
+
+  bool EndsWith(const char* string, const char* suffix) {
+    size_t length = std::strlen(string);
+    size_t suffixLength = std::strlen(suffix);
+    return length >= suffixLength && std::strcmp(string + length - suffixLength, suffix) == 0;
+  }
+
+  uint32_t ReadU32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+  }
+
+  uint16_t ReadU16(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+  }
+
+  // Values read twice (overlapping reads) are merged by sequence number
+  bool LoadBinary(FILE* file, std::map<uint32_t, Trace::Record>& records, Trace& trace) {
+    uint8_t length[2];
+    while (std::fread(length, sizeof(length), 1, file) == 1) {
+      std::vector<uint8_t> value(ReadU16(length));
+      if (value.size() < headerSize || (value.size() - headerSize) % recordSize != 0 ||
+          std::fread(value.data(), value.size(), 1, file) != 1) {
+        return false;
+      }
+      trace.heapSize = ReadU32(value.data());
+      uint32_t sequence = ReadU32(value.data() + 8);
+      for (size_t position = headerSize; position < value.size(); position += recordSize) {
+        const uint8_t* data = value.data() + position;
+        Trace::Record record {sequence++, ReadU32(data), ReadU16(data + 4), ReadU16(data + 6), {}, static_cast<Trace::Operation>(data[11])};
+        std::memcpy(record.task, data + 8, 3);
+        records[record.sequence] = record;
+      }
+    }
+    return true;
+  }
+
+  bool LoadCsv(FILE* file, std::map<uint32_t, Trace::Record>& records, Trace& trace) {
+    char line[128];
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+      unsigned heapSize;
+      if (std::sscanf(line, "heap,%u", &heapSize) == 1) {
+        trace.heapSize = heapSize;
+        continue;
+      }
+      unsigned sequence;
+      unsigned operation;
+      unsigned offset;
+      unsigned size;
+      int taskPosition = 0;
+      if (line[0] < '0' || line[0] > '9' ||
+          std::sscanf(line, "%u,%u,%u,%u,%n", &sequence, &operation, &offset, &size, &taskPosition) != 4 || taskPosition == 0) {
+        continue;
+      }
+      Trace::Record record {sequence, 0, static_cast<uint16_t>(offset), static_cast<uint16_t>(size), {}, static_cast<Trace::Operation>(operation)};
+      const char* task = line + taskPosition;
+      size_t taskLength = std::strcspn(task, ",\n");
+      std::memcpy(record.task, task, std::min<size_t>(taskLength, 3));
+      if (task[taskLength] == ',') {
+        record.caller = static_cast<uint32_t>(std::strtoul(task + taskLength + 1, nullptr, 0));
+      }
+      records[record.sequence] = record;
+    }
+    return trace.heapSize > 0;
+  }
+
+  uint32_t BlockSize(uint32_t requested) {
+    return (requested + Allocator::HeaderSize + Allocator::Alignment - 1) & ~(Allocator::Alignment - 1);
+  }
+
+  // Runs a workload on the heap_4 model and records what the firmware would trace
+  class Recorder {
+  public:
+    Recorder(const char* name, uint32_t heapSize) : heap {heapSize, FreeListAllocator::Fit::First} {
+      trace.name = name;
+      trace.heapSize = heapSize;
+    }
+
+    // Returns the offset of the block, or -1 if the allocation failed
+    int Allocate(uint32_t requested, const char* task, uint32_t caller) {
+      uint32_t size = BlockSize(requested);
+      auto offset = heap.Allocate(size);
+      if (!offset) {
+        Add(Trace::Operation::FailedAllocation, 0xffff, size, task, caller);
+        return -1;
+      }
+      Add(Trace::Operation::Allocation, *offset, heap.BlockSize(*offset), task, caller);
+      return static_cast<int>(*offset);
+    }
+
+    void Free(int offset, const char* task, uint32_t caller) {
+      if (offset < 0) {
+        return;
+      }
+      Add(Trace::Operation::Free, static_cast<uint32_t>(offset), heap.BlockSize(static_cast<uint32_t>(offset)), task, caller);
+      heap.Free(static_cast<uint32_t>(offset));
+    }
+
+    Trace trace;
+
+  private:
+    FreeListAllocator heap;
+
+    void Add(Trace::Operation operation, uint32_t offset, uint32_t size, const char* task, uint32_t caller) {
+      Trace::Record record {static_cast<uint32_t>(trace.records.size()), caller, static_cast<uint16_t>(offset), static_cast<uint16_t>(size), {}, operation};
+      // record.task is zeroed: the name stays null terminated
+      std::memcpy(record.task, task, std::min(std::strlen(task), sizeof(record.task) - 1));
+      trace.records.push_back(record);
+    }
+  };
+
+  // Boot (task stacks, queues, timers), then the user opens apps one after the other. Every app allocates its screen
+  // and a few small objects, and the notifications received in the meantime stay allocated for a while.
+  Trace AppSwitches(const char* name, uint32_t heapSize, uint32_t maxScreenSize, uint32_t seed) {
+    constexpr uint32_t screenCaller = 0x0002a3c4;
+    constexpr uint32_t objectCaller = 0x0002a3e8;
+    constexpr uint32_t notificationCaller = 0x0003152c;
+    std::mt19937 generator {seed};
+    std::uniform_int_distribution<uint32_t> screenSize {120, maxScreenSize};
+    std::uniform_int_distribution<uint32_t> objectSize {4, 56};
+    std::uniform_int_distribution<int> nbObjects {1, 6};
+    std::uniform_int_distribution<uint32_t> notificationSize {40, 240};
+    std::uniform_int_distribution<int> percent {0, 99};
+
+    Recorder recorder {name, heapSize};
+    for (uint32_t stackWords : {350U, 800U, 1024U, 500U, 200U}) {
+      recorder.Allocate(stackWords * 4, "", 0x00012f50);
+      recorder.Allocate(92, "", 0x00012f50);
+    }
+    for (uint32_t queueSize : {64U, 40U, 40U, 80U, 44U, 44U}) {
+      recorder.Allocate(queueSize, "", 0x00013a10);
+    }
+
+    std::vector<int> notifications;
+    int screen = -1;
+    std::vector<int> objects;
+    for (int app = 0; app < 400; app++) {
+      recorder.Free(screen, "dis", screenCaller);
+      for (int object : objects) {
+        recorder.Free(object, "dis", objectCaller);
+      }
+      objects.clear();
+
+      screen = recorder.Allocate(screenSize(generator), "dis", screenCaller);
+      for (int i = nbObjects(generator); i > 0; i--) {
+        objects.push_back(recorder.Allocate(objectSize(generator), "dis", objectCaller));
+      }
+      if (percent(generator) < 20) {
+        notifications.push_back(recorder.Allocate(notificationSize(generator), "sys", notificationCaller));
+      }
+      if (notifications.size() > 5 || (!notifications.empty() && percent(generator) < 10)) {
+        recorder.Free(notifications.front(), "sys", notificationCaller);
+        notifications.erase(notifications.begin());
+      }
+    }
+    return std::move(recorder.trace);
+  }
+}
+
+bool Trace::IsComplete() const {
+  return nbMissing == 0;
+}
+
+bool Pinetime::HeapReplay::LoadTrace(const char* path, Trace& trace) {
+  bool isBinary = EndsWith(path, ".bin");
+  FILE* file = std::fopen(path, isBinary ? "rb" : "r");
+  if (file == nullptr) {
+    return false;
+  }
+  trace.name = path;
+  std::map<uint32_t, Trace::Record> records;
+  bool isLoaded = isBinary ? LoadBinary(file, records, trace) : LoadCsv(file, records, trace);
+  std::fclose(file);
+
+  uint32_t expected = 0;
+  for (const auto& [sequence, record] : records) {
+    trace.nbMissing += sequence - expected;
+    trace.records.push_back(record);
+    expected = sequence + 1;
+  }
+  return isLoaded;
+}
+
+std::vector<Trace> Pinetime::HeapReplay::SyntheticTraces() {
+  return {
+    AppSwitches("apps 24KB", 24 * 1024, 1200, 1),
+    AppSwitches("apps 16KB", 16 * 1024, 1200, 2),
+    AppSwitches("large screens 16KB", 16 * 1024, 3000, 3),
+  };
+}
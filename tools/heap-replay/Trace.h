@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Pinetime {
+  namespace HeapReplay {
+    // Allocation trace of heap_4_infinitime.c, see the heap trace characteristic in doc/ProfilingService.md
+    struct Trace {
+      enum class Operation : uint8_t { Allocation = 0, Free = 1, FailedAllocation = 2 };
+
+      struct Record {
+        uint32_t sequence;
+        uint32_t caller;
+        uint16_t offset; // 0xffff for failed allocations
+        uint16_t size;   // Block size, header included
+        char task[4];
+        Operation operation;
+      };
+
+      std::string name;
+      uint32_t heapSize = 0;
+      std::vector<Record> records; // Sorted by sequence number, without duplicates
+      uint32_t nbMissing = 0;      // Records overwritten on the watch before being read
+
+      bool IsComplete() const;
+    };
+
+    // .bin files contain the values read from the heap trace characteristic, each one preceded by its length as a
+    // little endian uint16_t. CSV files contain one "sequence,operation,offset,size,task,caller" record per line, after a
+    // "heap,<size>" line; lines not starting with a digit or "heap" are ignored.
+    bool LoadTrace(const char* path, Trace& trace);
+    std::vector<Trace> SyntheticTraces();
+  }
+}
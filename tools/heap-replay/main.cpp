@@ -0,0 +1,191 @@
+// Replays allocation traces of the FreeRTOS heap against models of heap_4 and of other allocators, and compares their
+// failed allocations and fragmentation. See README.md.
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <vector>
+#include "Allocators.h"
+#include "Trace.h"
+
+using Pinetime::HeapReplay::Allocator;
+using Pinetime::HeapReplay::Trace;
+
+namespace {
+  struct Results {
+    uint32_t nbAllocations = 0;
+    uint32_t nbFailures = 0;
+    uint32_t nbServed = 0; // Allocations that failed on the watch but not in the model
+    uint32_t minLargestFreeBlock = UINT32_MAX;
+    float maxFragmentation = 0.0f;
+    float endFragmentation = 0.0f;
+    uint32_t nbMismatches = 0; // Offsets different from the trace
+  };
+
+  float Fragmentation(const Allocator& allocator) {
+    uint32_t freeBytes = allocator.FreeBytes();
+    return freeBytes > 0 ? 1.0f - static_cast<float>(allocator.LargestFreeBlock()) / static_cast<float>(freeBytes) : 0.0f;
+  }
+
+  // Blocks freed by the trace that were allocated before its first record
+  std::vector<Trace::Record> AllocatedBefore(const Trace& trace) {
+    std::set<uint16_t> live;
+    std::map<uint16_t, Trace::Record> before;
+    for (const auto& record : trace.records) {
+      if (record.operation == Trace::Operation::Allocation) {
+        live.insert(record.offset);
+      } else if (record.operation == Trace::Operation::Free && live.erase(record.offset) == 0) {
+        before.emplace(record.offset, record);
+      }
+    }
+    std::vector<Trace::Record> blocks;
+    for (const auto& [offset, record] : before) {
+      blocks.push_back(record);
+    }
+    return blocks;
+  }
+
+  Results Replay(const Trace& trace, const std::vector<Trace::Record>& before, Allocator& allocator, bool checkOffsets) {
+    Results results;
+    std::map<uint16_t, uint32_t> blocks; // Offset in the trace -> offset in the model
+    auto update = [&]() {
+      results.minLargestFreeBlock = std::min(results.minLargestFreeBlock, allocator.LargestFreeBlock());
+      results.maxFragmentation = std::max(results.maxFragmentation, Fragmentation(allocator));
+    };
+
+    for (const auto& record : before) {
+      auto offset = allocator.Allocate(record.size);
+      if (offset) {
+        blocks[record.offset] = *offset;
+      }
+    }
+    for (const auto& record : trace.records) {
+      switch (record.operation) {
+        case Trace::Operation::Allocation: {
+          results.nbAllocations++;
+          auto offset = allocator.Allocate(record.size);
+          if (!offset) {
+            results.nbFailures++;
+            break;
+          }
+          blocks[record.offset] = *offset;
+          results.nbMismatches += checkOffsets && *offset != record.offset;
+          break;
+        }
+        case Trace::Operation::FailedAllocation: {
+          // The firmware never used the block, it is freed right away
+          results.nbAllocations++;
+          auto offset = allocator.Allocate(record.size);
+          if (!offset) {
+            results.nbFailures++;
+            break;
+          }
+          results.nbServed++;
+          results.nbMismatches += checkOffsets;
+          allocator.Free(*offset);
+          break;
+        }
+        case Trace::Operation::Free: {
+          auto block = blocks.find(record.offset);
+          if (block != blocks.end()) {
+            allocator.Free(block->second);
+            blocks.erase(block);
+          }
+          break;
+        }
+      }
+      update();
+    }
+    results.endFragmentation = Fragmentation(allocator);
+    return results;
+  }
+
+  void PrintFailures(const Trace& trace) {
+    struct Failure {
+      char task[4];
+      uint32_t count;
+      uint16_t maxSize;
+    };
+    std::map<uint32_t, Failure> failures;
+    for (const auto& record : trace.records) {
+      if (record.operation != Trace::Operation::FailedAllocation) {
+        continue;
+      }
+      auto& failure = failures.try_emplace(record.caller, Failure {{}, 0, 0}).first->second;
+      std::copy(std::begin(record.task), std::end(record.task), std::begin(failure.task));
+      failure.count++;
+      failure.maxSize = std::max(failure.maxSize, record.size);
+    }
+    for (const auto& [caller, failure] : failures) {
+      std::printf("    failed on the watch: caller 0x%08x, task %-3s, %u times, up to %u bytes\n",
+                  caller,
+                  failure.task,
+                  failure.count,
+                  failure.maxSize);
+    }
+  }
+
+  void Usage(const char* program) {
+    std::fprintf(stderr, "Usage: %s [trace.bin|trace.csv...]\n", program);
+  }
+}
+
+int main(int argc, char** argv) {
+  std::vector<Trace> traces;
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] == '-') {
+      Usage(argv[0]);
+      return 1;
+    }
+    Trace trace;
+    if (!Pinetime::HeapReplay::LoadTrace(argv[i], trace)) {
+      std::fprintf(stderr, "Cannot load %s\n", argv[i]);
+      return 1;
+    }
+    traces.push_back(std::move(trace));
+  }
+  if (traces.empty()) {
+    traces = Pinetime::HeapReplay::SyntheticTraces();
+  }
+
+  bool isModelValid = true;
+  for (const auto& trace : traces) {
+    auto before = AllocatedBefore(trace);
+    std::printf("%s: heap %u bytes, %zu records, %u missing, %zu blocks allocated before the first record\n",
+                trace.name.c_str(),
+                trace.heapSize,
+                trace.records.size(),
+                trace.nbMissing,
+                before.size());
+    PrintFailures(trace);
+    std::printf("    %-20s %7s %7s %7s %8s %8s %8s %10s\n", "allocator", "allocs", "failed", "served", "min lfb", "max frg%", "end frg%", "mismatches");
+
+    auto allocators = Pinetime::HeapReplay::CreateAllocators(trace.heapSize);
+    for (size_t i = 0; i < allocators.size(); i++) {
+      // Only a complete trace replays the state of the heap of the watch
+      bool checkOffsets = i == 0 && trace.IsComplete();
+      Results results = Replay(trace, before, *allocators[i], checkOffsets);
+      char mismatches[16] = "-";
+      if (checkOffsets) {
+        std::snprintf(mismatches, sizeof(mismatches), "%u", results.nbMismatches);
+        isModelValid = isModelValid && results.nbMismatches == 0;
+      }
+      std::printf("    %-20s %7u %7u %7u %8u %8.1f %8.1f %10s\n",
+                  allocators[i]->Name(),
+                  results.nbAllocations,
+                  results.nbFailures,
+                  results.nbServed,
+                  results.minLargestFreeBlock,
+                  results.maxFragmentation * 100.0f,
+                  results.endFragmentation * 100.0f,
+                  mismatches);
+    }
+  }
+
+  if (!isModelValid) {
+    std::printf("\nThe heap_4 model doesn't match a complete trace\n");
+    return 1;
+  }
+  return 0;
+}
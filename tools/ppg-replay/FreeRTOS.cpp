@@ -0,0 +1,78 @@
+#include "FreeRTOS.h"
+#include <cstring>
+#include "queue.h"
+#include "task.h"
+
+using Pinetime::PpgReplay::Scheduler;
+
+Scheduler& Scheduler::Instance() {
+  static Scheduler scheduler;
+  return scheduler;
+}
+
+void Scheduler::Reset(TickType_t duration) {
+  now = 0;
+  end = duration;
+  events.clear();
+}
+
+void Scheduler::At(TickType_t tick, std::function<void()> action) {
+  events.emplace(tick, std::move(action));
+}
+
+void Scheduler::Advance(TickType_t tick) {
+  if (tick >= end) {
+    now = end;
+    throw End {};
+  }
+  now = std::max(now, tick);
+}
+
+void Scheduler::Delay(TickType_t ticks) {
+  Advance(now + ticks);
+}
+
+bool Scheduler::Receive(QueueHandle_t queue, void* item, TickType_t timeout) {
+  TickType_t deadline = timeout == portMAX_DELAY ? end : now + timeout;
+  while (queue->items.empty()) {
+    if (events.empty() || events.begin()->first > deadline) {
+      Advance(deadline);
+      return false;
+    }
+    auto event = events.extract(events.begin());
+    Advance(event.key());
+    event.mapped()();
+  }
+  std::memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  return true;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t, const char*, uint16_t, void*, UBaseType_t, TaskHandle_t* handle) {
+  // The simulation runs the task function itself
+  *handle = nullptr;
+  return pdPASS;
+}
+
+TickType_t xTaskGetTickCount() {
+  return Scheduler::Instance().Now();
+}
+
+void vTaskDelay(TickType_t ticks) {
+  Scheduler::Instance().Delay(ticks);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t, UBaseType_t itemSize) {
+  return new QueueDefinition {itemSize, {}};
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout) {
+  return Scheduler::Instance().Receive(queue, item, timeout) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken) {
+  const auto* bytes = static_cast<const uint8_t*>(item);
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  *higherPriorityTaskWoken = pdFALSE;
+  return pdPASS;
+}
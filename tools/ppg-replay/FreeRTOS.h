@@ -0,0 +1,65 @@
+#pragma once
+// Host stand-in for the FreeRTOS API used by HeartRateTask.
+// Time only advances when the task blocks: the simulation is driven by the events scheduled with Scheduler::At().
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+using TickType_t = uint32_t;
+using BaseType_t = long;
+using UBaseType_t = unsigned long;
+using TaskFunction_t = void (*)(void*);
+using TaskHandle_t = void*;
+
+struct QueueDefinition {
+  size_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+using QueueHandle_t = QueueDefinition*;
+
+#define configTICK_RATE_HZ 1024
+#define portMAX_DELAY static_cast<TickType_t>(0xffffffffUL)
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define portYIELD_FROM_ISR(x) static_cast<void>(x)
+#define NRF_ERROR_NO_MEM 4
+#define APP_ERROR_HANDLER(error) throw Pinetime::PpgReplay::Scheduler::Error {error}
+
+namespace Pinetime {
+  namespace PpgReplay {
+    class Scheduler {
+    public:
+      // Thrown by the blocking calls once the simulation duration has elapsed
+      struct End {};
+
+      struct Error {
+        int code;
+      };
+
+      static Scheduler& Instance();
+
+      void Reset(TickType_t duration);
+      // Runs action when the simulated time reaches tick
+      void At(TickType_t tick, std::function<void()> action);
+
+      TickType_t Now() const {
+        return now;
+      }
+
+      void Delay(TickType_t ticks);
+      bool Receive(QueueHandle_t queue, void* item, TickType_t timeout);
+
+    private:
+      void Advance(TickType_t tick);
+
+      TickType_t now = 0;
+      TickType_t end = 0;
+      std::multimap<TickType_t, std::function<void()>> events;
+    };
+  }
+}
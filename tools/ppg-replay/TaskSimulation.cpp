@@ -0,0 +1,71 @@
+#include "TaskSimulation.h"
+#include <algorithm>
+#include <cstdlib>
+#include "components/heartrate/HeartRateController.h"
+#include "components/settings/Settings.h"
+#include "drivers/Hrs3300.h"
+#include "heartratetask/HeartRateTask.h"
+
+using namespace Pinetime::PpgReplay;
+using Pinetime::Applications::HeartRateTask;
+
+namespace {
+  constexpr uint32_t TicksToMs(TickType_t ticks) {
+    return static_cast<uint32_t>(static_cast<uint64_t>(ticks) * 1000 / configTICK_RATE_HZ);
+  }
+
+  constexpr TickType_t SecondsToTicks(uint32_t seconds) {
+    return seconds * configTICK_RATE_HZ;
+  }
+}
+
+TaskResults Pinetime::PpgReplay::SimulateTask(const Trace& trace, const TaskScenario& scenario) {
+  auto& scheduler = Scheduler::Instance();
+  scheduler.Reset(SecondsToTicks(scenario.durationSeconds));
+
+  Drivers::Hrs3300 sensor {trace};
+  Controllers::HeartRateController controller;
+  Controllers::Settings settings;
+  settings.SetHeartRateBackgroundMeasurementInterval(scenario.backgroundIntervalSeconds);
+  HeartRateTask task {sensor, controller, settings};
+  task.Start();
+
+  TaskResults results;
+  uint32_t lastSuccessfulMeasurement = 0;
+  controller.SetObserver([&](Controllers::HeartRateController::States, uint8_t heartRate) {
+    if (heartRate == 0) {
+      return;
+    }
+    results.readings++;
+    if (sensor.LastSample().bpm != 0) {
+      results.referenceReadings++;
+      results.sumError += static_cast<uint32_t>(std::abs(heartRate - sensor.LastSample().bpm));
+    }
+    if (lastSuccessfulMeasurement != sensor.NbEnables()) {
+      lastSuccessfulMeasurement = sensor.NbEnables();
+      uint32_t firstReadingMs = TicksToMs(scheduler.Now() - sensor.EnableTime());
+      results.successfulMeasurements++;
+      results.sumFirstReadingMs += firstReadingMs;
+      results.maxFirstReadingMs = std::max(results.maxFirstReadingMs, firstReadingMs);
+    }
+  });
+
+  scheduler.At(SecondsToTicks(1), [&controller]() {
+    controller.Enable();
+  });
+  scheduler.At(SecondsToTicks(scenario.foregroundSeconds), [&task]() {
+    task.PushMessage(HeartRateTask::Messages::GoToSleep);
+  });
+  scheduler.At(SecondsToTicks(scenario.durationSeconds - scenario.foregroundSeconds), [&task]() {
+    task.PushMessage(HeartRateTask::Messages::WakeUp);
+  });
+
+  try {
+    task.Work();
+  } catch (const Scheduler::End&) {
+  }
+
+  results.sensorOnMs = TicksToMs(sensor.EnabledTicks());
+  results.measurements = sensor.NbEnables();
+  return results;
+}
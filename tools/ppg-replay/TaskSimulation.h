@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include "Trace.h"
+
+namespace Pinetime {
+  namespace PpgReplay {
+    // Runs the actual HeartRateTask on a simulated clock, with the trace as sensor data:
+    // the user enables the heart rate measurement with the screen on, turns the screen off after
+    // foregroundSeconds and back on foregroundSeconds before the end of the simulation.
+    struct TaskScenario {
+      uint32_t durationSeconds = 60 * 60;
+      uint32_t foregroundSeconds = 120;
+      std::optional<uint16_t> backgroundIntervalSeconds = 10 * 60;
+    };
+
+    struct TaskResults {
+      uint32_t sensorOnMs = 0;
+      uint32_t measurements = 0; // Number of times the sensor was enabled
+      uint32_t successfulMeasurements = 0;
+      uint32_t sumFirstReadingMs = 0;
+      uint32_t maxFirstReadingMs = 0;
+      uint32_t readings = 0;
+      uint32_t referenceReadings = 0; // Readings for which the trace had a reference heart rate
+      uint32_t sumError = 0;
+    };
+
+    TaskResults SimulateTask(const Trace& trace, const TaskScenario& scenario);
+  }
+}
@@ -0,0 +1,97 @@
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "components/heartrate/Ppg.h"
+
+using namespace Pinetime::PpgReplay;
+
+namespace {
+  bool EndsWith(const char* string, const char* suffix) {
+    size_t length = std::strlen(string);
+    size_t suffixLength = std::strlen(suffix);
+    return length >= suffixLength && std::strcmp(string + length - suffixLength, suffix) == 0;
+  }
+
+  void LoadCsv(FILE* file, Trace& trace) {
+    char line[128];
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+      unsigned hrs;
+      unsigned als;
+      unsigned bpm = 0;
+      if (line[0] >= '0' && line[0] <= '9' && std::sscanf(line, "%u,%u,%u", &hrs, &als, &bpm) >= 2) {
+        trace.samples.push_back({static_cast<uint16_t>(hrs), static_cast<uint16_t>(als), static_cast<uint16_t>(bpm)});
+      }
+    }
+  }
+
+  void LoadBinary(FILE* file, Trace& trace) {
+    uint8_t sample[4];
+    while (std::fread(sample, sizeof(sample), 1, file) == 1) {
+      trace.samples.push_back({static_cast<uint16_t>(sample[0] | (sample[1] << 8)), static_cast<uint16_t>(sample[2] | (sample[3] << 8)), 0});
+    }
+  }
+
+  // Pulse wave with a dicrotic notch on top of a drifting DC level, with sensor noise.
+  // bpm == 0 generates noise only.
+  Trace SyntheticTrace(const char* name, float bpm, float amplitude, float noise, uint32_t seed) {
+    constexpr int nbSamples = 600; // 1 minute
+    constexpr float pi = 3.14159265f;
+    constexpr float deltaT = static_cast<float>(Pinetime::Controllers::Ppg::deltaTms) / 1000.0f;
+    std::mt19937 generator {seed};
+    std::normal_distribution<float> gaussian {0.0f, noise};
+    std::uniform_real_distribution<float> jitter {-0.03f, 0.03f};
+    Trace trace {name, {}};
+    float phase = 0.0f;
+    for (int idx = 0; idx < nbSamples; idx++) {
+      float t = static_cast<float>(idx) * deltaT;
+      float dc = 12000.0f + 60.0f * std::sin(2 * pi * t / 45.0f) + 0.5f * t;
+      float pulse = 0.0f;
+      if (bpm > 0.0f) {
+        // Heart rate variability
+        phase += 2 * pi * (bpm / 60.0f) * (1.0f + jitter(generator)) * deltaT;
+        pulse = amplitude * (std::sin(phase) + 0.2f * std::sin(2 * phase + 0.8f) + 0.05f * std::sin(3 * phase + 1.5f));
+      }
+      trace.samples.push_back({static_cast<uint16_t>(std::lround(dc + pulse + gaussian(generator))), 50, static_cast<uint16_t>(bpm)});
+    }
+    return trace;
+  }
+}
+
+bool Trace::HasReference() const {
+  return std::any_of(samples.begin(), samples.end(), [](const Sample& sample) {
+    return sample.bpm != 0;
+  });
+}
+
+bool Pinetime::PpgReplay::LoadTrace(const char* path, Trace& trace) {
+  bool binary = EndsWith(path, ".bin");
+  FILE* file = std::fopen(path, binary ? "rb" : "r");
+  if (file == nullptr) {
+    std::fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+  trace.name = path;
+  if (binary) {
+    LoadBinary(file, trace);
+  } else {
+    LoadCsv(file, trace);
+  }
+  std::fclose(file);
+  return true;
+}
+
+std::vector<Trace> Pinetime::PpgReplay::SyntheticTraces() {
+  return {
+    SyntheticTrace("synthetic 50bpm", 50, 30, 4, 1),
+    SyntheticTrace("synthetic 65bpm", 65, 25, 3, 2),
+    SyntheticTrace("synthetic 80bpm", 80, 35, 5, 3),
+    SyntheticTrace("synthetic 95bpm weak", 95, 8, 3, 4),
+    SyntheticTrace("synthetic 120bpm", 120, 30, 4, 5),
+    SyntheticTrace("synthetic 150bpm", 150, 25, 4, 6),
+    SyntheticTrace("synthetic 180bpm", 180, 20, 3, 7),
+    SyntheticTrace("synthetic noise", 0, 0, 8, 8),
+  };
+}
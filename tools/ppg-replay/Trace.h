@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Pinetime {
+  namespace PpgReplay {
+    // Samples of Hrs3300::ReadHrsAls(), one every Ppg::deltaTms
+    struct Trace {
+      struct Sample {
+        uint16_t hrs;
+        uint16_t als;
+        uint16_t bpm; // Reference heart rate, 0 if unknown
+      };
+
+      std::string name;
+      std::vector<Sample> samples;
+
+      bool HasReference() const;
+    };
+
+    // CSV files contain one "hrs,als[,bpm]" sample per line, lines not starting with a digit are ignored.
+    // .bin files contain the raw PackedHrsAls structures (little endian uint16_t hrs, uint16_t als).
+    bool LoadTrace(const char* path, Trace& trace);
+    std::vector<Trace> SyntheticTraces();
+  }
+}
@@ -0,0 +1,34 @@
+#include "components/heartrate/HeartRateController.h"
+#include "heartratetask/HeartRateTask.h"
+
+using namespace Pinetime::Controllers;
+
+void HeartRateController::Update(HeartRateController::States newState, uint8_t heartRate) {
+  state = newState;
+  this->heartRate = heartRate;
+  if (observer) {
+    observer(newState, heartRate);
+  }
+}
+
+void HeartRateController::Enable() {
+  if (task != nullptr) {
+    state = States::NotEnoughData;
+    task->PushMessage(Pinetime::Applications::HeartRateTask::Messages::Enable);
+  }
+}
+
+void HeartRateController::Disable() {
+  if (task != nullptr) {
+    state = States::Stopped;
+    task->PushMessage(Pinetime::Applications::HeartRateTask::Messages::Disable);
+  }
+}
+
+void HeartRateController::SetHeartRateTask(Pinetime::Applications::HeartRateTask* task) {
+  this->task = task;
+}
+
+void HeartRateController::SetObserver(Observer observer) {
+  this->observer = std::move(observer);
+}
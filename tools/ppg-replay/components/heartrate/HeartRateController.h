@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+namespace Pinetime {
+  namespace Applications {
+    class HeartRateTask;
+  }
+
+  namespace Controllers {
+    // Stand-in for the heart rate controller forwarding the updates of HeartRateTask to the simulation
+    class HeartRateController {
+    public:
+      enum class States : uint8_t { Stopped, NotEnoughData, NoTouch, Running };
+      using Observer = std::function<void(States state, uint8_t heartRate)>;
+
+      HeartRateController() = default;
+      void Enable();
+      void Disable();
+      void Update(States newState, uint8_t heartRate);
+
+      void SetHeartRateTask(Applications::HeartRateTask* task);
+      void SetObserver(Observer observer);
+
+      States State() const {
+        return state;
+      }
+
+      uint8_t HeartRate() const {
+        return heartRate;
+      }
+
+    private:
+      Applications::HeartRateTask* task = nullptr;
+      States state = States::Stopped;
+      uint8_t heartRate = 0;
+      Observer observer;
+    };
+  }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+
+namespace Pinetime {
+  namespace Controllers {
+    // Stand-in for the settings controller, limited to what HeartRateTask uses
+    class Settings {
+    public:
+      std::optional<uint16_t> GetHeartRateBackgroundMeasurementInterval() const {
+        return heartRateBackgroundPeriod;
+      }
+
+      void SetHeartRateBackgroundMeasurementInterval(std::optional<uint16_t> newIntervalInSeconds) {
+        heartRateBackgroundPeriod = newIntervalInSeconds;
+      }
+
+    private:
+      std::optional<uint16_t> heartRateBackgroundPeriod;
+    };
+  }
+}
@@ -0,0 +1,39 @@
+#include "drivers/Hrs3300.h"
+
+using namespace Pinetime::Drivers;
+
+Hrs3300::Hrs3300(const PpgReplay::Trace& trace) : trace {trace} {
+}
+
+void Hrs3300::Enable() {
+  if (!enabled) {
+    enabled = true;
+    enableTime = PpgReplay::Scheduler::Instance().Now();
+    nbEnables++;
+  }
+}
+
+void Hrs3300::Disable() {
+  if (enabled) {
+    enabled = false;
+    enabledTicks += PpgReplay::Scheduler::Instance().Now() - enableTime;
+  }
+}
+
+Hrs3300::PackedHrsAls Hrs3300::ReadHrsAls() {
+  last = position;
+  position = (position + 1) % trace.samples.size();
+  const auto& sample = trace.samples[last];
+  return {sample.hrs, sample.als};
+}
+
+TickType_t Hrs3300::EnabledTicks() const {
+  if (enabled) {
+    return enabledTicks + PpgReplay::Scheduler::Instance().Now() - enableTime;
+  }
+  return enabledTicks;
+}
+
+const Pinetime::PpgReplay::Trace::Sample& Hrs3300::LastSample() const {
+  return trace.samples[last];
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <FreeRTOS.h>
+#include "Trace.h"
+
+namespace Pinetime {
+  namespace Drivers {
+    // Stand-in for the HRS3300 driver returning the samples of a trace, looping at its end.
+    // Keeps track of the time the sensor spends enabled.
+    class Hrs3300 {
+    public:
+      struct PackedHrsAls {
+        uint16_t hrs;
+        uint16_t als;
+      };
+
+      explicit Hrs3300(const PpgReplay::Trace& trace);
+      Hrs3300(const Hrs3300&) = delete;
+      Hrs3300& operator=(const Hrs3300&) = delete;
+      Hrs3300(Hrs3300&&) = delete;
+      Hrs3300& operator=(Hrs3300&&) = delete;
+
+      void Enable();
+      void Disable();
+      PackedHrsAls ReadHrsAls();
+
+      bool IsEnabled() const {
+        return enabled;
+      }
+
+      TickType_t EnabledTicks() const;
+
+      // Time of the last call to Enable() while disabled
+      TickType_t EnableTime() const {
+        return enableTime;
+      }
+
+      uint32_t NbEnables() const {
+        return nbEnables;
+      }
+
+      // Sample returned by the last call to ReadHrsAls()
+      const PpgReplay::Trace::Sample& LastSample() const;
+
+    private:
+      const PpgReplay::Trace& trace;
+      size_t position = 0;
+      size_t last = 0;
+      bool enabled = false;
+      TickType_t enableTime = 0;
+      TickType_t enabledTicks = 0;
+      uint32_t nbEnables = 0;
+    };
+  }
+}
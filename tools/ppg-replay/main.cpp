@@ -0,0 +1,220 @@
+// Replays HRS3300 traces through the fixed point Ppg and the former floating point implementation, compares
+// the heart rates they report with each other and with the reference values of the traces, and runs HeartRateTask
+// on a simulated clock. See README.md.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "components/heartrate/Ppg.h"
+#include "ReferencePpg.h"
+#include "TaskSimulation.h"
+#include "Trace.h"
+
+using Pinetime::Controllers::Ppg;
+using Pinetime::PpgReplay::ReferencePpg;
+using Pinetime::PpgReplay::TaskResults;
+using Pinetime::PpgReplay::TaskScenario;
+using Pinetime::PpgReplay::Trace;
+
+namespace {
+  struct Replay {
+    std::vector<int> shown; // Heart rate shown after each sample, 0 if none
+    double totalCallUs = 0.0;
+    double maxCallUs = 0.0;
+  };
+
+  // Mirrors HeartRateTask::HandleSensorData()
+  template <typename T>
+  Replay Run(const Trace& trace) {
+    using Clock = std::chrono::steady_clock;
+    T ppg;
+    ppg.Reset(true);
+    Replay replay;
+    int value = 0;
+    for (const auto& sample : trace.samples) {
+      auto start = Clock::now();
+      int8_t ambient = ppg.Preprocess(sample.hrs, sample.als);
+      int bpm = ppg.HeartRate();
+      double callUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+      replay.totalCallUs += callUs;
+      replay.maxCallUs = std::max(replay.maxCallUs, callUs);
+      if (ambient > 0) {
+        ppg.Reset(true);
+        bpm = 0;
+        value = 0;
+      }
+      if (bpm == -1) {
+        ppg.Reset(false);
+        value = 0;
+      } else if (bpm > 0) {
+        value = bpm;
+      }
+      replay.shown.push_back(value);
+    }
+    return replay;
+  }
+
+  struct Comparison {
+    int readings = 0;
+    int common = 0;
+    int mismatches = 0; // Only one of the two shows a value
+    int sumError = 0;
+    int maxError = 0;
+  };
+
+  Comparison Compare(const std::vector<int>& shown, const std::vector<int>& reference) {
+    Comparison result;
+    for (size_t idx = 0; idx < shown.size(); idx++) {
+      result.readings += shown[idx] > 0;
+      if (shown[idx] > 0 && reference[idx] > 0) {
+        int error = std::abs(shown[idx] - reference[idx]);
+        result.common++;
+        result.sumError += error;
+        result.maxError = std::max(result.maxError, error);
+      } else if ((shown[idx] > 0) != (reference[idx] > 0)) {
+        result.mismatches++;
+      }
+    }
+    return result;
+  }
+
+  std::vector<int> ReferenceValues(const Trace& trace) {
+    std::vector<int> values;
+    for (const auto& sample : trace.samples) {
+      values.push_back(sample.bpm);
+    }
+    return values;
+  }
+
+  std::string Format(double value) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%.2f", value);
+    return text;
+  }
+
+  std::string Average(double sum, uint32_t count) {
+    if (count == 0) {
+      return "-";
+    }
+    return Format(sum / count);
+  }
+
+  // Time (seconds) before the first reading is shown
+  std::string FirstReading(const std::vector<int>& shown) {
+    auto first = std::find_if(shown.begin(), shown.end(), [](int value) {
+      return value > 0;
+    });
+    if (first == shown.end()) {
+      return "-";
+    }
+    return Format(static_cast<double>((std::distance(shown.begin(), first) + 1) * Ppg::deltaTms) / 1000.0);
+  }
+
+  void PrintUsage(const char* program) {
+    std::fprintf(stderr, "Usage: %s [--background <seconds>|off] [trace.csv|trace.bin...]\n", program);
+  }
+}
+
+int main(int argc, char** argv) {
+  TaskScenario scenario;
+  std::vector<Trace> traces;
+  for (int idx = 1; idx < argc; idx++) {
+    if (std::strcmp(argv[idx], "--background") == 0 && idx + 1 < argc) {
+      idx++;
+      if (std::strcmp(argv[idx], "off") == 0) {
+        scenario.backgroundIntervalSeconds.reset();
+      } else {
+        scenario.backgroundIntervalSeconds = static_cast<uint16_t>(std::atoi(argv[idx]));
+      }
+      continue;
+    }
+    if (argv[idx][0] == '-') {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+    Trace trace;
+    if (!LoadTrace(argv[idx], trace)) {
+      return 1;
+    }
+    traces.push_back(std::move(trace));
+  }
+  if (traces.empty()) {
+    traces = Pinetime::PpgReplay::SyntheticTraces();
+  }
+
+  // Maximum difference (BPM) tolerated between the two implementations
+  constexpr int tolerance = 2;
+  bool success = true;
+
+  std::printf("Ppg against the floating point implementation (ref) and the reference values of the traces\n");
+  std::printf("%-24s %7s %6s %6s %6s %6s %6s %6s %6s %6s %6s %7s %7s %7s\n",
+              "trace",
+              "samples",
+              "shown",
+              "ref",
+              "mism.",
+              "avg d",
+              "max d",
+              "err",
+              "ref er",
+              "1st s",
+              "ref 1s",
+              "us/call",
+              "us max",
+              "ref us");
+  for (const auto& trace : traces) {
+    auto replay = Run<Ppg>(trace);
+    auto reference = Run<ReferencePpg>(trace);
+    auto truth = ReferenceValues(trace);
+    auto difference = Compare(replay.shown, reference.shown);
+    auto error = Compare(replay.shown, truth);
+    auto referenceError = Compare(reference.shown, truth);
+    auto nbCalls = static_cast<double>(std::max<size_t>(trace.samples.size(), 1));
+    std::printf("%-24s %7zu %6d %6d %6d %6s %6d %6s %6s %6s %6s %7.2f %7.2f %7.2f\n",
+                trace.name.c_str(),
+                trace.samples.size(),
+                difference.readings,
+                referenceError.readings,
+                difference.mismatches,
+                Average(difference.sumError, difference.common).c_str(),
+                difference.maxError,
+                Average(error.sumError, error.common).c_str(),
+                Average(referenceError.sumError, referenceError.common).c_str(),
+                FirstReading(replay.shown).c_str(),
+                FirstReading(reference.shown).c_str(),
+                replay.totalCallUs / nbCalls,
+                replay.maxCallUs,
+                reference.totalCallUs / nbCalls);
+    success &= difference.maxError <= tolerance;
+  }
+
+  std::printf("\nHeartRateTask, %u minutes, screen on for the first and last %u seconds, background measurement ",
+              scenario.durationSeconds / 60,
+              scenario.foregroundSeconds);
+  if (scenario.backgroundIntervalSeconds.has_value()) {
+    std::printf("every %u seconds\n", scenario.backgroundIntervalSeconds.value());
+  } else {
+    std::printf("disabled\n");
+  }
+  std::printf("%-24s %7s %6s %6s %7s %7s %8s %6s\n", "trace", "on %", "meas.", "ok", "1st s", "max 1st", "readings", "err");
+  for (const auto& trace : traces) {
+    if (trace.samples.empty()) {
+      continue;
+    }
+    TaskResults results = SimulateTask(trace, scenario);
+    std::printf("%-24s %7.2f %6u %6u %7s %7.2f %8u %6s\n",
+                trace.name.c_str(),
+                100.0 * results.sensorOnMs / (scenario.durationSeconds * 1000.0),
+                results.measurements,
+                results.successfulMeasurements,
+                Average(results.sumFirstReadingMs / 1000.0, results.successfulMeasurements).c_str(),
+                results.maxFirstReadingMs / 1000.0,
+                results.readings,
+                Average(results.sumError, results.referenceReadings).c_str());
+  }
+  return success ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include "FreeRTOS.h"
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken);
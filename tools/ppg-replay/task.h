@@ -0,0 +1,6 @@
+#pragma once
+#include "FreeRTOS.h"
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint16_t stackDepth, void* parameters, UBaseType_t priority, TaskHandle_t* handle);
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
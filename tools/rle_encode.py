@@ -268,6 +268,69 @@ def encode_8bit(im):
 
     return (im.width, im.height, bytes(rle))
 
+def encode_clut8(im, strip_height):
+    """CLUT8 RLE encoder for full colour images, decoded by Clut8RleDecoder.
+
+    Pixels are mapped to the nearest colour of the wasp-os CLUT and coded
+    as PackBits runs: a control byte below 128 repeats the next index
+    control + 1 times, otherwise control - 127 literal indices follow.
+    Runs stop at the end of every strip of strip_height lines and a table
+    of the offsets of the strips follows the descriptor, so that the
+    decoder can start from any strip.
+    """
+    pixels = im.convert('RGB').load()
+    assert(im.width <= 0xffff)
+    assert(im.height <= 0xffff)
+    assert(0 < strip_height <= 255)
+
+    full_palette = ReverseCLUT(clut8_rgb888)
+
+    def index(x, y):
+        px = pixels[x, y]
+        return full_palette((px[0] << 16) + (px[1] << 8) + px[2])
+
+    def encode_strip(indices):
+        rle = bytearray()
+        literals = bytearray()
+
+        def flush_literals():
+            while literals:
+                chunk = literals[:128]
+                rle.append(127 + len(chunk))
+                rle.extend(chunk)
+                del literals[:128]
+
+        i = 0
+        while i < len(indices):
+            rl = 1
+            while i + rl < len(indices) and rl < 128 and indices[i + rl] == indices[i]:
+                rl += 1
+            # A run of 2 only pays off if it doesn't split literals
+            if rl >= 3 or (rl == 2 and not literals):
+                flush_literals()
+                rle.append(rl - 1)
+                rle.append(indices[i])
+            else:
+                literals.extend(indices[i:i + rl])
+            i += rl
+        flush_literals()
+        return rle
+
+    strips = []
+    for top in range(0, im.height, strip_height):
+        indices = [index(x, y) for y in range(top, min(top + strip_height, im.height)) for x in range(im.width)]
+        strips.append(encode_strip(indices))
+
+    rle = bytearray([8, im.width & 0xff, im.width >> 8, im.height & 0xff, im.height >> 8, strip_height])
+    offset = 0
+    for strip in strips:
+        rle.extend(offset.to_bytes(4, 'little'))
+        offset += len(strip)
+    for strip in strips:
+        rle.extend(strip)
+
+    return bytes(rle)
+
 def render_c(image, fname, indent, depth):
     extra_indent = ' ' * indent
     if len(image) == 3:
@@ -354,9 +417,16 @@ parser.add_argument('--2bit', action='store_true', dest='twobit',
                     help='Generate 2-bit image')
 parser.add_argument('--8bit', action='store_true', dest='eightbit',
                     help='Generate 8-bit image')
+parser.add_argument('--clut8', action='store_true',
+                    help='Generate CLUT8 image with a strip index (Clut8RleDecoder)')
+parser.add_argument('--strip-height', default=4, type=int,
+                    help='Height in lines of the independently decodable strips of CLUT8 images')
 
 args = parser.parse_args()
-if args.eightbit:
+if args.clut8:
+    encoder = lambda im: encode_clut8(im, args.strip_height)
+    depth = 8
+elif args.eightbit:
     encoder = encode_8bit
     depth = 8
 elif args.twobit: